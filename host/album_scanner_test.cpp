@@ -0,0 +1,125 @@
+// AlbumScanner on a synthetic album: screenshots behind a movie that is
+// still being recorded are handed over right away, the movie follows once
+// it has been finalized, and a scan never sleeps on a movie. Movies deleted
+// while pending give up their slot.
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "album_scanner.hpp"
+#include "test_support.hpp"
+
+namespace {
+constexpr u64 SCAN_INTERVAL_NS = 50'000'000ULL;  // 50ms
+constexpr const char* DAY = "img:/2026/10/19/";
+
+std::string be32(uint32_t value) {
+    return {static_cast<char>(value >> 24), static_cast<char>(value >> 16),
+            static_cast<char>(value >> 8), static_cast<char>(value)};
+}
+
+std::string box(const char* type, const std::string& payload) {
+    return be32(static_cast<uint32_t>(8 + payload.size())) + type + payload;
+}
+
+std::string capturePath(const char* name) { return std::string(DAY) + name; }
+
+void writeScreenshot(const char* name) {
+    writeFile(capturePath(name), "\xFF\xD8" + randomBytes(4096) + "\xFF\xD9");
+}
+
+// A recording in progress: ftyp and mdat, but no moov yet
+std::string recordingHead() {
+    return box("ftyp", "isom" + be32(0x200) + "isomiso2") +
+           box("mdat", randomBytes(64 * 1024));
+}
+
+void appendFile(const std::string& path, const std::string& data) {
+    FILE* f = std::fopen(path.c_str(), "ab");
+    std::fwrite(data.data(), 1, data.size(), f);
+    std::fclose(f);
+}
+
+// Next capture within `timeoutMs`, empty path on timeout
+CaptureItem nextCapture(double timeoutMs) {
+    const u64 start = armGetSystemTick();
+    while (msSince(start) < timeoutMs) {
+        if (auto item = AlbumScanner::get().pop()) {
+            return *item;
+        }
+        AlbumScanner::get().wait(10'000'000ULL);
+    }
+    return {};
+}
+}  // namespace
+
+int main() {
+    enterScratchDir("album_scanner_test");
+    writeScreenshot("2026101912000000-A.jpg");
+    CHECK(AlbumScanner::get().start(capturePath("2026101912000000-A.jpg"),
+                                    SCAN_INTERVAL_NS));
+
+    // A movie still being recorded, then two screenshots taken meanwhile
+    const std::string movie = capturePath("2026101912000100-B.mp4");
+    writeFile(movie, recordingHead());
+    writeScreenshot("2026101912000200-C.jpg");
+    writeScreenshot("2026101912000300-D.jpg");
+
+    u64 start = armGetSystemTick();
+    CaptureItem item = nextCapture(1000);
+    CHECK(item.path == capturePath("2026101912000200-C.jpg"));
+    item = nextCapture(1000);
+    CHECK(item.path == capturePath("2026101912000300-D.jpg"));
+    const double screenshotsMs = msSince(start);
+    std::printf("[bench] scan=pending_movie screenshots_ms=%.0f\n",
+                screenshotsMs);
+    // Two scan intervals at most, no waiting on the movie
+    CHECK(screenshotsMs < 300.0);
+
+    // Still growing: the movie must not be handed over
+    appendFile(movie, box("free", randomBytes(1024, 2)));
+    CHECK(nextCapture(400).path.empty());
+
+    // Finalized, handed over once its size stayed put for a while
+    start = armGetSystemTick();
+    appendFile(movie, box("moov", box("mvhd", std::string(100, '\0'))));
+    item = nextCapture(2000);
+    const double movieMs = msSince(start);
+    std::printf("[bench] scan=pending_movie movie_ms=%.0f\n", movieMs);
+    CHECK(item.path == movie);
+    CHECK(item.isMovie);
+    CHECK(item.size == std::filesystem::file_size(movie));
+    CHECK(movieMs >= 300.0 && movieMs < 1000.0);
+
+    // An incomplete screenshot still holds back the captures behind it, so
+    // screenshots keep their album order
+    const std::string partial = capturePath("2026101912000400-E.jpg");
+    writeFile(partial, "\xFF\xD8" + randomBytes(4096));
+    writeScreenshot("2026101912000500-F.jpg");
+    CHECK(nextCapture(300).path.empty());
+    appendFile(partial, "\xFF\xD9");
+    CHECK(nextCapture(1000).path == partial);
+    CHECK(nextCapture(1000).path == capturePath("2026101912000500-F.jpg"));
+
+    // Fill every pending movie slot, then delete those movies
+    std::vector<std::string> deleted;
+    for (size_t i = 0; i < AlbumScanner::MAX_PENDING_MOVIES; ++i) {
+        deleted.push_back(capturePath("20261019120006") +
+                          static_cast<char>('0' + i) + "0-G.mp4");
+        writeFile(deleted.back(), recordingHead());
+    }
+    CHECK(nextCapture(300).path.empty());
+    for (const auto& path : deleted) {
+        std::filesystem::remove(path);
+    }
+    // Another recording is set aside again, so the screenshot behind it
+    // isn't held up
+    writeFile(capturePath("2026101912000700-H.mp4"), recordingHead());
+    writeScreenshot("2026101912000800-I.jpg");
+    CHECK(nextCapture(1000).path == capturePath("2026101912000800-I.jpg"));
+
+    AlbumScanner::get().stop();
+    return testExitCode();
+}
@@ -0,0 +1,175 @@
+// Bandwidth limiter benchmark on loopback: how close throttled uploads
+// get to the configured rate, and whether screenshots keep moving while a
+// throttled movie shares the transfer loop with them. Prints one
+// "[bench] bandwidth=..." line per case. Also checks that unused tokens
+// are given back.
+
+#include <curl/curl.h>
+
+#include <array>
+#include <cstdio>
+#include <string>
+
+#include "bandwidth.hpp"
+#include "http.hpp"
+#include "test_support.hpp"
+#include "upload_stream.hpp"
+
+namespace {
+constexpr size_t KB = 1024;
+
+size_t discardFunction(char*, size_t size, size_t nmemb, void*) {
+    return size * nmemb;
+}
+
+// One PUT streamed through uploadReadFunction() like the real uploads
+struct Upload {
+    Upload(const TestServer& server, const std::string& path, size_t size,
+           TrafficClass cls) {
+        f = std::fopen(path.c_str(), "rb");
+        ui = UploadInfo{f, size, cls};
+        curl = HttpSession::get().createHandle();
+        url = server.url() + "/" + path;
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+        curl_easy_setopt(curl, CURLOPT_READFUNCTION, uploadReadFunction);
+        curl_easy_setopt(curl, CURLOPT_READDATA, &ui);
+        curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE,
+                         static_cast<curl_off_t>(size));
+        curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE, 0x2000L);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, discardFunction);
+    }
+    ~Upload() {
+        stopReadAhead(ui);
+        curl_easy_cleanup(curl);
+        std::fclose(f);
+    }
+    Upload(const Upload&) = delete;
+    Upload& operator=(const Upload&) = delete;
+
+    [[nodiscard]] double ms() const {
+        curl_off_t us = 0;
+        curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &us);
+        return static_cast<double>(us) / 1000.0;
+    }
+
+    FILE* f{nullptr};
+    UploadInfo ui;
+    CURL* curl{nullptr};
+    std::string url;
+};
+
+std::string makeFile(const char* name, size_t size) {
+    writeFile(name, randomBytes(size));
+    return name;
+}
+
+void printCase(const char* name, const char* what, size_t limit,
+               size_t size, double ms) {
+    std::printf(
+        "[bench] bandwidth=%s stream=%s limit_kbps=%zu bytes=%zu ms=%.0f "
+        "kbps=%.0f\n",
+        name, what, limit / KB, size, ms,
+        static_cast<double>(size) / KB / (ms / 1000.0));
+}
+
+// Tokens of a grant that was not sent go back to the bucket
+void refundUnused() {
+    constexpr size_t rate = 64 * KB;  // Bucket depth of 8KB
+    BandwidthLimiter::get().configure(rate, 0);
+    const size_t grant =
+        BandwidthLimiter::get().tryAcquire(TrafficClass::Movie, 8 * KB);
+    CHECK(grant == 8 * KB);
+    BandwidthLimiter::get().refund(TrafficClass::Movie, grant - KB);
+    CHECK(BandwidthLimiter::get().tryAcquire(TrafficClass::Movie, 8 * KB) >=
+          7 * KB);
+}
+
+// A single throttled upload should average the configured rate, less the
+// initial burst the bucket hands out
+void rateAccuracy(TestServer& server) {
+    constexpr size_t rate = 512 * KB;
+    constexpr size_t size = 1024 * KB;
+    BandwidthLimiter::get().configure(rate, 0);
+
+    Upload upload(server, makeFile("rate.jpg", size), size,
+                  TrafficClass::Screenshot);
+    const CURLcode res = HttpSession::get().perform(upload.curl);
+    CHECK(res == CURLE_OK);
+    CHECK(upload.ui.sizeLeft == 0);
+
+    const double ms = upload.ms();
+    printCase("rate", "screenshot", rate, size, ms);
+    const double expectedMs = (size - rate / 8) * 1000.0 / rate;
+    CHECK(ms > expectedMs * 0.9 && ms < expectedMs * 1.15);
+}
+
+// A screenshot sharing the global limit with a movie gets the tokens
+// first and finishes about as fast as it would on its own
+void screenshotFirst(TestServer& server) {
+    constexpr size_t rate = 512 * KB;
+    constexpr size_t movieSize = 1024 * KB;
+    constexpr size_t shotSize = 256 * KB;
+    BandwidthLimiter::get().configure(rate, 0);
+
+    Upload movie(server, makeFile("first.mp4", movieSize), movieSize,
+                 TrafficClass::Movie);
+    Upload shot(server, makeFile("first.jpg", shotSize), shotSize,
+                TrafficClass::Screenshot);
+    const std::array<CURL*, 2> handles{movie.curl, shot.curl};
+    std::array<CURLcode, 2> results{};
+    HttpSession::get().performAll(handles, results);
+    CHECK(results[0] == CURLE_OK && results[1] == CURLE_OK);
+    CHECK(movie.ui.sizeLeft == 0 && shot.ui.sizeLeft == 0);
+
+    printCase("shared", "screenshot", rate, shotSize, shot.ms());
+    printCase("shared", "movie", rate, movieSize, movie.ms());
+    // Alone: (256KB - 64KB burst) at 512KB/s = 375ms
+    CHECK(shot.ms() < 600.0);
+    CHECK(movie.ms() > shot.ms());
+}
+
+// An unthrottled screenshot must not slow down because a movie next to it
+// is throttled. Blocking in the read callback used to stall the whole
+// transfer loop on every movie read.
+void throttledMovieDoesNotBlock(TestServer& server) {
+    constexpr size_t movieRate = 64 * KB;
+    constexpr size_t movieSize = 128 * KB;
+    constexpr size_t shotSize = 8192 * KB;
+    BandwidthLimiter::get().configure(0, movieRate);
+
+    Upload movie(server, makeFile("slow.mp4", movieSize), movieSize,
+                 TrafficClass::Movie);
+    Upload shot(server, makeFile("fast.jpg", shotSize), shotSize,
+                TrafficClass::Screenshot);
+    const std::array<CURL*, 2> handles{movie.curl, shot.curl};
+    std::array<CURLcode, 2> results{};
+    HttpSession::get().performAll(handles, results);
+    CHECK(results[0] == CURLE_OK && results[1] == CURLE_OK);
+    CHECK(movie.ui.sizeLeft == 0 && shot.ui.sizeLeft == 0);
+
+    printCase("unthrottled", "screenshot", 0, shotSize, shot.ms());
+    printCase("unthrottled", "movie", movieRate, movieSize, movie.ms());
+    // Loopback moves 8MB in well under a second, the movie needs ~2s
+    CHECK(shot.ms() < 1000.0);
+    CHECK(movie.ms() > 1500.0);
+}
+}  // namespace
+
+int main() {
+    enterScratchDir("bandwidth_bench");
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    {
+        TestServer server;
+        server.setStoreBodies(false);
+
+        refundUnused();
+        rateAccuracy(server);
+        screenshotFirst(server);
+        throttledMovieDoesNotBlock(server);
+
+        HttpSession::get().cleanup();
+    }
+    curl_global_cleanup();
+    return testExitCode();
+}
@@ -0,0 +1,132 @@
+// Copies to further Telegram chats and forwards to further Discord
+// channels: one that fails after the upload is spooled with the message it
+// delivers and retried from the spool, without uploading the capture again.
+// A channel that refuses forwards gets the attachment link instead.
+
+#include <atomic>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "circuit.hpp"
+#include "config.hpp"
+#include "scheduler.hpp"
+#include "spool.hpp"
+#include "test_support.hpp"
+#include "utils.hpp"
+
+namespace {
+constexpr std::string_view ATTACHMENT_URL =
+    "https://cdn.discordapp.com/attachments/1/111/a.jpg?ex=1&hm=2";
+
+std::vector<CaptureItem> g_captures;
+std::atomic<bool> g_failDeliveries{true};
+
+HttpResponse api(const HttpRequest& request) {
+    HttpResponse response;
+    const std::string_view target = request.target;
+    if (target.find("/sendPhoto") != std::string_view::npos) {
+        response.body = R"({"ok":true,"result":{"message_id":10}})";
+    } else if (target.find("/channels/1/messages") != std::string_view::npos) {
+        response.body = R"({"id":"111","attachments":[{"url":")" +
+                        std::string(ATTACHMENT_URL) + R"("}]})";
+    } else if (target.find("/channels/4/") != std::string_view::npos &&
+               request.body.find("message_reference") != std::string::npos) {
+        response.status = 403;
+        response.body = R"({"code":50001,"message":"Missing Access"})";
+    } else if (g_failDeliveries &&
+               (target.find("chat_id=3") != std::string_view::npos ||
+                target.find("/channels/3/") != std::string_view::npos)) {
+        response.status = 502;
+        response.body = R"({"ok":false,"error_code":502,"description":"x"})";
+    } else {
+        response.body = R"({"ok":true,"result":{"message_id":20},"id":"222"})";
+    }
+    return response;
+}
+
+SchedulerHooks hooks() {
+    SchedulerHooks result = consoleHooks();
+    result.popCapture = []() -> std::optional<CaptureItem> {
+        if (g_captures.empty()) return std::nullopt;
+        CaptureItem item = std::move(g_captures.front());
+        g_captures.erase(g_captures.begin());
+        return item;
+    };
+    result.capturePending = [] { return !g_captures.empty(); };
+    result.setFastScan = [](bool) {};
+    result.waitForCapture = [](u64) {};
+    return result;
+}
+
+// Requests whose target contains `part`, in order
+std::vector<std::string> targets(TestServer& server, std::string_view part) {
+    std::vector<std::string> result;
+    for (const auto& request : server.requests()) {
+        if (request.target.find(part) != std::string::npos) {
+            result.push_back(request.target);
+        }
+    }
+    return result;
+}
+}  // namespace
+
+int main() {
+    enterScratchDir("delivery_test");
+    TestServer server(api);
+    writeConfig("[general]\ntelegram = true\ndiscord = true\n"
+                "spool_max_items = 10\n"
+                "[telegram]\nbot_token = 1:x\nchat_id = 1,2,3\n"
+                "upload_mode = compressed\napi_url = " +
+                server.url() +
+                "\n[discord]\nbot_token = x\nchannel_id = 1,2,3,4\n"
+                "api_url = " +
+                server.url() + "\n");
+    CHECK(Config::get().refresh());
+    RetrySpool::get().load(10);
+
+    const std::string path = "img:/2026/10/19/2026101912000000-A.jpg";
+    writeFile(path, "\xFF\xD8" + randomBytes(4096, 1) + "\xFF\xD9");
+    const SchedulerSettings settings{UploadMode::Compressed, 0, 0, 0};
+
+    // The third chat and channel fail, the second ones still get theirs and
+    // the fourth channel gets the link
+    {
+        UploadScheduler scheduler(hooks(), settings);
+        g_captures.push_back(CaptureItem{path, filesize(path), false, 0});
+        scheduler.runOnce();
+    }
+    CHECK(targets(server, "chat_id=2&from_chat_id=1&message_id=10").size() ==
+          1);
+    CHECK(targets(server, "/channels/2/messages").size() == 1);
+    CHECK(targets(server, "/channels/4/messages").size() == 2);
+    CHECK(RetrySpool::get().size(Destination::Telegram) == 0);
+    CHECK(RetrySpool::get().size(Destination::Discord) == 0);
+    auto telegram = RetrySpool::get().frontDelivery(Destination::Telegram);
+    CHECK(telegram && telegram->recipient == "3" && telegram->origin == "1" &&
+          telegram->messageIds == "10");
+    auto discord = RetrySpool::get().frontDelivery(Destination::Discord);
+    CHECK(discord && discord->recipient == "3" && discord->origin == "1" &&
+          discord->messageIds == "111" &&
+          discord->attachmentUrl == ATTACHMENT_URL);
+    CHECK(RetrySpool::get().deliveries(Destination::Discord) == 1);
+
+    // After a restart the spool delivers them, nothing is uploaded again
+    server.clear();
+    g_failDeliveries = false;
+    CircuitBreaker::get().reset();
+    RetrySpool::get().load(10);
+    {
+        UploadScheduler scheduler(hooks(), settings);
+        scheduler.runOnce();
+    }
+    CHECK(targets(server, "/sendPhoto").empty());
+    CHECK(targets(server, "/channels/1/").empty());
+    CHECK(targets(server, "chat_id=3&from_chat_id=1&message_id=10").size() ==
+          1);
+    CHECK(targets(server, "/channels/3/messages").size() == 1);
+    CHECK(RetrySpool::get().total() == 0);
+
+    return testExitCode();
+}
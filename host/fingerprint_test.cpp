@@ -0,0 +1,64 @@
+// FingerprintStore: captures of the same size are told apart by their
+// edges or their full CRC, and a fingerprint file that went missing is
+// written again with every entry, not just the newest one.
+
+#include <cstdio>
+#include <string>
+
+#include "crc32.hpp"
+#include "fingerprint.hpp"
+#include "test_support.hpp"
+
+namespace {
+// Record `content`, written to `path`, as uploaded
+void upload(const std::string& path, const std::string& content) {
+    writeFile(path, content);
+    FingerprintStore::get().add(
+        path, content.size(), crc32c(0, content.data(), content.size()));
+}
+
+bool duplicate(const std::string& path, const std::string& content) {
+    writeFile(path, content);
+    return FingerprintStore::get().isDuplicate(path, content.size());
+}
+}  // namespace
+
+int main() {
+    enterScratchDir("fingerprint_test");
+    auto& store = FingerprintStore::get();
+    store.load();
+    CHECK(store.count() == 0);
+
+    const std::string first = randomBytes(0x10000, 1);
+    upload("img:/first.jpg", first);
+    CHECK(duplicate("img:/copy.jpg", first));
+
+    // Same size, different edges or only a different middle
+    std::string head = first;
+    head[0] ^= 1;
+    CHECK(!duplicate("img:/head.jpg", head));
+    std::string middle = first;
+    middle[middle.size() / 2] ^= 1;
+    CHECK(!duplicate("img:/middle.jpg", middle));
+
+    // Files smaller than both edges together
+    const std::string small = randomBytes(0x1800, 2);
+    upload("img:/small.jpg", small);
+    CHECK(duplicate("img:/small_copy.jpg", small));
+    std::string smallTail = small;
+    smallTail.back() ^= 1;
+    CHECK(!duplicate("img:/small_tail.jpg", smallTail));
+
+    // A file deleted behind the store's back gets every entry back
+    store.load();
+    CHECK(store.count() == 2);
+    std::remove(std::string(FINGERPRINTS_PATH).c_str());
+    const std::string third = randomBytes(0x8000, 3);
+    upload("img:/third.jpg", third);
+    store.load();
+    CHECK(store.count() == 3);
+    CHECK(duplicate("img:/first_again.jpg", first));
+    CHECK(duplicate("img:/third_again.jpg", third));
+
+    return testExitCode();
+}
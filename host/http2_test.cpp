@@ -0,0 +1,180 @@
+// HttpSession against an HTTP/2 stand-in: nghttpx terminates TLS with h2
+// and forwards to a TestServer over HTTP/1.1. Checks that concurrent
+// transfers share one multiplexed connection, that the ntfy digest trailer
+// still arrives while h2 is available, and that warm connections survive
+// idle passes until the idle timeout. Skipped when nghttpx or openssl is
+// missing.
+
+#include <curl/curl.h>
+#include <strings.h>
+
+#include <array>
+#include <cstdio>
+#include <string>
+
+#include "config.hpp"
+#include "http.hpp"
+#include "network.hpp"
+#include "test_support.hpp"
+#include "upload.hpp"
+#include "upload_stream.hpp"
+#include "utils.hpp"
+
+namespace {
+// ctest treats this exit code as skipped, see SKIP_RETURN_CODE
+constexpr int EXIT_SKIP = 77;
+
+size_t discardFunction(char*, size_t size, size_t nmemb, void*) {
+    return size * nmemb;
+}
+
+// One PUT streamed through uploadReadFunction()
+struct Upload {
+    Upload(const std::string& url, const std::string& path, size_t size) {
+        f = std::fopen(path.c_str(), "rb");
+        ui = UploadInfo{f, size, TrafficClass::Screenshot};
+        curl = HttpSession::get().createHandle();
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+        curl_easy_setopt(curl, CURLOPT_READFUNCTION, uploadReadFunction);
+        curl_easy_setopt(curl, CURLOPT_READDATA, &ui);
+        curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE,
+                         static_cast<curl_off_t>(size));
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, discardFunction);
+    }
+    ~Upload() {
+        curl_easy_cleanup(curl);
+        std::fclose(f);
+    }
+    Upload(const Upload&) = delete;
+    Upload& operator=(const Upload&) = delete;
+
+    [[nodiscard]] long info(CURLINFO what) const {
+        long value = 0;
+        curl_easy_getinfo(curl, what, &value);
+        return value;
+    }
+
+    FILE* f{nullptr};
+    UploadInfo ui;
+    CURL* curl{nullptr};
+};
+
+// Concurrent uploads to one host are streams of a single h2 connection
+void multiplexed(const TlsProxy& proxy, TestServer& backend) {
+    constexpr size_t size = 256 * 1024;
+    writeFile("a.jpg", randomBytes(size, 1));
+    writeFile("b.jpg", randomBytes(size, 2));
+    backend.clear();
+
+    Upload a(proxy.url() + "/a", "a.jpg", size);
+    Upload b(proxy.url() + "/b", "b.jpg", size);
+    const std::array<CURL*, 2> handles{a.curl, b.curl};
+    std::array<CURLcode, 2> results{};
+    HttpSession::get().performAll(handles, results);
+
+    CHECK(results[0] == CURLE_OK && results[1] == CURLE_OK);
+    CHECK(a.info(CURLINFO_HTTP_VERSION) == CURL_HTTP_VERSION_2_0);
+    CHECK(b.info(CURLINFO_HTTP_VERSION) == CURL_HTTP_VERSION_2_0);
+    CHECK(a.info(CURLINFO_NUM_CONNECTS) + b.info(CURLINFO_NUM_CONNECTS) ==
+          1);
+    const auto requests = backend.requests();
+    CHECK(requests.size() == 2);
+    for (const auto& request : requests) {
+        CHECK(request.bodySize == size);
+    }
+}
+
+// The ntfy digest trailer needs chunked HTTP/1.1, also when the server
+// offers h2
+void ntfyDigestTrailer(const TlsProxy& proxy, TestServer& backend) {
+    constexpr size_t size = 100 * 1024;
+    const std::string shot = "img:/2026/10/19/2026101912000000-A.jpg";
+    const std::string content = randomBytes(size, 3);
+    writeFile(shot, content);
+
+    writeConfig("[general]\nntfy = true\nsend_digest = true\n"
+                "[ntfy]\ntopic = test\nurl = " +
+                proxy.url() + "\n");
+    CHECK(Config::get().refresh());
+    backend.clear();
+
+    ContentDigest digest;
+    CHECK(sendFileToNtfy(shot, size, &digest));
+    CHECK(digest.valid);
+
+    const auto requests = backend.requests();
+    CHECK(requests.size() == 1);
+    if (requests.size() == 1) {
+        const HttpRequest& request = requests.front();
+        CHECK(request.body == content);
+        // Header names are case-insensitive, the proxy changes their case
+        std::string_view trailer;
+        for (const auto& h : request.trailers) {
+            if (strcasecmp(h.name.c_str(), "X-Content-SHA256") == 0) {
+                trailer = h.value;
+            }
+        }
+        CHECK(trailer == hex_encode(digest.sha256));
+    }
+}
+
+// An idle pass keeps the warm connection, the idle timeout closes it
+void idleConnections(const TlsProxy& proxy) {
+    constexpr size_t size = 1024;
+    writeFile("c.jpg", randomBytes(size, 4));
+    constexpr u64 IDLE_NS = 200'000'000ULL;
+
+    {
+        Upload warm(proxy.url() + "/c", "c.jpg", size);
+        CHECK(HttpSession::get().perform(warm.curl) == CURLE_OK);
+    }
+    HttpSession::get().closeIdle(IDLE_NS);
+    {
+        Upload reused(proxy.url() + "/c", "c.jpg", size);
+        CHECK(HttpSession::get().perform(reused.curl) == CURLE_OK);
+        CHECK(reused.info(CURLINFO_NUM_CONNECTS) == 0);
+    }
+
+    svcSleepThread(static_cast<s64>(IDLE_NS));
+    HttpSession::get().closeIdle(IDLE_NS);
+    {
+        Upload fresh(proxy.url() + "/c", "c.jpg", size);
+        CHECK(HttpSession::get().perform(fresh.curl) == CURLE_OK);
+        CHECK(fresh.info(CURLINFO_NUM_CONNECTS) == 1);
+    }
+}
+}  // namespace
+
+int main() {
+    enterScratchDir("http2_test");
+    if (!hasTool("nghttpx") || !hasTool("openssl")) {
+        std::printf("nghttpx or openssl not found, skipping\n");
+        return EXIT_SKIP;
+    }
+    if (!trustTestCertificate()) {
+        std::printf("Unable to create a certificate, skipping\n");
+        return EXIT_SKIP;
+    }
+
+    const curl_version_info_data* curlInfo =
+        curl_version_info(CURLVERSION_NOW);
+    if ((curlInfo->features & CURL_VERSION_HTTP2) == 0) {
+        std::printf("libcurl without HTTP/2, skipping\n");
+        return EXIT_SKIP;
+    }
+
+    CHECK(startNetwork());
+    {
+        TestServer backend;
+        TlsProxy proxy(backend.port(), true);
+
+        multiplexed(proxy, backend);
+        ntfyDigestTrailer(proxy, backend);
+        idleConnections(proxy);
+
+        HttpSession::get().cleanup();
+    }
+    stopNetwork();
+    return testExitCode();
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+// The subset of minIni read by the configuration, see minini.cpp
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int ini_gets(const char* Section, const char* Key, const char* DefValue,
+             char* Buffer, int BufferSize, const char* Filename);
+long ini_getl(const char* Section, const char* Key, long DefValue,
+              const char* Filename);
+int ini_getbool(const char* Section, const char* Key, int DefValue,
+                const char* Filename);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,189 @@
+#pragma once
+
+// POSIX stand-in for the parts of libnx the sysmodule uses, so its sources
+// build and run on a desktop for tests and benchmarks. Services the host
+// doesn't have (sm, ns, capsa, fs, nifm, sockets) succeed and do nothing;
+// ticks, threads, locks and crypto behave like on the console.
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef u32 Result;
+
+#define R_FAILED(rc) ((rc) != 0)
+#define R_SUCCEEDED(rc) ((rc) == 0)
+#define MAKEHOSVERSION(major, minor, micro) \
+    (((u32)(major) << 16) | ((u32)(minor) << 8) | (u32)(micro))
+
+#define SHA256_HASH_SIZE 0x20
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum { AppletType_None = -2 } AppletType;
+
+Result smInitialize(void);
+void smExit(void);
+
+typedef struct {
+    u8 major;
+    u8 minor;
+    u8 micro;
+} SetSysFirmwareVersion;
+
+Result setsysInitialize(void);
+void setsysExit(void);
+Result setsysGetFirmwareVersion(SetSysFirmwareVersion* out);
+void hosversionSet(u32 version);
+void fatalThrow(Result rc) __attribute__((noreturn));
+
+Result nsInitialize(void);
+void nsExit(void);
+
+typedef struct {
+    u32 tcp_tx_buf_size;
+    u32 tcp_rx_buf_size;
+    u32 tcp_tx_buf_max_size;
+    u32 tcp_rx_buf_max_size;
+    u32 udp_tx_buf_size;
+    u32 udp_rx_buf_size;
+    u32 sb_efficiency;
+    u32 num_bsd_sessions;
+    int bsd_service_type;
+} SocketInitConfig;
+
+enum { BsdServiceType_User = 1 };
+
+Result socketInitialize(const SocketInitConfig* config);
+void socketExit(void);
+
+typedef enum {
+    CapsAlbumStorage_Nand = 0,
+    CapsAlbumStorage_Sd = 1,
+} CapsAlbumStorage;
+
+Result capsaInitialize(void);
+void capsaExit(void);
+Result capsaGetAutoSavingStorage(CapsAlbumStorage* out);
+
+typedef struct {
+    u32 session;
+} FsFileSystem;
+
+typedef enum {
+    FsImageDirectoryId_Nand = 0,
+    FsImageDirectoryId_Sd = 1,
+} FsImageDirectoryId;
+
+Result fsInitialize(void);
+void fsExit(void);
+Result fsOpenImageDirectoryFileSystem(FsFileSystem* out,
+                                      FsImageDirectoryId id);
+int fsdevMountSdmc(void);
+int fsdevMountDevice(const char* name, FsFileSystem fs);
+int fsdevUnmountAll(void);
+
+typedef enum { NifmServiceType_User = 1 } NifmServiceType;
+typedef enum { NifmInternetConnectionType_WiFi = 1 } NifmInternetConnectionType;
+typedef enum {
+    NifmInternetConnectionStatus_Connected = 4,
+} NifmInternetConnectionStatus;
+
+Result nifmInitialize(NifmServiceType type);
+void nifmExit(void);
+Result nifmGetInternetConnectionStatus(NifmInternetConnectionType* type,
+                                       u32* wifiStrength,
+                                       NifmInternetConnectionStatus* status);
+
+// System tick at the console's 19.2MHz, from the monotonic clock
+u64 armGetSystemTick(void);
+u64 armGetSystemTickFreq(void);
+u64 armTicksToNs(u64 tick);
+u64 armNsToTicks(u64 ns);
+void svcSleepThread(s64 nano);
+
+// Zero-initialized locks are ready to use, like on the console
+typedef struct {
+    pthread_mutex_t handle;
+} Mutex;
+
+typedef struct {
+    Mutex lock;
+    pthread_t owner;
+    u32 counter;
+} RMutex;
+
+typedef struct {
+    pthread_cond_t handle;
+} CondVar;
+
+void mutexInit(Mutex* m);
+void mutexLock(Mutex* m);
+void mutexUnlock(Mutex* m);
+bool mutexTryLock(Mutex* m);
+void rmutexInit(RMutex* m);
+void rmutexLock(RMutex* m);
+void rmutexUnlock(RMutex* m);
+void condvarInit(CondVar* c);
+Result condvarWait(CondVar* c, Mutex* m);
+Result condvarWaitTimeout(CondVar* c, Mutex* m, u64 timeout);
+Result condvarWakeOne(CondVar* c);
+Result condvarWakeAll(CondVar* c);
+
+typedef void (*ThreadFunc)(void*);
+
+// The stack passed to threadCreate() is ignored, host threads get their
+// own
+typedef struct {
+    pthread_t handle;
+    ThreadFunc entry;
+    void* arg;
+} Thread;
+
+Result threadCreate(Thread* t, ThreadFunc entry, void* arg, void* stack_mem,
+                    size_t stack_sz, int prio, int cpuid);
+Result threadStart(Thread* t);
+Result threadWaitForExit(Thread* t);
+Result threadClose(Thread* t);
+
+// Copyable like the libnx context, the digest code finalizes copies
+typedef struct {
+    u32 intermediate_hash[8];
+    u8 buffer[0x40];
+    u64 bits_consumed;
+    size_t num_buffered;
+    bool finalized;
+} Sha256Context;
+
+void sha256ContextCreate(Sha256Context* out);
+void sha256ContextUpdate(Sha256Context* ctx, const void* src, size_t size);
+void sha256ContextGetHash(Sha256Context* ctx, void* dst);
+void sha256CalculateHash(void* dst, const void* src, size_t size);
+void hmacSha256CalculateMac(void* dst, const void* key, size_t key_size,
+                            const void* src, size_t src_size);
+
+typedef enum {
+    TimeType_UserSystemClock = 0,
+    TimeType_NetworkSystemClock = 1,
+    TimeType_LocalSystemClock = 2,
+    TimeType_Default = TimeType_UserSystemClock,
+} TimeType;
+
+Result timeInitialize(void);
+void timeExit(void);
+Result timeGetCurrentTime(TimeType type, u64* timestamp);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,117 @@
+// Minimal INI reader with minIni's interface and semantics: sections and
+// keys are case-insensitive, values are trimmed, quotes and trailing
+// comments are stripped.
+
+#include <minIni.h>
+
+#include <strings.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace {
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::strchr(" \t\r\n", text.front())) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && std::strchr(" \t\r\n", text.back())) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+bool equalsNoCase(std::string_view a, std::string_view b) {
+    return a.size() == b.size() &&
+           strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+std::optional<std::string> lookup(const char* section, const char* key,
+                                  const char* filename) {
+    FILE* f = std::fopen(filename, "r");
+    if (f == nullptr) {
+        return std::nullopt;
+    }
+
+    char buffer[512];
+    bool inSection = section == nullptr || *section == '\0';
+    std::optional<std::string> result;
+    while (std::fgets(buffer, sizeof(buffer), f) != nullptr) {
+        std::string_view line = trim(buffer);
+        if (line.empty() || line.front() == ';' || line.front() == '#') {
+            continue;
+        }
+        if (line.front() == '[') {
+            const size_t end = line.find(']');
+            inSection = end != std::string_view::npos &&
+                        equalsNoCase(trim(line.substr(1, end - 1)), section);
+            continue;
+        }
+        const size_t eq = line.find_first_of("=:");
+        if (!inSection || eq == std::string_view::npos ||
+            !equalsNoCase(trim(line.substr(0, eq)), key)) {
+            continue;
+        }
+
+        std::string_view value = trim(line.substr(eq + 1));
+        if (!value.empty() && value.front() == '"') {
+            value.remove_prefix(1);
+            value = value.substr(0, value.find('"'));
+        } else {
+            value = trim(value.substr(0, value.find_first_of(";#")));
+        }
+        result = std::string(value);
+        break;
+    }
+    std::fclose(f);
+    return result;
+}
+}  // namespace
+
+extern "C" {
+
+int ini_gets(const char* Section, const char* Key, const char* DefValue,
+             char* Buffer, int BufferSize, const char* Filename) {
+    if (Buffer == nullptr || BufferSize <= 0) {
+        return 0;
+    }
+    const auto value = lookup(Section, Key, Filename);
+    const std::string_view text =
+        value.has_value() ? std::string_view(*value)
+                          : std::string_view(DefValue ? DefValue : "");
+    const size_t length =
+        std::min(text.size(), static_cast<size_t>(BufferSize - 1));
+    std::memcpy(Buffer, text.data(), length);
+    Buffer[length] = '\0';
+    return static_cast<int>(length);
+}
+
+long ini_getl(const char* Section, const char* Key, long DefValue,
+              const char* Filename) {
+    const auto value = lookup(Section, Key, Filename);
+    if (!value.has_value() || value->empty()) {
+        return DefValue;
+    }
+    return std::strtol(value->c_str(), nullptr, 0);
+}
+
+int ini_getbool(const char* Section, const char* Key, int DefValue,
+                const char* Filename) {
+    const auto value = lookup(Section, Key, Filename);
+    if (!value.has_value() || value->empty()) {
+        return DefValue;
+    }
+    switch (value->front()) {
+        case 'y': case 'Y': case '1': case 't': case 'T':
+            return 1;
+        case 'n': case 'N': case '0': case 'f': case 'F':
+            return 0;
+    }
+    return DefValue;
+}
+
+}  // extern "C"
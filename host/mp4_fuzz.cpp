@@ -0,0 +1,233 @@
+// Fuzz harness for the MP4 box parser. Every seed of the corpus and a
+// fixed number of deterministic mutations of them (bit flips, overwritten
+// box sizes and types, truncation, splicing) go through mp4IsComplete() and
+// mp4ReadInfo(), read from memory. Build with -DNXSU_SANITIZE=ON to catch
+// out-of-bounds reads; without sanitizers it still checks the results.
+//
+// Usage: mp4_fuzz <corpus dir> [mutations per seed]
+//
+// The same entry point builds as a libFuzzer target with clang:
+// clang++ -fsanitize=fuzzer,address -DMP4_LIBFUZZER ...
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mp4.hpp"
+#include "test_support.hpp"
+
+namespace {
+using Bytes = std::vector<uint8_t>;
+
+// Seeds with known content, anything else only has to parse safely
+struct Expected {
+    std::string_view name;
+    bool complete;
+    uint32_t durationSeconds;
+    uint32_t width;
+    uint32_t height;
+    bool fastStart;
+};
+constexpr Expected EXPECTED[] = {
+    {"faststart.mp4", true, 31, 1280, 720, true},
+    {"moov_last.mp4", true, 29, 1920, 1080, false},
+    {"large_box.mp4", true, 5, 640, 360, false},
+    {"size_zero.mp4", true, 1, 1280, 720, true},
+    {"recording.mp4", false, 0, 0, 0, false},
+};
+
+struct ParseResult {
+    bool complete{false};
+    std::optional<Mp4Info> info;
+};
+
+ParseResult parse(const uint8_t* data, size_t size) {
+    ParseResult result;
+    // fmemopen() refuses empty buffers
+    if (size == 0) return result;
+
+    FILE* f = fmemopen(const_cast<uint8_t*>(data), size, "rb");
+    if (f == nullptr) {
+        std::perror("fmemopen");
+        std::abort();
+    }
+    result.complete = mp4IsComplete(f, size);
+    result.info = mp4ReadInfo(f, size);
+    std::fclose(f);
+
+    // Reported dimensions always come from a visual track
+    if (result.info) {
+        CHECK(result.info->width > 0 && result.info->height > 0);
+    }
+    return result;
+}
+
+// xorshift32, the same sequence on every run
+struct Random {
+    uint32_t state;
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    size_t below(size_t bound) { return bound == 0 ? 0 : next() % bound; }
+};
+
+// Offsets of box headers found by a naive scan for printable types, so
+// size mutations hit real size fields more often than random bytes
+std::vector<size_t> headerOffsets(const Bytes& data) {
+    std::vector<size_t> offsets;
+    for (size_t i = 0; i + 8 <= data.size(); ++i) {
+        if (std::all_of(&data[i + 4], &data[i + 8],
+                        [](uint8_t c) { return c >= 'a' && c <= 'z'; })) {
+            offsets.push_back(i);
+        }
+    }
+    return offsets;
+}
+
+void writeU32(Bytes& data, size_t offset, uint32_t value) {
+    if (offset + 4 > data.size()) return;
+    data[offset] = static_cast<uint8_t>(value >> 24);
+    data[offset + 1] = static_cast<uint8_t>(value >> 16);
+    data[offset + 2] = static_cast<uint8_t>(value >> 8);
+    data[offset + 3] = static_cast<uint8_t>(value);
+}
+
+Bytes mutate(const Bytes& seed, const std::vector<Bytes>& corpus,
+             const std::vector<size_t>& headers, Random& random) {
+    static constexpr uint32_t INTERESTING[] = {
+        0, 1, 7, 8, 15, 16, 0x7FFFFFFF, 0x80000000, 0xFFFFFFF8, 0xFFFFFFFF};
+    static constexpr std::string_view TYPES[] = {"moov", "trak", "tkhd",
+                                                 "mvhd", "mdat", "free"};
+
+    Bytes data = seed;
+    const int steps = 1 + static_cast<int>(random.below(4));
+    for (int step = 0; step < steps && !data.empty(); ++step) {
+        const size_t header =
+            headers.empty() ? 0 : headers[random.below(headers.size())];
+        switch (random.below(7)) {
+            case 0:  // Flip a bit
+                data[random.below(data.size())] ^=
+                    static_cast<uint8_t>(1u << random.below(8));
+                break;
+            case 1:  // Random byte
+                data[random.below(data.size())] =
+                    static_cast<uint8_t>(random.next());
+                break;
+            case 2:  // Box size set to an edge case
+                writeU32(data, header,
+                         INTERESTING[random.below(std::size(INTERESTING))]);
+                break;
+            case 3:  // Box size off by a little
+                writeU32(data, header,
+                         static_cast<uint32_t>(data.size() - header) -
+                             static_cast<uint32_t>(random.below(32)) + 16);
+                break;
+            case 4: {  // Box type swapped for another known one
+                const std::string_view type =
+                    TYPES[random.below(std::size(TYPES))];
+                if (header + 8 <= data.size()) {
+                    std::copy(type.begin(), type.end(), &data[header + 4]);
+                }
+                break;
+            }
+            case 5:  // Truncate
+                data.resize(random.below(data.size() + 1));
+                break;
+            case 6: {  // Splice in the tail of another seed
+                const Bytes& other = corpus[random.below(corpus.size())];
+                const size_t from = random.below(other.size());
+                data.resize(random.below(data.size() + 1));
+                data.insert(data.end(), other.begin() + from, other.end());
+                break;
+            }
+        }
+    }
+    return data;
+}
+
+Bytes readFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return Bytes(std::istreambuf_iterator<char>(in), {});
+}
+
+void checkSeed(std::string_view name, const Bytes& data) {
+    const ParseResult result = parse(data.data(), data.size());
+    for (const auto& expected : EXPECTED) {
+        if (expected.name != name) continue;
+
+        CHECK(result.complete == expected.complete);
+        CHECK(result.info.has_value() == expected.complete);
+        if (result.info) {
+            CHECK(result.info->durationSeconds == expected.durationSeconds);
+            CHECK(result.info->width == expected.width);
+            CHECK(result.info->height == expected.height);
+            CHECK(result.info->fastStart == expected.fastStart);
+        }
+    }
+
+    // A recording is finalized by appending moov: no prefix of such a
+    // file may look complete, or a movie would be uploaded half-written
+    if (name == "moov_last.mp4") {
+        for (size_t size = 1; size < data.size(); ++size) {
+            CHECK(!parse(data.data(), size).complete);
+        }
+    }
+}
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static_cast<void>(parse(data, size));
+    return 0;
+}
+
+#ifndef MP4_LIBFUZZER
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <corpus dir> [mutations]\n", argv[0]);
+        return 2;
+    }
+    const int mutations = argc > 2 ? std::atoi(argv[2]) : 10000;
+
+    std::vector<std::filesystem::path> paths;
+    for (const auto& entry : std::filesystem::directory_iterator(argv[1])) {
+        paths.push_back(entry.path());
+    }
+    std::sort(paths.begin(), paths.end());
+    CHECK(paths.size() >= std::size(EXPECTED));
+
+    std::vector<Bytes> corpus;
+    for (const auto& path : paths) {
+        corpus.push_back(readFile(path));
+        checkSeed(path.filename().string(), corpus.back());
+    }
+
+    Random random{0x4D503446};  // "MP4F"
+    size_t complete = 0;
+    size_t withInfo = 0;
+    for (const Bytes& seed : corpus) {
+        const std::vector<size_t> headers = headerOffsets(seed);
+        for (int i = 0; i < mutations; ++i) {
+            const Bytes data = mutate(seed, corpus, headers, random);
+            const ParseResult result = parse(data.data(), data.size());
+            complete += result.complete ? 1 : 0;
+            withInfo += result.info ? 1 : 0;
+        }
+    }
+
+    std::printf("[bench] mp4_fuzz seeds=%zu inputs=%zu complete=%zu info=%zu\n",
+                corpus.size(), corpus.size() * static_cast<size_t>(mutations),
+                complete, withInfo);
+    return testExitCode();
+}
+#endif
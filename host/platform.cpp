@@ -0,0 +1,199 @@
+// libnx stand-ins for host builds, see include/switch.h
+
+#include <switch.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+extern "C" {
+
+Result smInitialize(void) { return 0; }
+void smExit(void) {}
+
+Result setsysInitialize(void) { return 0; }
+void setsysExit(void) {}
+Result setsysGetFirmwareVersion(SetSysFirmwareVersion* out) {
+    *out = SetSysFirmwareVersion{18, 0, 0};
+    return 0;
+}
+void hosversionSet(u32) {}
+
+void fatalThrow(Result rc) {
+    std::fprintf(stderr, "fatalThrow(0x%x)\n", rc);
+    std::abort();
+}
+
+Result nsInitialize(void) { return 0; }
+void nsExit(void) {}
+
+// libnx takes the sockets' transfer memory from the heap, sized like
+// _bsdGetTransferMemSizeForConfig() does, so heap figures match the console
+namespace {
+void* g_socketTmem = nullptr;
+}  // namespace
+
+Result socketInitialize(const SocketInitConfig* config) {
+    const u32 tx = config->tcp_tx_buf_max_size != 0
+                       ? config->tcp_tx_buf_max_size
+                       : config->tcp_tx_buf_size;
+    const u32 rx = config->tcp_rx_buf_max_size != 0
+                       ? config->tcp_rx_buf_max_size
+                       : config->tcp_rx_buf_size;
+    const u32 sum = (tx + rx + config->udp_tx_buf_size +
+                     config->udp_rx_buf_size + 0xFFF) &
+                    ~0xFFFU;
+    g_socketTmem = aligned_alloc(0x1000, config->sb_efficiency * sum);
+    return g_socketTmem != nullptr ? 0 : 1;
+}
+
+void socketExit(void) {
+    free(g_socketTmem);
+    g_socketTmem = nullptr;
+}
+
+Result capsaInitialize(void) { return 0; }
+void capsaExit(void) {}
+Result capsaGetAutoSavingStorage(CapsAlbumStorage* out) {
+    *out = CapsAlbumStorage_Sd;
+    return 0;
+}
+
+Result fsInitialize(void) { return 0; }
+void fsExit(void) {}
+Result fsOpenImageDirectoryFileSystem(FsFileSystem* out, FsImageDirectoryId) {
+    out->session = 0;
+    return 0;
+}
+// "sdmc:/" and "img:/" paths resolve relative to the working directory
+int fsdevMountSdmc(void) { return 0; }
+int fsdevMountDevice(const char*, FsFileSystem) { return 0; }
+int fsdevUnmountAll(void) { return 0; }
+
+Result nifmInitialize(NifmServiceType) { return 0; }
+void nifmExit(void) {}
+Result nifmGetInternetConnectionStatus(NifmInternetConnectionType* type,
+                                       u32* wifiStrength,
+                                       NifmInternetConnectionStatus* status) {
+    *type = NifmInternetConnectionType_WiFi;
+    *wifiStrength = 3;
+    *status = NifmInternetConnectionStatus_Connected;
+    return 0;
+}
+
+namespace {
+constexpr u64 TICK_FREQ = 19'200'000ULL;
+constexpr u64 NS_PER_SECOND = 1'000'000'000ULL;
+}  // namespace
+
+u64 armGetSystemTick(void) {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<u64>(ts.tv_sec) * TICK_FREQ +
+           static_cast<u64>(ts.tv_nsec) * TICK_FREQ / NS_PER_SECOND;
+}
+
+u64 armGetSystemTickFreq(void) { return TICK_FREQ; }
+
+u64 armTicksToNs(u64 tick) {
+    return tick / TICK_FREQ * NS_PER_SECOND +
+           tick % TICK_FREQ * NS_PER_SECOND / TICK_FREQ;
+}
+
+u64 armNsToTicks(u64 ns) {
+    return ns / NS_PER_SECOND * TICK_FREQ +
+           ns % NS_PER_SECOND * TICK_FREQ / NS_PER_SECOND;
+}
+
+void svcSleepThread(s64 nano) {
+    if (nano <= 0) {
+        sched_yield();
+        return;
+    }
+    timespec ts{static_cast<time_t>(nano / 1'000'000'000LL),
+                static_cast<long>(nano % 1'000'000'000LL)};
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+void mutexInit(Mutex* m) { pthread_mutex_init(&m->handle, nullptr); }
+void mutexLock(Mutex* m) { pthread_mutex_lock(&m->handle); }
+void mutexUnlock(Mutex* m) { pthread_mutex_unlock(&m->handle); }
+bool mutexTryLock(Mutex* m) { return pthread_mutex_trylock(&m->handle) == 0; }
+
+void rmutexInit(RMutex* m) { *m = RMutex{}; }
+
+void rmutexLock(RMutex* m) {
+    const pthread_t self = pthread_self();
+    if (m->counter > 0 && pthread_equal(m->owner, self)) {
+        ++m->counter;
+        return;
+    }
+    mutexLock(&m->lock);
+    m->owner = self;
+    m->counter = 1;
+}
+
+void rmutexUnlock(RMutex* m) {
+    if (--m->counter == 0) {
+        mutexUnlock(&m->lock);
+    }
+}
+
+void condvarInit(CondVar* c) { pthread_cond_init(&c->handle, nullptr); }
+
+Result condvarWait(CondVar* c, Mutex* m) {
+    return pthread_cond_wait(&c->handle, &m->handle) == 0 ? 0 : 1;
+}
+
+Result condvarWaitTimeout(CondVar* c, Mutex* m, u64 timeout) {
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    const u64 ns = static_cast<u64>(deadline.tv_nsec) + timeout % NS_PER_SECOND;
+    deadline.tv_sec += static_cast<time_t>(timeout / NS_PER_SECOND +
+                                           ns / NS_PER_SECOND);
+    deadline.tv_nsec = static_cast<long>(ns % NS_PER_SECOND);
+    return pthread_cond_timedwait(&c->handle, &m->handle, &deadline) == 0 ? 0
+                                                                           : 1;
+}
+
+Result condvarWakeOne(CondVar* c) { return pthread_cond_signal(&c->handle); }
+Result condvarWakeAll(CondVar* c) {
+    return pthread_cond_broadcast(&c->handle);
+}
+
+namespace {
+void* threadEntry(void* data) {
+    auto* t = static_cast<Thread*>(data);
+    t->entry(t->arg);
+    return nullptr;
+}
+}  // namespace
+
+Result threadCreate(Thread* t, ThreadFunc entry, void* arg, void*, size_t, int,
+                    int) {
+    t->entry = entry;
+    t->arg = arg;
+    return 0;
+}
+
+Result threadStart(Thread* t) {
+    return pthread_create(&t->handle, nullptr, threadEntry, t) == 0 ? 0 : 1;
+}
+
+Result threadWaitForExit(Thread* t) {
+    return pthread_join(t->handle, nullptr) == 0 ? 0 : 1;
+}
+
+Result threadClose(Thread*) { return 0; }
+
+Result timeInitialize(void) { return 0; }
+void timeExit(void) {}
+Result timeGetCurrentTime(TimeType, u64* timestamp) {
+    *timestamp = static_cast<u64>(std::time(nullptr));
+    return 0;
+}
+
+}  // extern "C"
@@ -0,0 +1,197 @@
+// Telegram previews of screenshots whose full image failed: the preview
+// message id is spooled with the capture, so a retry after the next
+// screenshot or a restart replaces that message instead of sending another
+// one. Captures that can't be spooled have their preview deleted. Game
+// names go into the editMessageMedia JSON escaped.
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "circuit.hpp"
+#include "config.hpp"
+#include "scheduler.hpp"
+#include "spool.hpp"
+#include "test_support.hpp"
+#include "title_index.hpp"
+#include "utils.hpp"
+
+using namespace std::string_literals;
+
+namespace {
+std::vector<CaptureItem> g_captures;
+std::atomic<int> g_nextMessageId{10};
+std::atomic<bool> g_failEdits{true};
+
+// A JPEG whose EXIF IFD1 points at an embedded JPEG thumbnail
+std::string screenshot(uint32_t seed) {
+    const std::string thumbnail = "\xFF\xD8" + randomBytes(64, 2) + "\xFF\xD9";
+    std::string tiff = "II*\x00\x08\x00\x00\x00"  // Header, IFD0 at 8
+                       "\x00\x00\x0E\x00\x00\x00"  // No entries, IFD1 at 14
+                       "\x02\x00"                  // Two entries
+                       "\x01\x02\x04\x00\x01\x00\x00\x00\x2C\x00\x00\x00"
+                       "\x02\x02\x04\x00\x01\x00\x00\x00"s;
+    tiff += static_cast<char>(thumbnail.size());
+    tiff += "\x00\x00\x00"        // Rest of the thumbnail length
+            "\x00\x00\x00\x00"s;  // No further IFD
+    tiff += thumbnail;  // At offset 44
+    const std::string app1 = "Exif\x00\x00"s + tiff;
+    std::string jpeg = "\xFF\xD8\xFF\xE1"s;
+    jpeg += static_cast<char>((app1.size() + 2) >> 8);
+    jpeg += static_cast<char>((app1.size() + 2) & 0xFF);
+    return jpeg + app1 + randomBytes(4096, seed) + "\xFF\xD9";
+}
+
+HttpResponse telegram(const HttpRequest& request) {
+    HttpResponse response;
+    if (request.target.find("/sendPhoto") != std::string::npos) {
+        response.body = R"({"ok":true,"result":{"message_id":)" +
+                        std::to_string(g_nextMessageId++) + "}}";
+    } else if (request.target.find("/editMessageMedia") != std::string::npos &&
+               g_failEdits) {
+        response.status = 502;
+        response.body = R"({"ok":false,"error_code":502,"description":"x"})";
+    }
+    return response;
+}
+
+SchedulerHooks hooks() {
+    SchedulerHooks result = consoleHooks();
+    result.popCapture = []() -> std::optional<CaptureItem> {
+        if (g_captures.empty()) return std::nullopt;
+        CaptureItem item = std::move(g_captures.front());
+        g_captures.erase(g_captures.begin());
+        return item;
+    };
+    result.capturePending = [] { return !g_captures.empty(); };
+    result.setFastScan = [](bool) {};
+    result.waitForCapture = [](u64) {};
+    return result;
+}
+
+void capture(UploadScheduler& scheduler, const std::string& path) {
+    g_captures.push_back(CaptureItem{path, filesize(path), false, 0});
+    scheduler.runOnce();
+}
+
+// Requests whose target contains `method`, in order
+std::vector<std::string> targets(TestServer& server, std::string_view method) {
+    std::vector<std::string> result;
+    for (const auto& request : server.requests()) {
+        if (request.target.find(method) != std::string::npos) {
+            result.push_back(request.target);
+        }
+    }
+    return result;
+}
+
+// A title index with a single game, see scripts/build_title_index.py
+void writeTitleIndex(std::string_view tid, std::string_view name) {
+    const std::array<uint32_t, 4> header{0x4954584E, 1, 1,
+                                         16 + TitleIndex::NAME_SIZE};
+    std::string index(reinterpret_cast<const char*>(header.data()),
+                      sizeof(header));
+    for (size_t i = 0; i < tid.size(); i += 2) {
+        index += static_cast<char>(
+            std::stoi(std::string(tid.substr(i, 2)), nullptr, 16));
+    }
+    std::array<char, TitleIndex::NAME_SIZE> record{};
+    std::memcpy(record.data(), name.data(), name.size());
+    index.append(record.data(), record.size());
+    writeFile(TITLE_INDEX_PATH, index);
+    CHECK(TitleIndex::get().load());
+}
+
+void writeTelegramConfig(const TestServer& server, int spoolMaxItems) {
+    writeConfig("[general]\ntelegram = true\nspool_max_items = " +
+                std::to_string(spoolMaxItems) +
+                "\n[telegram]\nbot_token = 1:x\nchat_id = 1\n"
+                "upload_mode = compressed\npreview = true\napi_url = " +
+                server.url() + "\n");
+    CHECK(Config::get().refresh());
+    RetrySpool::get().load(static_cast<size_t>(spoolMaxItems));
+}
+}  // namespace
+
+int main() {
+    enterScratchDir("preview_test");
+    TestServer server(telegram);
+    writeTelegramConfig(server, 10);
+
+    const std::string first = "img:/2026/10/19/2026101912000000-A.jpg";
+    const std::string second = "img:/2026/10/19/2026101912000100-A.jpg";
+    const std::string third = "img:/2026/10/19/2026101912000200-A.jpg";
+    writeFile(first, screenshot(1));
+    writeFile(second, screenshot(2));
+    writeFile(third, screenshot(3));
+    const SchedulerSettings settings{UploadMode::Compressed, 0, 0, 0};
+
+    // Edits fail: each screenshot is spooled along with its preview, the
+    // second one's preview doesn't take the place of the first
+    {
+        UploadScheduler scheduler(hooks(), settings);
+        capture(scheduler, first);
+        CircuitBreaker::get().reset();
+        capture(scheduler, second);
+    }
+    CHECK(targets(server, "/sendPhoto").size() == 2);
+    CHECK(RetrySpool::get().size(Destination::Telegram) == 2);
+    auto entry = RetrySpool::get().front(Destination::Telegram);
+    CHECK(entry && entry->path == first && entry->previewMessageId == 10);
+
+    // After a restart the retries replace both previews
+    server.clear();
+    g_failEdits = false;
+    CircuitBreaker::get().reset();
+    RetrySpool::get().load(10);
+    {
+        UploadScheduler scheduler(hooks(), settings);
+        scheduler.runOnce();
+    }
+    CHECK(targets(server, "/sendPhoto").empty());
+    const auto edits = targets(server, "/editMessageMedia");
+    CHECK(edits.size() == 2 && edits[0].ends_with("message_id=10") &&
+          edits[1].ends_with("message_id=11"));
+    CHECK(RetrySpool::get().total() == 0);
+
+    // Without a spool the preview of a failed screenshot is deleted
+    server.clear();
+    g_failEdits = true;
+    writeTelegramConfig(server, 0);
+    {
+        UploadScheduler scheduler(hooks(), settings);
+        capture(scheduler, third);
+    }
+    const auto deletes = targets(server, "/deleteMessage");
+    CHECK(deletes.size() == 1 && deletes[0].ends_with("message_id=12"));
+
+    // A newline in the game name is escaped in the media description
+    server.clear();
+    g_failEdits = false;
+    CircuitBreaker::get().reset();
+    const std::string tid = "0123456789ABCDEF0123456789ABCDEF";
+    const std::string named =
+        "img:/2026/10/19/2026101912000300-" + tid + ".jpg";
+    writeFile(named, screenshot(4));
+    writeTitleIndex(tid, "Line one\nLine two");
+    {
+        UploadScheduler scheduler(hooks(), settings);
+        capture(scheduler, named);
+    }
+    bool escaped = false;
+    for (const auto& request : server.requests()) {
+        if (request.target.find("/editMessageMedia") != std::string::npos) {
+            escaped = request.body.find(R"("caption":"Line one\nLine two")") !=
+                      std::string::npos;
+        }
+    }
+    CHECK(escaped);
+    CHECK(RetrySpool::get().total() == 0);
+
+    return testExitCode();
+}
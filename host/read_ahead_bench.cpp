@@ -0,0 +1,122 @@
+// Read-ahead against synchronous reads with a slowed file source. The file
+// is read through fopencookie() with a latency per read request and a
+// transfer rate, like the SD card, and uploadReadFunction() is drained
+// by a sink that sends buffer-sized chunks at a fixed rate, like curl
+// on a socket. Synchronous reads take the sum of both times, read-ahead
+// about the larger one. The stdio buffer splits reads into requests of the
+// same size in both modes, so only the overlap differs. Prints one
+// "[bench] read_ahead=..." line per mode.
+//
+// Usage: read_ahead_bench [MB] [source MB/s] [latency us] [sink MB/s]
+// Defaults: 4MB, 20MB/s with 1ms per request, sent at 6MB/s
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "bandwidth.hpp"
+#include "test_support.hpp"
+#include "upload_stream.hpp"
+
+namespace {
+constexpr size_t MB = 1024 * 1024;
+// curl's upload buffer of movie transfers
+constexpr size_t SINK_CHUNK = 0x2000;
+
+struct SourceSpeed {
+    size_t rate;    // bytes/s
+    u64 latencyNs;  // per read request
+};
+
+struct SlowSource {
+    const std::string* data;
+    size_t offset;
+    SourceSpeed speed;
+    size_t requests;
+};
+
+ssize_t slowRead(void* cookie, char* buffer, size_t size) {
+    auto* source = static_cast<SlowSource*>(cookie);
+    const size_t bytes =
+        std::min(size, source->data->size() - source->offset);
+    std::copy_n(source->data->data() + source->offset, bytes, buffer);
+    source->offset += bytes;
+    ++source->requests;
+    svcSleepThread(static_cast<s64>(source->speed.latencyNs +
+                                    bytes * 1'000'000'000ULL /
+                                        source->speed.rate));
+    return static_cast<ssize_t>(bytes);
+}
+
+int slowSeek(void* cookie, off64_t* position, int whence) {
+    auto* source = static_cast<SlowSource*>(cookie);
+    if (whence == SEEK_SET) {
+        source->offset = static_cast<size_t>(*position);
+    } else if (whence == SEEK_CUR) {
+        source->offset += static_cast<size_t>(*position);
+    } else {
+        source->offset = source->data->size();
+    }
+    *position = static_cast<off64_t>(source->offset);
+    return 0;
+}
+
+// Drain one upload of `data` and return the elapsed milliseconds
+double upload(const std::string& data, SourceSpeed speed, size_t sinkRate,
+              TrafficClass cls) {
+    SlowSource source{&data, 0, speed, 0};
+    FILE* f = fopencookie(&source, "rb",
+                          {slowRead, nullptr, slowSeek, nullptr});
+    UploadInfo ui{f, data.size(), cls};
+
+    std::vector<char> chunk(SINK_CHUNK);
+    std::string received;
+    received.reserve(data.size());
+    const u64 start = armGetSystemTick();
+    size_t got = 0;
+    while ((got = uploadReadFunction(chunk.data(), 1, chunk.size(), &ui)) >
+           0) {
+        received.append(chunk.data(), got);
+        // Sending takes as long as the sink's rate allows
+        svcSleepThread(static_cast<s64>(got * 1'000'000'000ULL / sinkRate));
+    }
+    const double ms = msSince(start);
+    const bool readAhead = ui.readAhead;
+    stopReadAhead(ui);
+    std::fclose(f);
+
+    CHECK(received == data);
+    std::printf(
+        "[bench] read_ahead=%s bytes=%zu ms=%.0f mbps=%.1f requests=%zu\n",
+        readAhead ? "on" : "off", data.size(), ms,
+        static_cast<double>(data.size()) / MB / (ms / 1000.0),
+        source.requests);
+    return ms;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    enterScratchDir("read_ahead_bench");
+    BandwidthLimiter::get().configure(0, 0);
+
+    const auto arg = [&](int index, size_t fallback) -> size_t {
+        return argc > index ? std::strtoul(argv[index], nullptr, 10)
+                            : fallback;
+    };
+    const size_t size = arg(1, 4) * MB;
+    const SourceSpeed speed{arg(2, 20) * MB, arg(3, 1000) * 1000};
+    const size_t sinkRate = arg(4, 6) * MB;
+
+    const std::string data = randomBytes(size);
+    const double direct =
+        upload(data, speed, sinkRate, TrafficClass::Screenshot);
+    const double ahead = upload(data, speed, sinkRate, TrafficClass::Movie);
+
+    // Reading and sending take about as long by default, overlapping them
+    // must save a good part of the time
+    CHECK(ahead < direct * 0.75);
+    std::printf("[bench] read_ahead speedup=%.2f\n", direct / ahead);
+    return testExitCode();
+}
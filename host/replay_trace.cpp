@@ -0,0 +1,652 @@
+// Replays a trace recorded on the console (trace.bin, see trace.hpp)
+// through UploadScheduler, the upload thread's loop, on virtual time. The
+// queue, batch lingering, retries, circuit breakers and the retry spool
+// are the ones in src/; only the album scanner and the network are
+// stand-ins. Captures are handed over at the first album check after
+// their recorded detection, and every destination answers with its
+// recorded outcomes in order: a transfer takes its recorded overhead plus
+// the replayed size at the destination's median throughput. Boots replay
+// one after another, each with an empty queue and closed circuits, while
+// the spool carries over like it does on the SD card.
+//
+// Usage: replay_trace [trace.bin] [--check-interval S] [--linger-ms MS]
+//                     [--spool N] [--telegram-mode MODE]
+//
+// Without a trace, a synthetic trace of two boots is replayed with and
+// without lingering and the results are checked.
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "circuit.hpp"
+#include "clock.hpp"
+#include "config.hpp"
+#include "logger.hpp"
+#include "scheduler.hpp"
+#include "spool.hpp"
+#include "test_support.hpp"
+#include "trace.hpp"
+
+namespace {
+constexpr u64 NS_PER_MS = 1'000'000ULL;
+// The scanner's interval while a batch lingers, see album_scanner.cpp
+constexpr u64 FAST_SCAN_MS = 100;
+// Throughput assumed for destinations without a large recorded transfer
+constexpr double FALLBACK_THROUGHPUT = 1 << 20;  // bytes/s
+constexpr uint32_t MIN_THROUGHPUT_SAMPLE = 1 << 16;
+
+struct Capture {
+    uint32_t timeMs;  // Since its boot
+    uint32_t size;
+    bool isMovie;
+};
+
+struct Outcome {
+    uint32_t size;
+    uint32_t latencyMs;
+    uint16_t status;
+};
+
+struct Boot {
+    uint32_t startMs{0};
+    uint32_t endMs{0};  // Last record
+    uint32_t epoch{0};
+    std::vector<Capture> captures;
+};
+
+struct Trace {
+    std::vector<Boot> boots;
+    std::array<std::vector<Outcome>, DESTINATION_COUNT> outcomes;
+};
+
+struct Options {
+    int checkInterval{ConfigDefaults::CHECK_INTERVAL_SECONDS};
+    int lingerMs{ConfigDefaults::BATCH_LINGER_MS};
+    int spool{ConfigDefaults::SPOOL_MAX_ITEMS};
+    std::string telegramMode{ConfigDefaults::TELEGRAM_UPLOAD_MODE};
+};
+
+struct Results {
+    size_t captures{0};
+    size_t movies{0};
+    std::vector<double> latencies;  // Seconds, of delivered captures
+    size_t transfers{0};
+    size_t failed{0};
+    size_t skipped{0};  // Attempts refused by an open circuit
+    size_t batches{0};  // Requests carrying several files
+    double bytesSent{0};
+    std::vector<size_t> spooledAtBoot;  // Left over from the boot before
+    size_t spoolLeft{0};
+};
+
+[[nodiscard]] std::optional<Trace> loadTrace(const std::string& path) {
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        std::perror(path.c_str());
+        return std::nullopt;
+    }
+    TraceHeader header{};
+    if (std::fread(&header, sizeof(header), 1, f) != 1 ||
+        header.magic != TRACE_MAGIC || header.version != TRACE_VERSION ||
+        header.recordSize != sizeof(TraceRecord)) {
+        std::fprintf(stderr, "%s is not a version %u trace\n", path.c_str(),
+                     TRACE_VERSION);
+        std::fclose(f);
+        return std::nullopt;
+    }
+
+    Trace trace;
+    TraceRecord record{};
+    while (std::fread(&record, sizeof(record), 1, f) == 1) {
+        if (record.kind == TraceKind::Boot) {
+            trace.boots.push_back(Boot{record.timeMs, record.timeMs,
+                                       record.size, {}});
+            continue;
+        }
+        // Every trace starts with a boot record
+        if (trace.boots.empty()) continue;
+        Boot& boot = trace.boots.back();
+        boot.endMs = std::max(boot.endMs, record.timeMs + record.latencyMs);
+        if (record.kind == TraceKind::Capture) {
+            boot.captures.push_back(
+                Capture{record.timeMs, record.size, record.detail == 1});
+        } else if (record.kind == TraceKind::Transfer &&
+                   record.detail < DESTINATION_COUNT) {
+            trace.outcomes[record.detail].push_back(
+                Outcome{record.size, record.latencyMs, record.status});
+        }
+    }
+    std::fclose(f);
+
+    for (Boot& boot : trace.boots) {
+        std::ranges::sort(boot.captures, {}, &Capture::timeMs);
+    }
+    return trace;
+}
+
+[[nodiscard]] bool succeeded(uint16_t status) {
+    return status == 200 || status == 204;
+}
+
+// A destination answering with its recorded outcomes, in recorded order
+class RecordedDestination {
+   public:
+    void load(std::vector<Outcome> outcomes) {
+        m_outcomes = std::move(outcomes);
+        m_next = 0;
+        std::vector<double> rates;
+        for (const Outcome& o : m_outcomes) {
+            if (succeeded(o.status) && o.size >= MIN_THROUGHPUT_SAMPLE &&
+                o.latencyMs > 0) {
+                rates.push_back(o.size * 1000.0 / o.latencyMs);
+            }
+        }
+        m_throughput = FALLBACK_THROUGHPUT;
+        if (!rates.empty()) {
+            const auto mid = rates.begin() + rates.size() / 2;
+            std::ranges::nth_element(rates, mid);
+            m_throughput = *mid;
+        }
+    }
+
+    [[nodiscard]] bool recorded() const { return !m_outcomes.empty(); }
+    [[nodiscard]] size_t count() const { return m_outcomes.size(); }
+    [[nodiscard]] double throughput() const { return m_throughput; }
+
+    // Answer an attempt to send `size` bytes, returns the outcome and how
+    // long the transfer takes
+    std::pair<Outcome, u64> attempt(size_t size) {
+        const Outcome o = m_outcomes[m_next++ % m_outcomes.size()];
+        if (!succeeded(o.status)) {
+            return {o, o.latencyMs};
+        }
+        // Keep the recorded overhead, replace the transfer time
+        const double overhead =
+            std::max(o.latencyMs - o.size * 1000.0 / m_throughput, 0.0);
+        return {o, static_cast<u64>(overhead +
+                                    static_cast<double>(size) * 1000.0 /
+                                        m_throughput)};
+    }
+
+   private:
+    std::vector<Outcome> m_outcomes;
+    size_t m_next{0};
+    double m_throughput{FALLBACK_THROUGHPUT};
+};
+
+// State of a replay, the scheduler hooks are plain functions
+struct Replay {
+    std::array<RecordedDestination, DESTINATION_COUNT> destinations;
+    const Boot* boot{nullptr};
+    std::vector<std::string> paths;  // Of the captures of `boot`
+    size_t nextCapture{0};
+    u64 offsetTick{0};  // Virtual time of the boot's zero
+    u64 checkIntervalMs{0};
+    bool fastScan{false};
+    // Capture time and first delivery of every path, virtual ticks
+    std::map<std::string, std::pair<u64, u64>, std::less<>> delivered;
+    Results results;
+};
+Replay g_replay;
+
+[[nodiscard]] u64 bootTick(uint32_t ms) {
+    return g_replay.offsetTick + armNsToTicks(ms * NS_PER_MS);
+}
+
+// First album check at or after `tick`, checks run every interval since
+// the boot, or every FAST_SCAN_MS while a batch lingers
+[[nodiscard]] u64 nextCheck(u64 tick) {
+    const u64 intervalMs =
+        g_replay.fastScan ? FAST_SCAN_MS : g_replay.checkIntervalMs;
+    const u64 interval = armNsToTicks(intervalMs * NS_PER_MS);
+    const u64 since = tick - g_replay.offsetTick;
+    return g_replay.offsetTick + (since + interval - 1) / interval * interval;
+}
+
+// Last album check at or before now
+[[nodiscard]] u64 lastCheck() {
+    const u64 now = Clock::get().tick();
+    const u64 next = nextCheck(now);
+    if (next == now) return now;
+    const u64 intervalMs =
+        g_replay.fastScan ? FAST_SCAN_MS : g_replay.checkIntervalMs;
+    return next - armNsToTicks(intervalMs * NS_PER_MS);
+}
+
+[[nodiscard]] bool captureDetected() {
+    const Boot& boot = *g_replay.boot;
+    return g_replay.nextCapture < boot.captures.size() &&
+           bootTick(boot.captures[g_replay.nextCapture].timeMs) <=
+               lastCheck();
+}
+
+std::optional<CaptureItem> popCapture() {
+    if (!captureDetected()) {
+        return std::nullopt;
+    }
+    const size_t index = g_replay.nextCapture++;
+    const Capture& capture = g_replay.boot->captures[index];
+    return CaptureItem{g_replay.paths[index], capture.size, capture.isMovie,
+                       nextCheck(bootTick(capture.timeMs))};
+}
+
+void waitForCapture(u64 timeoutNs) {
+    const u64 now = Clock::get().tick();
+    u64 until = now + armNsToTicks(timeoutNs);
+    const Boot& boot = *g_replay.boot;
+    if (g_replay.nextCapture < boot.captures.size()) {
+        const u64 detected =
+            nextCheck(bootTick(boot.captures[g_replay.nextCapture].timeMs));
+        until = std::clamp(detected, now, until);
+    }
+    Clock::get().sleep(armTicksToNs(until - now));
+}
+
+// Draw the outcome of sending `files` to `dest`. Returns how long the
+// transfer takes; finishTransfer() books it once that time has passed.
+[[nodiscard]] std::pair<Outcome, u64> startTransfer(
+    Destination dest, std::span<const UploadFile> files) {
+    size_t size = 0;
+    for (const auto& file : files) {
+        size += file.size;
+    }
+    return g_replay.destinations[static_cast<size_t>(dest)].attempt(size);
+}
+
+bool finishTransfer(Destination dest, std::span<const UploadFile> files,
+                    const Outcome& outcome) {
+    CircuitBreaker::get().record(
+        dest, serviceFailed(outcome.status != 0, outcome.status));
+
+    size_t size = 0;
+    for (const auto& file : files) {
+        size += file.size;
+    }
+    Results& results = g_replay.results;
+    ++results.transfers;
+    results.batches += files.size() > 1 ? 1 : 0;
+    const bool ok = succeeded(outcome.status);
+    results.bytesSent += static_cast<double>(
+        ok ? size : std::min<size_t>(size, outcome.size));
+    if (!ok) {
+        ++results.failed;
+        return false;
+    }
+    for (const auto& file : files) {
+        auto& delivery = g_replay.delivered.find(file.path)->second;
+        delivery.second = std::min(delivery.second, Clock::get().tick());
+    }
+    return true;
+}
+
+[[nodiscard]] bool circuitAllows(Destination dest) {
+    if (CircuitBreaker::get().allows(dest)) {
+        return true;
+    }
+    ++g_replay.results.skipped;
+    return false;
+}
+
+// One transfer of `files` to `dest`, false when it failed
+bool transfer(Destination dest, std::span<const UploadFile> files) {
+    if (!circuitAllows(dest)) {
+        return false;
+    }
+    const auto [outcome, ms] = startTransfer(dest, files);
+    Clock::get().sleep(ms * NS_PER_MS);
+    return finishTransfer(dest, files, outcome);
+}
+
+bool sendOne(Destination dest, std::string_view path, size_t size) {
+    const UploadFile file{path, size};
+    return transfer(dest, std::span(&file, 1));
+}
+
+SchedulerHooks replayHooks() {
+    return SchedulerHooks{
+        .popCapture = popCapture,
+        .capturePending = captureDetected,
+        .setFastScan = [](bool fast) { g_replay.fastScan = fast; },
+        .waitForCapture = waitForCapture,
+        .telegram =
+            [](std::string_view path, size_t size, bool, ContentDigest*) {
+                return sendOne(Destination::Telegram, path, size);
+            },
+        // Both copies go out together
+        .telegramBoth =
+            [](std::string_view path, size_t size, ContentDigest*) {
+                const UploadFile file{path, size};
+                const std::span files(&file, 1);
+                if (!circuitAllows(Destination::Telegram)) {
+                    return TelegramBothResult{};
+                }
+                const auto [compressed, compressedMs] =
+                    startTransfer(Destination::Telegram, files);
+                const auto [original, originalMs] =
+                    startTransfer(Destination::Telegram, files);
+                Clock::get().sleep(std::max(compressedMs, originalMs) *
+                                   NS_PER_MS);
+                return TelegramBothResult{
+                    finishTransfer(Destination::Telegram, files, compressed),
+                    finishTransfer(Destination::Telegram, files, original)};
+            },
+        .telegramBatch =
+            [](std::span<const UploadFile> files, bool,
+               std::span<ContentDigest>) {
+                return transfer(Destination::Telegram, files);
+            },
+        .ntfy =
+            [](std::string_view path, size_t size, ContentDigest*) {
+                return sendOne(Destination::Ntfy, path, size);
+            },
+        .discord =
+            [](std::string_view path, size_t size, ContentDigest*) {
+                return sendOne(Destination::Discord, path, size);
+            },
+        .discordBatch =
+            [](std::span<const UploadFile> files, std::span<ContentDigest>) {
+                return transfer(Destination::Discord, files);
+            },
+        .s3 =
+            [](std::string_view path, size_t size, ContentDigest*) {
+                return sendOne(Destination::S3, path, size);
+            },
+        // Recorded transfers are uploads only, nothing spools a delivery
+        .deliver = [](Destination, std::string_view, std::string_view,
+                      std::string_view, std::string_view) { return true; },
+    };
+}
+
+// Enable the recorded destinations, the credentials only have to pass
+// validation
+void writeReplayConfig(const Options& options) {
+    const auto& d = g_replay.destinations;
+    const auto flag = [&](Destination dest) {
+        return d[static_cast<size_t>(dest)].recorded() ? "true" : "false";
+    };
+    std::string ini = "[general]\n";
+    ini += "telegram = " + std::string(flag(Destination::Telegram)) + "\n";
+    ini += "ntfy = " + std::string(flag(Destination::Ntfy)) + "\n";
+    ini += "discord = " + std::string(flag(Destination::Discord)) + "\n";
+    ini += "s3 = " + std::string(flag(Destination::S3)) + "\n";
+    ini += "check_interval = " + std::to_string(options.checkInterval) + "\n";
+    ini += "batch_linger_ms = " + std::to_string(options.lingerMs) + "\n";
+    ini += "spool_max_items = " + std::to_string(options.spool) + "\n";
+    ini += "skip_duplicates = false\n";
+    ini += "[telegram]\nbot_token = 1:replay\nchat_id = 1\nupload_mode = " +
+           options.telegramMode + "\n";
+    ini += "[ntfy]\ntopic = replay\n";
+    ini += "[discord]\nbot_token = replay\nchannel_id = 1\n";
+    ini += "[s3]\nendpoint = https://replay.invalid\nbucket = replay\n"
+           "access_key = replay\nsecret_key = replay\n";
+    writeConfig(ini);
+}
+
+// Album paths sort like real ones: by boot, then by capture time
+[[nodiscard]] std::string capturePath(size_t bootIndex, size_t index,
+                                      const Capture& capture) {
+    std::array<char, 128> path;
+    std::snprintf(path.data(), path.size(), "img:/replay/%02zu/%010u-%05zu.%s",
+                  bootIndex, capture.timeMs, index,
+                  capture.isMovie ? "mp4" : "jpg");
+    return path.data();
+}
+
+// Sparse files, so the spool finds its captures without disk space
+void createCaptures(size_t bootIndex, const Boot& boot) {
+    namespace fs = std::filesystem;
+    g_replay.paths.clear();
+    for (size_t i = 0; i < boot.captures.size(); ++i) {
+        const Capture& capture = boot.captures[i];
+        std::string path = capturePath(bootIndex, i, capture);
+        writeFile(path, {});
+        fs::resize_file(path, capture.size);
+        g_replay.delivered[path] = {bootTick(capture.timeMs), UINT64_MAX};
+        g_replay.paths.push_back(std::move(path));
+        ++g_replay.results.captures;
+        g_replay.results.movies += capture.isMovie ? 1 : 0;
+    }
+}
+
+[[nodiscard]] Results replay(const Trace& trace, const Options& options) {
+    enterScratchDir("replay_trace");
+    g_replay = Replay{};
+    for (size_t i = 0; i < DESTINATION_COUNT; ++i) {
+        g_replay.destinations[i].load(trace.outcomes[i]);
+    }
+    writeReplayConfig(options);
+    if (!Config::get().refresh()) {
+        std::fprintf(stderr, "Invalid replay settings\n");
+        std::exit(1);
+    }
+    Logger::get().setLevel(LogLevel::WARN);
+
+    // Settings as main() takes them from the config
+    const SchedulerSettings settings{
+        .telegramUploadMode = Config::get().getTelegramUploadMode(),
+        .checkIntervalNs =
+            static_cast<u64>(Config::get().getCheckIntervalSeconds()) *
+            1'000'000'000ULL,
+        .batchLingerNs =
+            static_cast<u64>(Config::get().getBatchLingerMs()) * NS_PER_MS,
+        .networkIdleNs = 0,
+    };
+    g_replay.checkIntervalMs =
+        static_cast<u64>(Config::get().getCheckIntervalSeconds()) * 1000;
+
+    Clock::get().setVirtual(0);
+    for (size_t b = 0; b < trace.boots.size(); ++b) {
+        const Boot& boot = trace.boots[b];
+        // Restarted: nothing queued, circuits closed, the spool is on disk
+        g_replay.boot = &boot;
+        g_replay.nextCapture = 0;
+        g_replay.offsetTick = Clock::get().tick();
+        Clock::get().setVirtual(bootTick(boot.startMs));
+        createCaptures(b, boot);
+        CircuitBreaker::get().reset();
+        RetrySpool::get().load(
+            static_cast<size_t>(Config::get().getSpoolMaxItems()));
+        g_replay.results.spooledAtBoot.push_back(RetrySpool::get().total());
+
+        UploadScheduler scheduler(replayHooks(), settings);
+        while (g_replay.nextCapture < boot.captures.size() ||
+               !scheduler.queue().empty() ||
+               Clock::get().tick() < bootTick(boot.endMs)) {
+            scheduler.runOnce();
+        }
+    }
+
+    Results results = g_replay.results;
+    for (const auto& [path, times] : g_replay.delivered) {
+        if (times.second != UINT64_MAX) {
+            results.latencies.push_back(
+                static_cast<double>(armTicksToNs(times.second - times.first)) /
+                1e9);
+        }
+    }
+    std::ranges::sort(results.latencies);
+    results.spoolLeft = RetrySpool::get().total();
+    Logger::get().close();
+    return results;
+}
+
+[[nodiscard]] double percentile(const std::vector<double>& sorted,
+                                double fraction) {
+    if (sorted.empty()) return 0;
+    const auto index = static_cast<size_t>(sorted.size() * fraction);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+void printResults(const Trace& trace, const Results& results) {
+    std::string started = "unknown";
+    if (!trace.boots.empty() && trace.boots.front().epoch != 0) {
+        const std::time_t epoch = trace.boots.front().epoch;
+        std::tm utc{};
+        gmtime_r(&epoch, &utc);
+        std::array<char, 32> text;
+        std::strftime(text.data(), text.size(), "%Y-%m-%d %H:%M UTC", &utc);
+        started = text.data();
+    }
+    std::printf("Boots:        %zu, first %s\n", trace.boots.size(),
+                started.c_str());
+    std::printf("Captures:     %zu (%zu movies), %zu delivered\n",
+                results.captures, results.movies, results.latencies.size());
+    std::printf("Destinations:");
+    for (size_t i = 0; i < DESTINATION_COUNT; ++i) {
+        const auto& dest = g_replay.destinations[i];
+        if (!dest.recorded()) continue;
+        std::printf(" %s (%zu recorded, %.0f KB/s)",
+                    destinationName(static_cast<Destination>(i)).data(),
+                    dest.count(), dest.throughput() / 1024);
+    }
+    std::printf("\n");
+    std::printf("Latency (s):  median %.1f, p90 %.1f, max %.1f\n",
+                percentile(results.latencies, 0.5),
+                percentile(results.latencies, 0.9),
+                results.latencies.empty() ? 0 : results.latencies.back());
+    std::printf(
+        "Sent:         %.1f MB in %zu transfers (%zu batched), %zu failed, "
+        "%zu skipped by an open circuit\n",
+        results.bytesSent / (1 << 20), results.transfers, results.batches,
+        results.failed, results.skipped);
+    std::printf("Spool:        %zu left",  results.spoolLeft);
+    for (size_t i = 1; i < results.spooledAtBoot.size(); ++i) {
+        std::printf(", %zu at boot %zu", results.spooledAtBoot[i], i + 1);
+    }
+    std::printf("\n");
+}
+
+// Two boots whose clocks overlap: a screenshot every 20s, a burst of four
+// and a movie, Telegram failing for a while and ntfy always answering.
+// Written as a trace file and loaded like a recorded one.
+[[nodiscard]] Trace syntheticTrace() {
+    std::vector<TraceRecord> records;
+    const auto boot = [&](uint32_t ms, uint32_t epoch) {
+        records.push_back(TraceRecord{ms, epoch, 0, 0, TraceKind::Boot, 0});
+    };
+    const auto capture = [&](uint32_t ms, uint32_t size, bool isMovie) {
+        records.push_back(TraceRecord{ms, size, 0, 0, TraceKind::Capture,
+                                      static_cast<uint8_t>(isMovie)});
+    };
+    const auto transfer = [&](uint32_t ms, Destination dest, uint32_t size,
+                              uint32_t latencyMs, uint16_t status) {
+        records.push_back(TraceRecord{ms, size, latencyMs, status,
+                                      TraceKind::Transfer,
+                                      static_cast<uint8_t>(dest)});
+    };
+    constexpr uint32_t SHOT = 400 * 1024;
+
+    boot(20'000, 1'792'000'000);
+    for (uint32_t i = 0; i < 10; ++i) {
+        capture(30'000 + i * 20'000, SHOT, false);
+        transfer(30'500 + i * 20'000, Destination::Telegram, SHOT, 900, 200);
+    }
+    for (uint32_t i = 0; i < 4; ++i) {
+        capture(250'000 + i * 300, SHOT, false);
+    }
+    capture(260'000, 8 << 20, true);
+    transfer(251'000, Destination::Telegram, SHOT, 900, 200);
+    transfer(252'000, Destination::Telegram, SHOT, 900, 200);
+    // Enough failures in a row to open the circuit
+    for (uint32_t i = 0; i < 4; ++i) {
+        transfer(253'000 + i * 15'000, Destination::Telegram, 0, 15'000, 0);
+    }
+    transfer(320'000, Destination::Telegram, SHOT, 800, 502);
+    transfer(399'000, Destination::Ntfy, SHOT, 1'200, 200);
+
+    boot(15'000, 1'792'010'000);
+    for (uint32_t i = 0; i < 5; ++i) {
+        capture(25'000 + i * 20'000, SHOT, false);
+    }
+    transfer(199'000, Destination::Ntfy, SHOT, 1'200, 200);
+
+    enterScratchDir("replay_trace");
+    FILE* f = std::fopen("synthetic.bin", "wb");
+    const TraceHeader header{TRACE_MAGIC, TRACE_VERSION, sizeof(TraceRecord),
+                             0};
+    std::fwrite(&header, sizeof(header), 1, f);
+    std::fwrite(records.data(), sizeof(TraceRecord), records.size(), f);
+    std::fclose(f);
+    return loadTrace("synthetic.bin").value_or(Trace{});
+}
+
+void checkSynthetic() {
+    const Trace trace = syntheticTrace();
+    CHECK(trace.boots.size() == 2);
+    if (trace.boots.size() != 2) return;
+    CHECK(trace.boots[0].captures.size() == 15);
+    CHECK(trace.boots[1].captures.size() == 5);
+    CHECK(trace.boots[1].endMs == 200'200);
+
+    Options plain;
+    plain.lingerMs = 0;
+    const Results direct = replay(trace, plain);
+    printResults(trace, direct);
+
+    // ntfy always answers, so every capture arrives somewhere
+    CHECK(direct.captures == 20);
+    CHECK(direct.latencies.size() == direct.captures);
+    // The failures open Telegram's circuit, later attempts are refused
+    // without a transfer until the cooldown
+    CHECK(direct.failed >= CircuitBreaker::FAILURE_THRESHOLD);
+    CHECK(direct.skipped > 0);
+    CHECK(direct.batches == 0);
+    // What Telegram missed in the first boot waits in the spool and is
+    // retried in the second
+    CHECK(direct.spooledAtBoot.size() == 2);
+    CHECK(direct.spooledAtBoot.back() > 0);
+    CHECK(direct.spoolLeft < direct.spooledAtBoot.back());
+
+    Options linger;
+    linger.lingerMs = 2000;
+    const Results batched = replay(trace, linger);
+    printResults(trace, batched);
+
+    // The burst goes out as one Telegram request
+    CHECK(batched.latencies.size() == batched.captures);
+    CHECK(batched.batches > 0);
+    CHECK(batched.transfers < direct.transfers);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        checkSynthetic();
+        return testExitCode();
+    }
+
+    Options options;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        const std::string_view name = argv[i];
+        const char* value = argv[i + 1];
+        if (name == "--check-interval") {
+            options.checkInterval = std::atoi(value);
+        } else if (name == "--linger-ms") {
+            options.lingerMs = std::atoi(value);
+        } else if (name == "--spool") {
+            options.spool = std::atoi(value);
+        } else if (name == "--telegram-mode") {
+            options.telegramMode = value;
+        } else {
+            std::fprintf(stderr, "Unknown option %s\n", name.data());
+            return 1;
+        }
+    }
+
+    const auto trace = loadTrace(argv[1]);
+    if (!trace.has_value()) {
+        return 1;
+    }
+    printResults(*trace, replay(*trace, options));
+    return 0;
+}
@@ -0,0 +1,590 @@
+// sendFileToS3() against an S3 stand-in: a TestServer that speaks the
+// object and multipart API used by the uploader and checks every request's
+// AWS Signature Version 4 with OpenSSL, independently of src/sigv4.cpp.
+// Requests reach it through nghttpx as TLS, over HTTP/1.1, where two parts
+// run at once on two connections, and over h2. The heap used by the
+// uploading thread during a multipart upload is reported as a
+// "[bench] ..." line. Skipped when nghttpx or openssl is missing.
+
+#include <malloc.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/sha.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "config.hpp"
+#include "http.hpp"
+#include "network.hpp"
+#include "test_support.hpp"
+#include "upload.hpp"
+
+// Track the heap used by the thread that uploads. The stand-in server runs
+// on its own threads and stores whole objects, so it isn't counted.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace {
+thread_local bool t_counted = false;
+std::atomic<long> g_live{0};
+std::atomic<long> g_peak{0};
+
+void allocated(void* ptr) {
+    if (!t_counted || ptr == nullptr) return;
+    const long live = g_live += static_cast<long>(malloc_usable_size(ptr));
+    long peak = g_peak.load();
+    while (live > peak && !g_peak.compare_exchange_weak(peak, live)) {
+    }
+}
+
+void released(void* ptr) {
+    if (!t_counted || ptr == nullptr) return;
+    g_live -= static_cast<long>(malloc_usable_size(ptr));
+}
+}  // namespace
+
+extern "C" {
+void* malloc(size_t size) {
+    void* ptr = __libc_malloc(size);
+    allocated(ptr);
+    return ptr;
+}
+void* calloc(size_t count, size_t size) {
+    void* ptr = __libc_calloc(count, size);
+    allocated(ptr);
+    return ptr;
+}
+void* realloc(void* ptr, size_t size) {
+    released(ptr);
+    void* grown = __libc_realloc(ptr, size);
+    allocated(grown != nullptr ? grown : ptr);
+    return grown;
+}
+void free(void* ptr) {
+    released(ptr);
+    __libc_free(ptr);
+}
+}
+
+namespace {
+// ctest treats this exit code as skipped, see SKIP_RETURN_CODE
+constexpr int EXIT_SKIP = 77;
+constexpr size_t MB = 1024 * 1024;
+
+constexpr std::string_view BUCKET = "captures";
+constexpr std::string_view ACCESS_KEY = "AKIDEXAMPLE";
+constexpr std::string_view SECRET_KEY =
+    "wJalrXUtnFEMI/K7MDENG+bPxRfiCYEXAMPLEKEY";
+constexpr std::string_view REGION = "eu-central-1";
+// Needs encoding in queries, like the ids of some S3 implementations
+constexpr std::string_view UPLOAD_ID = "VXBsb2Fk+SUQ/1==";
+
+std::string hex(const unsigned char* data, size_t size) {
+    static constexpr char DIGITS[] = "0123456789abcdef";
+    std::string text;
+    for (size_t i = 0; i < size; ++i) {
+        text += DIGITS[data[i] >> 4];
+        text += DIGITS[data[i] & 0xF];
+    }
+    return text;
+}
+
+std::string hmac(std::string_view key, std::string_view message) {
+    std::array<unsigned char, 32> mac{};
+    unsigned int length = 0;
+    HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+         reinterpret_cast<const unsigned char*>(message.data()),
+         message.size(), mac.data(), &length);
+    return std::string(reinterpret_cast<const char*>(mac.data()), length);
+}
+
+std::string sha256Hex(std::string_view data) {
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> hash{};
+    SHA256(reinterpret_cast<const unsigned char*>(data.data()), data.size(),
+           hash.data());
+    return hex(hash.data(), hash.size());
+}
+
+std::string uriDecode(std::string_view text) {
+    std::string out;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '%' && i + 2 < text.size()) {
+            out += static_cast<char>(
+                std::stoi(std::string(text.substr(i + 1, 2)), nullptr, 16));
+            i += 2;
+        } else {
+            out += text[i];
+        }
+    }
+    return out;
+}
+
+// URI encoding as S3 canonicalizes it, unreserved characters stay
+std::string uriEncode(std::string_view text) {
+    std::string out;
+    for (const char c : text) {
+        const auto u = static_cast<unsigned char>(c);
+        if (std::isalnum(u) || c == '-' || c == '_' || c == '.' || c == '~') {
+            out += c;
+        } else {
+            char escaped[4];
+            std::snprintf(escaped, sizeof(escaped), "%%%02X", u);
+            out += escaped;
+        }
+    }
+    return out;
+}
+
+std::vector<std::string_view> split(std::string_view text, char separator) {
+    std::vector<std::string_view> parts;
+    size_t start = 0;
+    while (start <= text.size()) {
+        const size_t end = std::min(text.find(separator, start), text.size());
+        parts.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    return parts;
+}
+
+std::string between(std::string_view text, std::string_view open,
+                    std::string_view close, size_t from = 0) {
+    const size_t start = text.find(open, from);
+    if (start == std::string_view::npos) return {};
+    const size_t end = text.find(close, start + open.size());
+    if (end == std::string_view::npos) return {};
+    return std::string(text.substr(start + open.size(),
+                                   end - start - open.size()));
+}
+
+HttpResponse s3Error(int status, std::string_view code) {
+    HttpResponse response;
+    response.status = status;
+    response.body = "<Error><Code>" + std::string(code) +
+                    "</Code><Message>stand-in</Message></Error>";
+    return response;
+}
+
+/**
+ * Path-style bucket of the stand-in. Handles single PUTs and multipart
+ * uploads, and fails chosen parts to exercise retries and aborts.
+ */
+class S3Bucket {
+   public:
+    HttpResponse handle(const HttpRequest& request) {
+        const std::lock_guard lock(m_mutex);
+        if (!signatureValid(request)) {
+            return s3Error(403, "SignatureDoesNotMatch");
+        }
+
+        const size_t queryStart = request.target.find('?');
+        const std::string path = request.target.substr(0, queryStart);
+        const std::string query = queryStart == std::string::npos
+                                      ? std::string{}
+                                      : request.target.substr(queryStart + 1);
+        const std::string prefix = "/" + std::string(BUCKET) + "/";
+        if (!path.starts_with(prefix)) return s3Error(404, "NoSuchBucket");
+        const std::string key = uriDecode(path.substr(prefix.size()));
+        std::map<std::string, std::string> params;
+        if (!query.empty()) {
+            for (const auto param : split(query, '&')) {
+                const size_t eq = param.find('=');
+                params[uriDecode(param.substr(0, eq))] =
+                    eq == std::string_view::npos
+                        ? std::string{}
+                        : uriDecode(param.substr(eq + 1));
+            }
+        }
+
+        if (request.method == "PUT" && params.empty()) {
+            m_objects[key] = request.body;
+            m_contentTypes[key] = request.header("Content-Type");
+            HttpResponse response;
+            response.body.clear();
+            response.headers.push_back({"ETag", "\"object\""});
+            return response;
+        }
+        if (request.method == "POST" && params.contains("uploads")) {
+            m_parts.clear();
+            m_uploadKey = key;
+            m_contentTypes[key] = request.header("Content-Type");
+            ++m_initiated;
+            HttpResponse response;
+            response.body =
+                "<InitiateMultipartUploadResult><Bucket>captures</Bucket>"
+                "<UploadId>" +
+                std::string(UPLOAD_ID) + "</UploadId>"
+                "</InitiateMultipartUploadResult>";
+            return response;
+        }
+        if (params["uploadId"] != UPLOAD_ID || key != m_uploadKey) {
+            return s3Error(404, "NoSuchUpload");
+        }
+        if (request.method == "PUT" && params.contains("partNumber")) {
+            const int part = std::stoi(params["partNumber"]);
+            const int attempt = ++m_attempts[part];
+            if (m_failAlways.contains(part) ||
+                (m_failOnce.contains(part) && attempt == 1)) {
+                return s3Error(500, "InternalError");
+            }
+            const std::string etag =
+                "\"" + std::to_string(part) + "-" + std::to_string(attempt) +
+                "\"";
+            m_parts[part] = {etag, request.body};
+            HttpResponse response;
+            response.body.clear();
+            response.headers.push_back({"ETag", etag});
+            return response;
+        }
+        if (request.method == "POST") {
+            return complete(key, request.body);
+        }
+        if (request.method == "DELETE") {
+            m_parts.clear();
+            m_uploadKey.clear();
+            ++m_aborted;
+            HttpResponse response;
+            response.status = 204;
+            response.body.clear();
+            return response;
+        }
+        return s3Error(400, "InvalidRequest");
+    }
+
+    void failOnce(int part) {
+        const std::lock_guard lock(m_mutex);
+        m_failOnce.insert(part);
+    }
+    void failAlways(int part) {
+        const std::lock_guard lock(m_mutex);
+        m_failAlways.insert(part);
+    }
+    void reset() {
+        const std::lock_guard lock(m_mutex);
+        m_failOnce.clear();
+        m_failAlways.clear();
+        m_attempts.clear();
+        m_parts.clear();
+        m_objects.clear();
+        m_initiated = 0;
+        m_aborted = 0;
+        m_badSignatures = 0;
+    }
+
+    [[nodiscard]] std::string object(const std::string& key) {
+        const std::lock_guard lock(m_mutex);
+        const auto it = m_objects.find(key);
+        return it == m_objects.end() ? std::string{} : it->second;
+    }
+    [[nodiscard]] std::string contentType(const std::string& key) {
+        const std::lock_guard lock(m_mutex);
+        return m_contentTypes[key];
+    }
+    [[nodiscard]] int attempts(int part) {
+        const std::lock_guard lock(m_mutex);
+        return m_attempts[part];
+    }
+    [[nodiscard]] int initiated() {
+        const std::lock_guard lock(m_mutex);
+        return m_initiated;
+    }
+    [[nodiscard]] int aborted() {
+        const std::lock_guard lock(m_mutex);
+        return m_aborted;
+    }
+    [[nodiscard]] int badSignatures() {
+        const std::lock_guard lock(m_mutex);
+        return m_badSignatures;
+    }
+
+   private:
+    struct Part {
+        std::string etag;
+        std::string body;
+    };
+
+    // Parts listed in order with the ETags handed out, assembled into the
+    // object
+    HttpResponse complete(const std::string& key, std::string_view xml) {
+        std::string body;
+        int expected = 1;
+        size_t from = 0;
+        while ((from = xml.find("<Part>", from)) != std::string_view::npos) {
+            const int number =
+                std::stoi(between(xml, "<PartNumber>", "</PartNumber>", from));
+            const std::string etag = between(xml, "<ETag>", "</ETag>", from);
+            const auto it = m_parts.find(number);
+            if (number != expected++ || it == m_parts.end() ||
+                it->second.etag != etag) {
+                return s3Error(400, "InvalidPart");
+            }
+            body += it->second.body;
+            from += 6;
+        }
+        if (expected == 1 || expected != static_cast<int>(m_parts.size()) + 1) {
+            return s3Error(400, "InvalidPart");
+        }
+        m_objects[key] = std::move(body);
+        m_parts.clear();
+        m_uploadKey.clear();
+        HttpResponse response;
+        response.body =
+            "<CompleteMultipartUploadResult><ETag>\"done\"</ETag>"
+            "</CompleteMultipartUploadResult>";
+        return response;
+    }
+
+    // Recompute the signature the way S3 does, from the request as received
+    bool signatureValid(const HttpRequest& request) {
+        const std::string authorization{request.header("Authorization")};
+        const std::string credential =
+            between(authorization, "Credential=", ",");
+        const std::string signedHeaders =
+            between(authorization, "SignedHeaders=", ",");
+        const size_t signatureAt = authorization.find("Signature=");
+        const std::string amzDate{request.header("x-amz-date")};
+        const std::vector<std::string_view> scope = split(credential, '/');
+        if (signatureAt == std::string::npos || scope.size() != 5 ||
+            scope[0] != ACCESS_KEY || scope[2] != REGION || scope[3] != "s3" ||
+            scope[4] != "aws4_request" || amzDate.size() != 16 ||
+            !amzDate.starts_with(scope[1])) {
+            ++m_badSignatures;
+            return false;
+        }
+
+        // Requests older than 15 minutes are refused
+        std::tm tm{};
+        strptime(amzDate.c_str(), "%Y%m%dT%H%M%SZ", &tm);
+        const std::time_t signedAt = timegm(&tm);
+        if (std::abs(std::difftime(std::time(nullptr), signedAt)) > 900) {
+            ++m_badSignatures;
+            return false;
+        }
+
+        const std::string_view target = request.target;
+        const size_t queryStart = target.find('?');
+        const std::string_view path = target.substr(1, queryStart - 1);
+        std::string uri;
+        for (const auto segment : split(path, '/')) {
+            uri += '/';
+            uri += uriEncode(uriDecode(segment));
+        }
+        std::vector<std::string> params;
+        if (queryStart != std::string_view::npos) {
+            const std::string_view rawQuery = target.substr(queryStart + 1);
+            for (const auto param : split(rawQuery, '&')) {
+                const size_t eq = param.find('=');
+                std::string canonical =
+                    uriEncode(uriDecode(param.substr(0, eq)));
+                canonical += '=';
+                if (eq != std::string_view::npos) {
+                    canonical += uriEncode(uriDecode(param.substr(eq + 1)));
+                }
+                params.push_back(std::move(canonical));
+            }
+        }
+        std::ranges::sort(params);
+        std::string query;
+        for (const auto& param : params) {
+            if (!query.empty()) query += '&';
+            query += param;
+        }
+
+        std::string canonical = request.method + "\n" + uri + "\n" + query +
+                                "\n";
+        for (const auto name : split(signedHeaders, ';')) {
+            canonical += std::string(name) + ":" +
+                         std::string(request.header(name)) + "\n";
+        }
+        canonical += "\n" + signedHeaders + "\n" +
+                     std::string(request.header("x-amz-content-sha256"));
+
+        const std::string_view credentialScope =
+            std::string_view(credential).substr(ACCESS_KEY.size() + 1);
+        const std::string stringToSign = "AWS4-HMAC-SHA256\n" + amzDate +
+                                         "\n" + std::string(credentialScope) +
+                                         "\n" + sha256Hex(canonical);
+        std::string key = hmac("AWS4" + std::string(SECRET_KEY), scope[1]);
+        key = hmac(key, REGION);
+        key = hmac(key, "s3");
+        key = hmac(key, "aws4_request");
+        const std::string mac = hmac(key, stringToSign);
+        const std::string expected = hex(
+            reinterpret_cast<const unsigned char*>(mac.data()), mac.size());
+        if (authorization.substr(signatureAt + 10) != expected) {
+            ++m_badSignatures;
+            return false;
+        }
+        return true;
+    }
+
+    std::mutex m_mutex;
+    std::set<int> m_failOnce;
+    std::set<int> m_failAlways;
+    std::map<int, int> m_attempts;
+    std::map<int, Part> m_parts;
+    std::string m_uploadKey;
+    std::map<std::string, std::string> m_objects;
+    std::map<std::string, std::string> m_contentTypes;
+    int m_initiated{0};
+    int m_aborted{0};
+    int m_badSignatures{0};
+};
+
+void configure(std::string_view endpoint,
+               std::string_view secretKey = SECRET_KEY) {
+    writeConfig("[general]\ns3 = true\n[s3]\nendpoint = " +
+                std::string(endpoint) + "\nregion = " + std::string(REGION) +
+                "\nbucket = " + std::string(BUCKET) +
+                "\naccess_key = " + std::string(ACCESS_KEY) +
+                "\nsecret_key = " + std::string(secretKey) +
+                "\nprefix = switch/\npart_size_mb = 5\n");
+    CHECK(Config::get().refresh());
+}
+
+// Object key of an album file with the configured prefix
+std::string keyOf(const std::string& path) {
+    return "switch/" + path.substr(std::string_view("img:/").size());
+}
+
+void singlePut(S3Bucket& bucket, const std::string& shot,
+               const std::string& content) {
+    bucket.reset();
+    CHECK(sendFileToS3(shot, content.size()));
+    CHECK(bucket.object(keyOf(shot)) == content);
+    CHECK(bucket.contentType(keyOf(shot)) == "image/jpeg");
+    CHECK(bucket.initiated() == 0);
+}
+
+// Three parts with the second failing once. The first two run in
+// parallel: on two TLS connections over HTTP/1.1, multiplexed over h2.
+void multipart(S3Bucket& bucket, TestServer& server, const char* transport,
+               const std::string& movie, const std::string& content) {
+    bucket.reset();
+    bucket.failOnce(2);
+    server.clear();
+    // Start cold, the TLS handshakes count towards the heap
+    HttpSession::get().cleanup();
+
+    g_live = 0;
+    g_peak = 0;
+    t_counted = true;
+    const u64 start = armGetSystemTick();
+    const bool uploaded = sendFileToS3(movie, content.size());
+    const double ms = msSince(start);
+    t_counted = false;
+
+    CHECK(uploaded);
+    CHECK(bucket.object(keyOf(movie)) == content);
+    CHECK(bucket.contentType(keyOf(movie)) == "video/mp4");
+    CHECK(bucket.initiated() == 1);
+    CHECK(bucket.attempts(1) == 1);
+    CHECK(bucket.attempts(2) == 2);
+    CHECK(bucket.attempts(3) == 1);
+    CHECK(bucket.aborted() == 0);
+    CHECK(bucket.badSignatures() == 0);
+
+    // Parts 1 and 2 were received at the same time
+    const auto requests = server.requests();
+    const HttpRequest* parts[2] = {nullptr, nullptr};
+    for (const auto& request : requests) {
+        for (int part = 1; part <= 2; ++part) {
+            const std::string query =
+                "partNumber=" + std::to_string(part) + "&";
+            if (request.target.find(query) != std::string::npos &&
+                parts[part - 1] == nullptr) {
+                parts[part - 1] = &request;
+            }
+        }
+    }
+    CHECK(parts[0] != nullptr && parts[1] != nullptr);
+    if (parts[0] != nullptr && parts[1] != nullptr) {
+        CHECK(parts[0]->startTick < parts[1]->doneTick &&
+              parts[1]->startTick < parts[0]->doneTick);
+    }
+
+    std::printf(
+        "[bench] s3_multipart transport=%s bytes=%zu parts=3 ms=%.0f "
+        "heap_peak_kb=%ld heap_left_kb=%ld\n",
+        transport, content.size(), ms, g_peak.load() / 1024,
+        g_live.load() / 1024);
+}
+
+// A part failing on every attempt aborts the upload
+void abortedUpload(S3Bucket& bucket, const std::string& movie,
+                   size_t size) {
+    bucket.reset();
+    bucket.failAlways(3);
+    CHECK(!sendFileToS3(movie, size));
+    CHECK(bucket.attempts(3) == 3);
+    CHECK(bucket.aborted() == 1);
+    CHECK(bucket.object(keyOf(movie)).empty());
+}
+
+void wrongSecret(S3Bucket& bucket, const std::string& endpoint,
+                 const std::string& shot, size_t size) {
+    bucket.reset();
+    configure(endpoint, "not-the-secret");
+    CHECK(!sendFileToS3(shot, size));
+    CHECK(bucket.badSignatures() > 0);
+    CHECK(bucket.object(keyOf(shot)).empty());
+    configure(endpoint);
+}
+}  // namespace
+
+int main() {
+    enterScratchDir("s3_test");
+    if (!hasTool("nghttpx") || !hasTool("openssl")) {
+        std::printf("nghttpx or openssl not found, skipping\n");
+        return EXIT_SKIP;
+    }
+    if (!trustTestCertificate()) {
+        std::printf("Unable to create a certificate, skipping\n");
+        return EXIT_SKIP;
+    }
+
+    const std::string shot = "img:/2026/10/19/2026101912000000-A.jpg";
+    const std::string movie = "img:/2026/10/19/2026101912000100-B.mp4";
+    const std::string shotContent = randomBytes(300 * 1024, 1);
+    const std::string movieContent = randomBytes(12 * MB, 2);
+    writeFile(shot, shotContent);
+    writeFile(movie, movieContent);
+
+    CHECK(startNetwork());
+    {
+        S3Bucket bucket;
+        TestServer server(
+            [&bucket](const HttpRequest& r) { return bucket.handle(r); });
+        // Slow enough for parts to overlap on the loopback
+        server.setReceiveRate(40 * MB);
+        TlsProxy proxy(server.port(), false);
+        TlsProxy h2Proxy(server.port(), true);
+
+        configure(proxy.url());
+        singlePut(bucket, shot, shotContent);
+        multipart(bucket, server, "https_http1", movie, movieContent);
+        abortedUpload(bucket, movie, movieContent.size());
+        wrongSecret(bucket, proxy.url(), shot, shotContent.size());
+
+        configure(h2Proxy.url());
+        multipart(bucket, server, "https_h2", movie, movieContent);
+
+        HttpSession::get().cleanup();
+    }
+    stopNetwork();
+    return testExitCode();
+}
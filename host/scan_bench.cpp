@@ -0,0 +1,184 @@
+// Album scan correctness and benchmark on synthetic trees. Each tree has
+// some years, months, days and files per day, plus stray entries the
+// scanner must ignore: non-digit directories, files outside day folders and
+// empty directories. getLastAlbumItem() must return the newest capture and
+// collectNewAlbumItems() every newer capture in order, then both are timed.
+// Prints one "[bench] scan=..." line per tree and scan.
+//
+// The album root is ALBUM_PATH, set with -DNXSU_ALBUM_ROOT=<dir>/ when
+// configuring. A root outside the working directory is taken to be a copy
+// of a real album: it is only timed, never written to.
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <ranges>
+#include <string>
+#include <vector>
+
+#include "logger.hpp"
+#include "test_support.hpp"
+#include "utils.hpp"
+
+namespace {
+constexpr int RUNS = 15;
+
+struct TreeShape {
+    const char* name;
+    int years;
+    int months;
+    int days;
+    int filesPerDay;
+};
+
+constexpr TreeShape SHAPES[] = {
+    {"tiny", 1, 1, 1, 3},
+    {"small", 1, 3, 10, 10},
+    {"medium", 2, 12, 10, 20},
+    {"large", 4, 12, 25, 10},
+};
+
+std::string two(int value) {
+    char text[12];
+    std::snprintf(text, sizeof(text), "%02d", value);
+    return text;
+}
+
+void touch(const std::filesystem::path& path) { writeFile(path.string(), ""); }
+
+// Build the tree below ALBUM_PATH and return its captures in album order
+std::vector<std::string> buildTree(const TreeShape& shape) {
+    namespace fs = std::filesystem;
+    const fs::path root{ALBUM_PATH};
+    std::error_code ec;
+    fs::remove_all(root, ec);
+    fs::create_directories(root);
+
+    std::vector<std::string> items;
+    for (int y = 0; y < shape.years; ++y) {
+        const std::string year = std::to_string(2020 + y);
+        for (int m = 1; m <= shape.months; ++m) {
+            for (int d = 1; d <= shape.days; ++d) {
+                const std::string day = two(m) + "/" + two(d);
+                for (int i = 0; i < shape.filesPerDay; ++i) {
+                    // 2020010112000000-0123456789ABCDEF0123456789ABCDEF.jpg
+                    const std::string name =
+                        year + two(m) + two(d) + "12" + two(i / 60) +
+                        two(i % 60) + "00-0123456789ABCDEF0123456789ABCDEF" +
+                        (i % 5 == 4 ? ".mp4" : ".jpg");
+                    const std::string path =
+                        std::string(ALBUM_PATH) + year + "/" + day + "/" + name;
+                    touch(path);
+                    items.push_back(path);
+                }
+            }
+        }
+    }
+
+    // Strays the scanner has to skip. Empty directories sort after the
+    // newest capture on every level, a deleted capture leaves them behind.
+    const std::string lastYear = std::to_string(2020 + shape.years - 1);
+    const std::string newestDay =
+        lastYear + "/" + two(shape.months) + "/" + two(shape.days);
+    fs::create_directories(root / "Extra");
+    fs::create_directories(root / "20x1");
+    fs::create_directories(root / "99999");
+    fs::create_directories(root / std::to_string(2020 + shape.years));
+    fs::create_directories(root / lastYear / "13x");
+    fs::create_directories(root / lastYear / two(shape.months + 1));
+    fs::create_directories(root / lastYear / two(shape.months) /
+                           two(shape.days + 1));
+    fs::create_directories(root / newestDay / "zz-subdir");
+    touch(root / "9999");
+    touch(root / lastYear / "99");
+    return items;
+}
+
+// Median of `RUNS` calls, in nanoseconds
+template <typename F>
+double medianNs(F&& scan) {
+    std::vector<double> samples;
+    for (int run = 0; run < RUNS; ++run) {
+        const u64 start = armGetSystemTick();
+        scan();
+        samples.push_back(msSince(start) * 1e6);
+    }
+    std::ranges::sort(samples);
+    return samples[samples.size() / 2];
+}
+
+void checkTree(const std::vector<std::string>& items) {
+    const auto last = getLastAlbumItem();
+    CHECK(last.has_value() && last.value() == items.back());
+
+    // Newer items in order, across month and year boundaries
+    std::vector<std::string> found;
+    collectNewAlbumItems(items.front(), items.size(), found);
+    CHECK(found.size() == items.size() - 1);
+    CHECK(std::ranges::equal(found, items | std::views::drop(1)));
+
+    // Reading in small steps gives the same sequence
+    std::vector<std::string> stepped;
+    std::string after = items.front();
+    while (collectNewAlbumItems(after, 7, stepped) > 0) {
+        after = stepped.back();
+    }
+    CHECK(stepped == found);
+
+    // A bare day directory starts with that day's first item
+    const std::string& first = items.front();
+    const std::string day = first.substr(0, first.rfind('/') + 1);
+    found.clear();
+    collectNewAlbumItems(day, 1, found);
+    CHECK(found.size() == 1 && found.front() == first);
+}
+
+void bench(const char* tree, size_t files) {
+    std::vector<std::string> out;
+    const double lastNs = medianNs([] {
+        static_cast<void>(getLastAlbumItem());
+    });
+    std::string newest;
+    if (auto last = getLastAlbumItem()) newest = last.value();
+
+    // The usual case: a capture or two newer than the last one
+    const double newNs = medianNs([&] {
+        out.clear();
+        collectNewAlbumItems(newest, 16, out);
+    });
+
+    std::printf("[bench] scan=last_item tree=%s files=%zu ns=%.0f\n", tree,
+                files, lastNs);
+    std::printf("[bench] scan=new_items tree=%s files=%zu ns=%.0f\n", tree,
+                files, newNs);
+}
+
+size_t countFiles(const std::filesystem::path& root) {
+    size_t files = 0;
+    for (const auto& entry :
+         std::filesystem::recursive_directory_iterator(root)) {
+        files += entry.is_regular_file() ? 1 : 0;
+    }
+    return files;
+}
+}  // namespace
+
+int main() {
+    enterScratchDir("scan_bench");
+    // Keep the per-scan [bench] log lines of timing builds out of the runs
+    Logger::get().setLevel(LogLevel::WARN);
+
+    const std::filesystem::path root{ALBUM_PATH};
+    if (root.is_absolute()) {
+        std::printf("Timing the album at %s\n", root.c_str());
+        bench("external", countFiles(root));
+        return testExitCode();
+    }
+
+    for (const auto& shape : SHAPES) {
+        const std::vector<std::string> items = buildTree(shape);
+        checkTree(items);
+        bench(shape.name, items.size());
+    }
+    return testExitCode();
+}
@@ -0,0 +1,159 @@
+// SHA-256 and HMAC-SHA256 (FIPS 180-4, RFC 2104) with the libnx interface,
+// for host builds
+
+#include <switch.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr u32 K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+constexpr u32 rotr(u32 x, int n) { return (x >> n) | (x << (32 - n)); }
+
+void processBlock(u32* h, const u8* block) {
+    u32 w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = static_cast<u32>(block[i * 4]) << 24 |
+               static_cast<u32>(block[i * 4 + 1]) << 16 |
+               static_cast<u32>(block[i * 4 + 2]) << 8 | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; ++i) {
+        const u32 s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^
+                       (w[i - 15] >> 3);
+        const u32 s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^
+                       (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    u32 a = h[0], b = h[1], c = h[2], d = h[3];
+    u32 e = h[4], f = h[5], g = h[6], k = h[7];
+    for (int i = 0; i < 64; ++i) {
+        const u32 s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+        const u32 ch = (e & f) ^ (~e & g);
+        const u32 t1 = k + s1 + ch + K[i] + w[i];
+        const u32 s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+        const u32 maj = (a & b) ^ (a & c) ^ (b & c);
+        const u32 t2 = s0 + maj;
+        k = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+    h[5] += f;
+    h[6] += g;
+    h[7] += k;
+}
+}  // namespace
+
+extern "C" {
+
+void sha256ContextCreate(Sha256Context* out) {
+    static constexpr u32 initial[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+                                       0xa54ff53a, 0x510e527f, 0x9b05688c,
+                                       0x1f83d9ab, 0x5be0cd19};
+    std::memset(out, 0, sizeof(*out));
+    std::memcpy(out->intermediate_hash, initial, sizeof(initial));
+}
+
+void sha256ContextUpdate(Sha256Context* ctx, const void* src, size_t size) {
+    const auto* data = static_cast<const u8*>(src);
+    ctx->bits_consumed += static_cast<u64>(size) * 8;
+    while (size > 0) {
+        const size_t take =
+            std::min(size, sizeof(ctx->buffer) - ctx->num_buffered);
+        std::memcpy(ctx->buffer + ctx->num_buffered, data, take);
+        ctx->num_buffered += take;
+        data += take;
+        size -= take;
+        if (ctx->num_buffered == sizeof(ctx->buffer)) {
+            processBlock(ctx->intermediate_hash, ctx->buffer);
+            ctx->num_buffered = 0;
+        }
+    }
+}
+
+void sha256ContextGetHash(Sha256Context* ctx, void* dst) {
+    if (!ctx->finalized) {
+        const u64 bits = ctx->bits_consumed;
+        ctx->buffer[ctx->num_buffered++] = 0x80;
+        if (ctx->num_buffered > sizeof(ctx->buffer) - 8) {
+            std::memset(ctx->buffer + ctx->num_buffered, 0,
+                        sizeof(ctx->buffer) - ctx->num_buffered);
+            processBlock(ctx->intermediate_hash, ctx->buffer);
+            ctx->num_buffered = 0;
+        }
+        std::memset(ctx->buffer + ctx->num_buffered, 0,
+                    sizeof(ctx->buffer) - 8 - ctx->num_buffered);
+        for (int i = 0; i < 8; ++i) {
+            ctx->buffer[56 + i] = static_cast<u8>(bits >> (56 - i * 8));
+        }
+        processBlock(ctx->intermediate_hash, ctx->buffer);
+        ctx->finalized = true;
+    }
+
+    auto* out = static_cast<u8*>(dst);
+    for (int i = 0; i < 8; ++i) {
+        const u32 word = ctx->intermediate_hash[i];
+        out[i * 4] = static_cast<u8>(word >> 24);
+        out[i * 4 + 1] = static_cast<u8>(word >> 16);
+        out[i * 4 + 2] = static_cast<u8>(word >> 8);
+        out[i * 4 + 3] = static_cast<u8>(word);
+    }
+}
+
+void sha256CalculateHash(void* dst, const void* src, size_t size) {
+    Sha256Context ctx;
+    sha256ContextCreate(&ctx);
+    sha256ContextUpdate(&ctx, src, size);
+    sha256ContextGetHash(&ctx, dst);
+}
+
+void hmacSha256CalculateMac(void* dst, const void* key, size_t key_size,
+                            const void* src, size_t src_size) {
+    constexpr size_t BLOCK_SIZE = 0x40;
+    u8 block[BLOCK_SIZE] = {};
+    if (key_size > BLOCK_SIZE) {
+        sha256CalculateHash(block, key, key_size);
+    } else {
+        std::memcpy(block, key, key_size);
+    }
+
+    u8 pad[BLOCK_SIZE];
+    u8 inner[SHA256_HASH_SIZE];
+    Sha256Context ctx;
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) pad[i] = block[i] ^ 0x36;
+    sha256ContextCreate(&ctx);
+    sha256ContextUpdate(&ctx, pad, BLOCK_SIZE);
+    sha256ContextUpdate(&ctx, src, src_size);
+    sha256ContextGetHash(&ctx, inner);
+
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) pad[i] = block[i] ^ 0x5c;
+    sha256ContextCreate(&ctx);
+    sha256ContextUpdate(&ctx, pad, BLOCK_SIZE);
+    sha256ContextUpdate(&ctx, inner, SHA256_HASH_SIZE);
+    sha256ContextGetHash(&ctx, dst);
+}
+
+}  // extern "C"
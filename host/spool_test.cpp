@@ -0,0 +1,78 @@
+// RetrySpool entries: plain paths from older spools and paths carrying the
+// Telegram copy that is still missing and the preview a retry replaces, and
+// the deliveries to further recipients kept beside them.
+
+#include <string>
+
+#include "spool.hpp"
+#include "test_support.hpp"
+
+int main() {
+    enterScratchDir("spool_test");
+    // Written by an older version, one path per line
+    writeFile(std::string(SPOOL_DIR) + "/" +
+                  std::string(destinationName(Destination::Telegram)) + ".txt",
+              "img:/a.jpg\n");
+
+    auto& spool = RetrySpool::get();
+    spool.load(3);
+    CHECK(spool.size(Destination::Telegram) == 1);
+
+    spool.add(Destination::Telegram, "img:/b.jpg", "original");
+    spool.add(Destination::Ntfy, "img:/c.jpg");
+    CHECK(spool.total() == 3);
+
+    auto entry = spool.front(Destination::Telegram);
+    CHECK(entry && entry->path == "img:/a.jpg" && entry->mode.empty());
+    spool.popFront(Destination::Telegram);
+    entry = spool.front(Destination::Telegram);
+    CHECK(entry && entry->path == "img:/b.jpg" && entry->mode == "original");
+    entry = spool.front(Destination::Ntfy);
+    CHECK(entry && entry->path == "img:/c.jpg" && entry->mode.empty());
+
+    // Modes and previews survive eviction and a reload
+    spool.add(Destination::Telegram, "img:/d.jpg", "compressed", 42);
+    spool.add(Destination::Telegram, "img:/e.jpg");
+    spool.add(Destination::Telegram, "img:/f.jpg");
+    CHECK(spool.size(Destination::Telegram) == 3);
+    spool.load(3);
+    entry = spool.front(Destination::Telegram);
+    CHECK(entry && entry->path == "img:/d.jpg" &&
+          entry->mode == "compressed" && entry->previewMessageId == 42);
+    CHECK(spool.full(Destination::Telegram));
+
+    // A preview without a mode retries with the configured one
+    spool.load(4);
+    spool.add(Destination::Telegram, "img:/g.jpg", {}, 7);
+    spool.popFront(Destination::Telegram);
+    spool.popFront(Destination::Telegram);
+    spool.popFront(Destination::Telegram);
+    entry = spool.front(Destination::Telegram);
+    CHECK(entry && entry->path == "img:/g.jpg" && entry->mode.empty() &&
+          entry->previewMessageId == 7);
+
+    // Deliveries count towards the total, are bounded and survive a reload
+    spool.add(Destination::Discord, "img:/h.jpg");
+    spool.addDelivery(Destination::Telegram, "2", "1", "10,11");
+    for (int i = 0; i < 4; ++i) {
+        spool.addDelivery(Destination::Discord, "3", "1", std::to_string(i));
+    }
+    CHECK(spool.deliveries(Destination::Telegram) == 1);
+    CHECK(spool.deliveries(Destination::Discord) == 4);
+    spool.load(3);
+    CHECK(spool.size(Destination::Discord) == 1);
+    CHECK(spool.deliveries(Destination::Discord) == 3);
+    auto delivery = spool.frontDelivery(Destination::Telegram);
+    CHECK(delivery && delivery->recipient == "2" && delivery->origin == "1" &&
+          delivery->messageIds == "10,11");
+    spool.popDelivery(Destination::Telegram);
+    CHECK(!spool.frontDelivery(Destination::Telegram));
+    delivery = spool.frontDelivery(Destination::Discord);
+    CHECK(delivery && delivery->messageIds == "1");
+    CHECK(spool.total() == spool.size(Destination::Telegram) +
+                               spool.size(Destination::Ntfy) +
+                               spool.size(Destination::Discord) +
+                               spool.deliveries(Destination::Discord));
+
+    return testExitCode();
+}
@@ -0,0 +1,135 @@
+// Boot time and idle heap with the network started at boot, like
+// __appInit did before, against starting it on the first upload. Each run
+// is a fresh process, so curl's one-time global setup is paid every time.
+// A run does the startup work of main() before the album scan, then
+// starts the network as the first capture would and stops it again as
+// the idle timeout does. Heap use is heapInUse(), the figure the
+// sysmodule logs; the host's socketInitialize() takes the transfer
+// memory from the heap like libnx. curl is the host's libcurl with
+// OpenSSL, the console's links mbedTLS. Prints one "[bench] startup=..."
+// line per mode with the median of the runs.
+//
+// Usage: startup_bench [runs]
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "config.hpp"
+#include "fingerprint.hpp"
+#include "network.hpp"
+#include "spool.hpp"
+#include "test_support.hpp"
+#include "title_index.hpp"
+#include "utils.hpp"
+
+namespace {
+struct Startup {
+    size_t baseHeap;       // Before any startup work
+    double bootMs;         // Until the album scan would start
+    size_t idleHeap;       // Heap in use once started
+    double firstUploadMs;  // Network start on the first capture
+    size_t uploadHeap;     // Heap in use with the network up
+    size_t stoppedHeap;    // After the idle timeout stopped it again
+};
+
+Startup startup(bool eager) {
+    Startup result{};
+    result.baseHeap = heapInUse();
+    const u64 start = armGetSystemTick();
+    if (eager) {
+        // __appInit before the network was started lazily
+        CHECK(startNetwork());
+    }
+    CHECK(Config::get().refresh());
+    RetrySpool::get().load(
+        static_cast<size_t>(Config::get().getSpoolMaxItems()));
+    FingerprintStore::get().load();
+    (void)TitleIndex::get().load();
+
+    result.bootMs = msSince(start);
+    result.idleHeap = heapInUse();
+
+    const u64 first = armGetSystemTick();
+    CHECK(startNetwork());
+    result.firstUploadMs = msSince(first);
+    result.uploadHeap = heapInUse();
+
+    stopNetwork();
+    result.stoppedHeap = heapInUse();
+    return result;
+}
+
+// Run startup() in a child process and collect its figures
+Startup runChild(bool eager) {
+    std::array<int, 2> fds{};
+    CHECK(pipe(fds.data()) == 0);
+    const pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        const Startup result = startup(eager);
+        const bool written =
+            write(fds[1], &result, sizeof(result)) == sizeof(result);
+        _exit(written ? testExitCode() : 1);
+    }
+    close(fds[1]);
+    Startup result{};
+    CHECK(read(fds[0], &result, sizeof(result)) == sizeof(result));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    return result;
+}
+
+template <typename T>
+T median(std::vector<Startup>& runs, T Startup::*field) {
+    std::ranges::sort(runs, {}, field);
+    return runs[runs.size() / 2].*field;
+}
+
+Startup measure(const char* mode, bool eager, int count) {
+    std::vector<Startup> runs;
+    for (int i = 0; i < count; ++i) {
+        runs.push_back(runChild(eager));
+    }
+    const Startup result{
+        median(runs, &Startup::baseHeap),
+        median(runs, &Startup::bootMs),
+        median(runs, &Startup::idleHeap),
+        median(runs, &Startup::firstUploadMs),
+        median(runs, &Startup::uploadHeap),
+        median(runs, &Startup::stoppedHeap),
+    };
+    std::printf(
+        "[bench] startup=%s boot_ms=%.2f base_heap_kb=%zu idle_heap_kb=%zu "
+        "first_upload_ms=%.2f upload_heap_kb=%zu stopped_heap_kb=%zu\n",
+        mode, result.bootMs, result.baseHeap / 1024, result.idleHeap / 1024,
+        result.firstUploadMs,
+        result.uploadHeap / 1024, result.stoppedHeap / 1024);
+    return result;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    enterScratchDir("startup_bench");
+    writeConfig("[general]\ntelegram = true\n"
+                "[telegram]\nbot_token = 1:x\nchat_id = 1\n");
+    const int runs = argc > 1 ? std::atoi(argv[1]) : 9;
+
+    const Startup eager = measure("eager", true, runs);
+    const Startup lazy = measure("lazy", false, runs);
+
+    // The socket buffers alone are 96KB of the 320KB heap
+    CHECK(lazy.idleHeap + 96 * 1024 <= eager.idleHeap);
+    CHECK(lazy.bootMs < eager.bootMs);
+    std::printf("[bench] startup saved_boot_ms=%.2f saved_idle_heap_kb=%zu\n",
+                eager.bootMs - lazy.bootMs,
+                (eager.idleHeap - lazy.idleHeap) / 1024);
+    return testExitCode();
+}
@@ -0,0 +1,426 @@
+#include "test_support.hpp"
+
+#include <arpa/inet.h>
+#include <curl/curl.h>
+#include <dlfcn.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#include "project.h"
+
+namespace {
+std::atomic<int> g_failures{0};
+// Set by trustTestCertificate()
+std::atomic<bool> g_trustTestCertificate{false};
+constexpr const char* TEST_CERTIFICATE = "test-cert.pem";
+constexpr const char* TEST_KEY = "test-key.pem";
+
+// Buffered reader of one connection
+class Connection {
+   public:
+    explicit Connection(int fd) noexcept : m_fd(fd) {}
+
+    // Next line without CRLF, false when the peer closed
+    bool readLine(std::string& line) {
+        while (true) {
+            const size_t end = m_buffer.find("\r\n", m_pos);
+            if (end != std::string::npos) {
+                line.assign(m_buffer, m_pos, end - m_pos);
+                m_pos = end + 2;
+                return true;
+            }
+            if (!fill()) return false;
+        }
+    }
+
+    // Read `size` bytes, appended to `out` when it isn't null
+    bool read(size_t size, std::string* out, size_t rate) {
+        const u64 start = armGetSystemTick();
+        size_t done = 0;
+        while (done < size) {
+            if (m_pos == m_buffer.size() && !fill()) return false;
+            const size_t take = std::min(size - done, m_buffer.size() - m_pos);
+            if (out != nullptr) out->append(m_buffer, m_pos, take);
+            m_pos += take;
+            done += take;
+            if (rate > 0) {
+                // Sleep until the bytes so far fit the rate
+                const u64 dueNs = done * 1'000'000'000ULL / rate;
+                const u64 elapsedNs = armTicksToNs(armGetSystemTick() - start);
+                if (dueNs > elapsedNs) {
+                    svcSleepThread(static_cast<s64>(dueNs - elapsedNs));
+                }
+            }
+        }
+        return true;
+    }
+
+    bool write(std::string_view data) {
+        while (!data.empty()) {
+            const ssize_t sent =
+                ::send(m_fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (sent <= 0) return false;
+            data.remove_prefix(static_cast<size_t>(sent));
+        }
+        return true;
+    }
+
+   private:
+    bool fill() {
+        if (m_pos > 0) {
+            m_buffer.erase(0, m_pos);
+            m_pos = 0;
+        }
+        char chunk[0x4000];
+        const ssize_t got = ::recv(m_fd, chunk, sizeof(chunk), 0);
+        if (got <= 0) return false;
+        m_buffer.append(chunk, static_cast<size_t>(got));
+        return true;
+    }
+
+    int m_fd;
+    std::string m_buffer;
+    size_t m_pos{0};
+};
+
+bool parseHeader(std::string_view line, HttpHeader& header) {
+    const size_t colon = line.find(':');
+    if (colon == std::string_view::npos) return false;
+    std::string_view value = line.substr(colon + 1);
+    while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+    header = HttpHeader{std::string(line.substr(0, colon)),
+                        std::string(value)};
+    return true;
+}
+
+bool equalsNoCase(std::string_view a, std::string_view b) {
+    return a.size() == b.size() &&
+           strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+sockaddr_in loopback(uint16_t port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    return addr;
+}
+
+uint16_t freePort() {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = loopback(0);
+    ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    socklen_t length = sizeof(addr);
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &length);
+    ::close(fd);
+    return ntohs(addr.sin_port);
+}
+
+bool accepting(uint16_t port) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    const sockaddr_in addr = loopback(port);
+    const bool ok = ::connect(fd, reinterpret_cast<const sockaddr*>(&addr),
+                              sizeof(addr)) == 0;
+    ::close(fd);
+    return ok;
+}
+
+const char* reasonPhrase(int status) {
+    switch (status) {
+        case 200:
+            return "OK";
+        case 201:
+            return "Created";
+        case 204:
+            return "No Content";
+        case 400:
+            return "Bad Request";
+        case 403:
+            return "Forbidden";
+        case 404:
+            return "Not Found";
+        case 429:
+            return "Too Many Requests";
+        case 500:
+            return "Internal Server Error";
+        case 503:
+            return "Service Unavailable";
+    }
+    return "Unknown";
+}
+}  // namespace
+
+void testFailed() { ++g_failures; }
+
+int testExitCode() {
+    const int failures = g_failures.load();
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("All checks passed\n");
+    return 0;
+}
+
+void enterScratchDir(std::string_view name) {
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::absolute(fs::path("scratch") / name);
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    fs::create_directories(dir / "sdmc:" / "config" / APP_TITLE / "spool");
+    fs::create_directories(dir / "img:");
+    fs::current_path(dir);
+}
+
+void writeConfig(std::string_view ini) {
+    writeFile("sdmc:/config/" APP_TITLE "/config.ini", ini);
+}
+
+void writeFile(std::string_view path, std::string_view content) {
+    namespace fs = std::filesystem;
+    const fs::path file{path};
+    if (file.has_parent_path()) {
+        fs::create_directories(file.parent_path());
+    }
+    FILE* f = std::fopen(file.c_str(), "wb");
+    if (f == nullptr) {
+        std::perror("fopen");
+        std::abort();
+    }
+    std::fwrite(content.data(), 1, content.size(), f);
+    std::fclose(f);
+}
+
+std::string randomBytes(size_t size, uint32_t seed) {
+    std::string bytes(size, '\0');
+    uint32_t state = seed * 2654435761u + 1;
+    for (auto& c : bytes) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        c = static_cast<char>(state);
+    }
+    return bytes;
+}
+
+double msSince(u64 startTick) {
+    return static_cast<double>(armTicksToNs(armGetSystemTick() - startTick)) /
+           1e6;
+}
+
+std::string_view HttpRequest::header(std::string_view name) const {
+    for (const auto& h : headers) {
+        if (equalsNoCase(h.name, name)) return h.value;
+    }
+    return {};
+}
+
+TestServer::TestServer(Handler handler) : m_handler(std::move(handler)) {
+    mutexInit(&m_mutex);
+
+    m_listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+    const int one = 1;
+    ::setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = loopback(0);
+    if (::bind(m_listenFd, reinterpret_cast<sockaddr*>(&addr),
+               sizeof(addr)) != 0 ||
+        ::listen(m_listenFd, 16) != 0) {
+        std::perror("TestServer");
+        std::abort();
+    }
+    socklen_t length = sizeof(addr);
+    ::getsockname(m_listenFd, reinterpret_cast<sockaddr*>(&addr), &length);
+    m_port = ntohs(addr.sin_port);
+
+    m_acceptThread = std::thread([this] { acceptLoop(); });
+}
+
+TestServer::~TestServer() {
+    m_stop = true;
+    m_acceptThread.join();
+    mutexLock(&m_mutex);
+    for (const int fd : m_fds) {
+        ::shutdown(fd, SHUT_RDWR);
+    }
+    mutexUnlock(&m_mutex);
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+    ::close(m_listenFd);
+}
+
+std::string TestServer::url() const {
+    return "http://127.0.0.1:" + std::to_string(m_port);
+}
+
+std::vector<HttpRequest> TestServer::requests() {
+    mutexLock(&m_mutex);
+    std::vector<HttpRequest> copy = m_requests;
+    mutexUnlock(&m_mutex);
+    return copy;
+}
+
+void TestServer::clear() {
+    mutexLock(&m_mutex);
+    m_requests.clear();
+    mutexUnlock(&m_mutex);
+}
+
+void TestServer::acceptLoop() {
+    while (!m_stop) {
+        pollfd pfd{m_listenFd, POLLIN, 0};
+        if (::poll(&pfd, 1, 20) <= 0) continue;
+        const int fd = ::accept(m_listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        const int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        const size_t index = m_connections++;
+        mutexLock(&m_mutex);
+        m_fds.push_back(fd);
+        m_threads.emplace_back([this, fd, index] { serve(fd, index); });
+        mutexUnlock(&m_mutex);
+    }
+}
+
+void TestServer::serve(int fd, size_t connection) {
+    Connection conn(fd);
+    std::string line;
+
+    while (conn.readLine(line)) {
+        if (line.empty()) continue;
+
+        HttpRequest request;
+        request.connection = connection;
+        request.startTick = armGetSystemTick();
+        const size_t space = line.find(' ');
+        request.method = line.substr(0, space);
+        request.target =
+            line.substr(space + 1, line.find(' ', space + 1) - space - 1);
+
+        HttpHeader header;
+        while (conn.readLine(line) && !line.empty()) {
+            if (parseHeader(line, header)) {
+                request.headers.push_back(std::move(header));
+            }
+        }
+
+        if (equalsNoCase(request.header("Expect"), "100-continue")) {
+            conn.write("HTTP/1.1 100 Continue\r\n\r\n");
+        }
+
+        const bool store = m_storeBodies;
+        std::string* body = store ? &request.body : nullptr;
+        bool ok = true;
+        if (equalsNoCase(request.header("Transfer-Encoding"), "chunked")) {
+            request.chunked = true;
+            while ((ok = conn.readLine(line))) {
+                const size_t size = std::strtoul(line.c_str(), nullptr, 16);
+                if (size == 0) break;
+                ok = conn.read(size, body, m_receiveRate) &&
+                     conn.readLine(line);
+                if (!ok) break;
+                request.bodySize += size;
+            }
+            while (ok && (ok = conn.readLine(line)) && !line.empty()) {
+                if (parseHeader(line, header)) {
+                    request.trailers.push_back(std::move(header));
+                }
+            }
+        } else {
+            const std::string_view length = request.header("Content-Length");
+            request.bodySize =
+                length.empty() ? 0 : std::strtoul(length.data(), nullptr, 10);
+            ok = conn.read(request.bodySize, body, m_receiveRate);
+        }
+        if (!ok) break;
+        request.doneTick = armGetSystemTick();
+
+        const HttpResponse response =
+            m_handler ? m_handler(request) : HttpResponse{};
+        mutexLock(&m_mutex);
+        m_requests.push_back(std::move(request));
+        mutexUnlock(&m_mutex);
+
+        std::string head = "HTTP/1.1 " + std::to_string(response.status) +
+                           " " + reasonPhrase(response.status) + "\r\n";
+        for (const auto& h : response.headers) {
+            head += h.name + ": " + h.value + "\r\n";
+        }
+        head += "Content-Length: " + std::to_string(response.body.size()) +
+                "\r\n\r\n";
+        // One write, a second small one would wait for the delayed ACK
+        if (!conn.write(head + response.body)) break;
+    }
+
+    mutexLock(&m_mutex);
+    std::erase(m_fds, fd);
+    mutexUnlock(&m_mutex);
+    ::close(fd);
+}
+
+// Handles of the sources trust the test certificate once it exists
+extern "C" CURL* curl_easy_init() {
+    using Init = CURL* (*)();
+    static const auto real =
+        reinterpret_cast<Init>(dlsym(RTLD_NEXT, "curl_easy_init"));
+    CURL* curl = real();
+    if (curl != nullptr && g_trustTestCertificate) {
+        curl_easy_setopt(curl, CURLOPT_CAINFO, TEST_CERTIFICATE);
+    }
+    return curl;
+}
+
+bool hasTool(const char* tool) {
+    const std::string command =
+        std::string("command -v ") + tool + " >/dev/null 2>&1";
+    return std::system(command.c_str()) == 0;
+}
+
+bool trustTestCertificate() {
+    const std::string command =
+        std::string("openssl req -x509 -newkey rsa:2048 -nodes -days 1 ") +
+        "-subj /CN=127.0.0.1 -addext subjectAltName=IP:127.0.0.1 -keyout " +
+        TEST_KEY + " -out " + TEST_CERTIFICATE + " >/dev/null 2>&1";
+    g_trustTestCertificate = std::system(command.c_str()) == 0;
+    return g_trustTestCertificate;
+}
+
+TlsProxy::TlsProxy(uint16_t backendPort, bool http2) : m_port(freePort()) {
+    const std::string frontend =
+        "--frontend=127.0.0.1," + std::to_string(m_port);
+    const std::string backend =
+        "--backend=127.0.0.1," + std::to_string(backendPort);
+    const char* protocols =
+        http2 ? "--npn-list=h2,http/1.1" : "--npn-list=http/1.1";
+    m_pid = ::fork();
+    if (m_pid == 0) {
+        ::execlp("nghttpx", "nghttpx", frontend.c_str(), backend.c_str(),
+                 protocols, "--workers=1", "--no-ocsp",
+                 "--errorlog-file=/dev/null", "--accesslog-file=/dev/null",
+                 TEST_KEY, TEST_CERTIFICATE, static_cast<char*>(nullptr));
+        std::_Exit(127);
+    }
+    for (int i = 0; i < 200 && !accepting(m_port); ++i) {
+        svcSleepThread(10'000'000LL);
+    }
+}
+
+TlsProxy::~TlsProxy() {
+    ::kill(m_pid, SIGTERM);
+    ::waitpid(m_pid, nullptr, 0);
+}
+
+std::string TlsProxy::url() const {
+    return "https://127.0.0.1:" + std::to_string(m_port);
+}
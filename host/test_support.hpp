@@ -0,0 +1,147 @@
+#pragma once
+
+// Helpers shared by the host tests and benchmarks
+
+#include <switch.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Record a failed expectation and carry on, see testExitCode()
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, \
+                         __LINE__, #cond);                           \
+            testFailed();                                            \
+        }                                                            \
+    } while (0)
+
+void testFailed();
+// 0 when every CHECK passed, for main() to return
+[[nodiscard]] int testExitCode();
+
+// Create an empty directory scratch/<name> below the working directory with
+// the layout the sysmodule expects ("sdmc:/config/<app>/", "img:/") and
+// make it the working directory, so "sdmc:/..." and "img:/..." paths land
+// there
+void enterScratchDir(std::string_view name);
+// Replace config.ini of the scratch directory
+void writeConfig(std::string_view ini);
+// Write `content` to `path`, creating missing directories
+void writeFile(std::string_view path, std::string_view content);
+// `size` bytes of deterministic pseudo-random content
+[[nodiscard]] std::string randomBytes(size_t size, uint32_t seed = 1);
+
+// Milliseconds elapsed since `startTick`
+[[nodiscard]] double msSince(u64 startTick);
+
+struct HttpHeader {
+    std::string name;
+    std::string value;
+};
+
+struct HttpRequest {
+    std::string method;
+    std::string target;
+    std::vector<HttpHeader> headers;
+    std::vector<HttpHeader> trailers;
+    std::string body;
+    size_t bodySize{0};
+    bool chunked{false};
+    size_t connection{0};  // Index of the connection it came in on
+    u64 startTick{0};      // When the request line arrived
+    u64 doneTick{0};       // When the whole body had arrived
+
+    // Value of the first header called `name` (case-insensitive)
+    [[nodiscard]] std::string_view header(std::string_view name) const;
+};
+
+struct HttpResponse {
+    int status{200};
+    std::string body{R"({"ok":true,"result":{"message_id":1}})"};
+    std::vector<HttpHeader> headers;
+};
+
+/**
+ * Plain HTTP/1.1 server on 127.0.0.1 for driving the upload code against.
+ * Understands Content-Length and chunked bodies with trailers, answers
+ * "Expect: 100-continue" and keeps connections alive. Every request is
+ * recorded; the handler decides the response.
+ */
+class TestServer {
+   public:
+    using Handler = std::function<HttpResponse(const HttpRequest&)>;
+
+    explicit TestServer(Handler handler = {});
+    ~TestServer();
+    TestServer(const TestServer&) = delete;
+    TestServer& operator=(const TestServer&) = delete;
+
+    [[nodiscard]] uint16_t port() const noexcept { return m_port; }
+    // "http://127.0.0.1:<port>"
+    [[nodiscard]] std::string url() const;
+    // Requests received so far
+    [[nodiscard]] std::vector<HttpRequest> requests();
+    [[nodiscard]] size_t connections() const noexcept {
+        return m_connections.load();
+    }
+    // Keep only the size of request bodies, for large transfers
+    void setStoreBodies(bool store) noexcept { m_storeBodies = store; }
+    // Limit how fast bodies are received, in bytes/s (0 = unlimited)
+    void setReceiveRate(size_t rate) noexcept { m_receiveRate = rate; }
+    void clear();
+
+   private:
+    void acceptLoop();
+    void serve(int fd, size_t connection);
+
+    Handler m_handler;
+    int m_listenFd{-1};
+    uint16_t m_port{0};
+    std::atomic<bool> m_stop{false};
+    std::atomic<size_t> m_connections{0};
+    std::atomic<bool> m_storeBodies{true};
+    std::atomic<size_t> m_receiveRate{0};
+    std::thread m_acceptThread;
+    std::vector<std::thread> m_threads;
+    std::vector<int> m_fds;
+    std::vector<HttpRequest> m_requests;
+    Mutex m_mutex{};
+};
+
+// Whether `tool` can be run from the PATH
+[[nodiscard]] bool hasTool(const char* tool);
+
+// Create a self-signed certificate for 127.0.0.1 in the working directory
+// and make every curl handle created afterwards trust it. False when
+// openssl failed.
+[[nodiscard]] bool trustTestCertificate();
+
+/**
+ * nghttpx terminating TLS with the trustTestCertificate() certificate in
+ * front of a TestServer, offering h2 and HTTP/1.1 or HTTP/1.1 only.
+ * Requests reach the backend as HTTP/1.1 either way.
+ */
+class TlsProxy {
+   public:
+    TlsProxy(uint16_t backendPort, bool http2);
+    ~TlsProxy();
+    TlsProxy(const TlsProxy&) = delete;
+    TlsProxy& operator=(const TlsProxy&) = delete;
+
+    // "https://127.0.0.1:<port>"
+    [[nodiscard]] std::string url() const;
+
+   private:
+    uint16_t m_port{0};
+    pid_t m_pid{-1};
+};
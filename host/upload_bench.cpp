@@ -0,0 +1,260 @@
+// Microbenchmarks of the upload data path: uploadReadFunction() at several
+// buffer sizes, url_encode() on captions, multipart body construction and
+// full sendFileTo*() round trips against a loopback server. Every case
+// reports MB/s or ns per call and heap allocations, counted by the malloc
+// wrappers below, as one "[bench] ..." line. SHA-256 is done in software
+// on the host, which bounds the read throughput; the console hashes in
+// hardware.
+
+#include <curl/curl.h>
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "bandwidth.hpp"
+#include "config.hpp"
+#include "http.hpp"
+#include "network.hpp"
+#include "test_support.hpp"
+#include "upload.hpp"
+#include "upload_stream.hpp"
+#include "utils.hpp"
+
+// Count every allocation of the process, libcurl and libstdc++ included.
+// glibc exports its allocator as __libc_*, so the wrappers forward there.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace {
+std::atomic<size_t> g_allocations{0};
+}  // namespace
+
+extern "C" {
+void* malloc(size_t size) {
+    ++g_allocations;
+    return __libc_malloc(size);
+}
+void* calloc(size_t count, size_t size) {
+    ++g_allocations;
+    return __libc_calloc(count, size);
+}
+void* realloc(void* ptr, size_t size) {
+    ++g_allocations;
+    return __libc_realloc(ptr, size);
+}
+void free(void* ptr) { __libc_free(ptr); }
+}
+
+namespace {
+constexpr size_t KB = 1024;
+constexpr size_t MB = 1024 * KB;
+
+// Allocations and time of one measured section
+class Measure {
+   public:
+    Measure() : m_allocations(g_allocations.load()) {}
+
+    [[nodiscard]] double ms() const { return msSince(m_start); }
+    [[nodiscard]] size_t allocations() const {
+        return g_allocations.load() - m_allocations;
+    }
+
+   private:
+    u64 m_start{armGetSystemTick()};
+    size_t m_allocations;
+};
+
+double mbps(size_t bytes, double ms) {
+    return static_cast<double>(bytes) / MB / (ms / 1000.0);
+}
+
+// Pull a whole file through uploadReadFunction() like curl does with an
+// upload buffer of `buffer` bytes
+void readFunction(const std::string& path, size_t size, size_t buffer,
+                  TrafficClass cls) {
+    std::vector<char> data(buffer);
+    FILE* f = std::fopen(path.c_str(), "rb");
+    UploadInfo ui{f, size, cls};
+
+    const Measure measure;
+    size_t total = 0;
+    size_t got = 0;
+    while ((got = uploadReadFunction(data.data(), 1, buffer, &ui)) > 0) {
+        total += got;
+    }
+    const double ms = measure.ms();
+    const size_t allocations = measure.allocations();
+    stopReadAhead(ui);
+    std::fclose(f);
+
+    CHECK(total == size);
+    std::printf(
+        "[bench] read=%s buffer=%zu bytes=%zu mbps=%.0f reads=%u "
+        "allocs=%zu\n",
+        cls == TrafficClass::Movie ? "read_ahead" : "direct", buffer, size,
+        mbps(size, ms), ui.reads, allocations);
+}
+
+void urlEncode() {
+    // Game names as they end up in captions and URLs, with the digest line
+    const std::array<std::string, 4> captions{
+        "Super Mario Bros. Wonder",
+        "The Legend of Zelda: Tears of the Kingdom",
+        "ゼルダの伝説　ティアーズ オブ ザ キングダム",
+        "Pokémon Scarlet\nsha256:"
+        "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08",
+    };
+    constexpr int ROUNDS = 100'000;
+
+    size_t bytes = 0;
+    size_t encoded = 0;
+    const Measure measure;
+    for (int i = 0; i < ROUNDS; ++i) {
+        const std::string& caption = captions[i % captions.size()];
+        encoded += url_encode(caption).size();
+        bytes += caption.size();
+    }
+    const double ms = measure.ms();
+
+    CHECK(url_encode("a b/ü") == "a%20b%2F%C3%BC");
+    std::printf(
+        "[bench] url_encode calls=%d ns_per_call=%.0f mbps=%.0f "
+        "allocs_per_call=%.2f growth=%.2f\n",
+        ROUNDS, ms * 1e6 / ROUNDS, mbps(bytes, ms),
+        static_cast<double>(measure.allocations()) / ROUNDS,
+        static_cast<double>(encoded) / static_cast<double>(bytes));
+}
+
+size_t countBytes(void* arg, const char*, size_t length) {
+    *static_cast<size_t*>(arg) += length;
+    return length;
+}
+
+// A form as sendFileToTelegram() builds it: chat id, the streamed file and
+// the caption with the digest. curl_formget() serializes everything but the
+// streamed parts, i.e. the overhead that multipart adds to an upload; the
+// streamed bodies are covered by the round trips.
+void multipart(const std::string& path, size_t size) {
+    constexpr int ROUNDS = 10'000;
+    FILE* f = std::fopen(path.c_str(), "rb");
+    UploadInfo ui{f, size, TrafficClass::Screenshot};
+    UploadInfo caption = makeDigestField(ui, "Super Mario Bros. Wonder");
+
+    size_t overhead = 0;
+    const Measure measure;
+    for (int i = 0; i < ROUNDS; ++i) {
+        curl_httppost* formpost = nullptr;
+        curl_httppost* lastptr = nullptr;
+        curl_formadd(&formpost, &lastptr, CURLFORM_COPYNAME, "chat_id",
+                     CURLFORM_COPYCONTENTS, "123456789", CURLFORM_END);
+        curl_formadd(&formpost, &lastptr, CURLFORM_COPYNAME, "photo",
+                     CURLFORM_FILENAME, "capture.jpg", CURLFORM_STREAM, &ui,
+                     CURLFORM_CONTENTSLENGTH, static_cast<long>(size),
+                     CURLFORM_CONTENTTYPE, "image/jpeg", CURLFORM_END);
+        curl_formadd(&formpost, &lastptr, CURLFORM_COPYNAME, "caption",
+                     CURLFORM_STREAM, &caption, CURLFORM_CONTENTSLENGTH,
+                     static_cast<long>(caption.sizeLeft), CURLFORM_END);
+
+        overhead = 0;
+        CHECK(curl_formget(formpost, &overhead, countBytes) == 0);
+        curl_formfree(formpost);
+    }
+    const double ms = measure.ms();
+    std::fclose(f);
+
+    CHECK(overhead > 0 && overhead < 1024);
+    std::printf(
+        "[bench] multipart fields=3 overhead_bytes=%zu ns_per_form=%.0f "
+        "allocs_per_form=%.1f\n",
+        overhead, ms * 1e6 / ROUNDS,
+        static_cast<double>(measure.allocations()) / ROUNDS);
+}
+
+template <typename F>
+void roundTrip(TestServer& server, const char* destination,
+               const std::string& path, size_t size, F&& send) {
+    constexpr int ROUNDS = 5;
+    // The first upload sets up the connection, time the warm ones
+    CHECK(send(path, size));
+    server.clear();
+
+    const Measure measure;
+    for (int i = 0; i < ROUNDS; ++i) {
+        CHECK(send(path, size));
+    }
+    const double ms = measure.ms();
+
+    const auto requests = server.requests();
+    CHECK(requests.size() == ROUNDS);
+    CHECK(requests.empty() || requests.back().bodySize >= size);
+    std::printf(
+        "[bench] round_trip=%s bytes=%zu ms=%.1f mbps=%.0f "
+        "allocs_per_upload=%.0f\n",
+        destination, size, ms / ROUNDS, mbps(size * ROUNDS, ms),
+        static_cast<double>(measure.allocations()) / ROUNDS);
+}
+
+void roundTrips(const std::string& path, size_t size) {
+    TestServer server([](const HttpRequest&) {
+        HttpResponse response;
+        // Fits Telegram, ntfy and Discord alike
+        response.body = R"({"ok":true,"id":"1","result":{"message_id":1}})";
+        return response;
+    });
+    server.setStoreBodies(false);
+
+    writeConfig("[general]\ntelegram = true\nntfy = true\ndiscord = true\n"
+                "[telegram]\nbot_token = 1:x\nchat_id = 1\napi_url = " +
+                server.url() +
+                "\n[ntfy]\ntopic = bench\nurl = " + server.url() +
+                "\n[discord]\nbot_token = x\nchannel_id = 1\napi_url = " +
+                server.url() + "\n");
+    CHECK(Config::get().refresh());
+    CHECK(startNetwork());
+
+    roundTrip(server, "telegram", path, size,
+              [](const std::string& p, size_t fs) {
+                  return sendFileToTelegram(p, fs, true);
+              });
+    roundTrip(server, "ntfy", path, size, [](const std::string& p, size_t fs) {
+        return sendFileToNtfy(p, fs);
+    });
+    roundTrip(server, "discord", path, size,
+              [](const std::string& p, size_t fs) {
+                  return sendFileToDiscord(p, fs);
+              });
+
+    stopNetwork();
+}
+}  // namespace
+
+int main() {
+    enterScratchDir("upload_bench");
+    BandwidthLimiter::get().configure(0, 0);
+
+    // A typical screenshot and a short movie
+    const std::string shot = "img:/2026/10/19/2026101912000000-A.jpg";
+    const std::string movie = "img:/2026/10/19/2026101912000100-B.mp4";
+    constexpr size_t SHOT_SIZE = 400 * KB;
+    constexpr size_t MOVIE_SIZE = 32 * MB;
+    writeFile(shot, randomBytes(SHOT_SIZE));
+    writeFile(movie, randomBytes(MOVIE_SIZE, 2));
+
+    for (const size_t buffer : {4 * KB, 8 * KB, 16 * KB, 32 * KB, 64 * KB}) {
+        readFunction(movie, MOVIE_SIZE, buffer, TrafficClass::Screenshot);
+        readFunction(movie, MOVIE_SIZE, buffer, TrafficClass::Movie);
+    }
+    urlEncode();
+    multipart(shot, SHOT_SIZE);
+    roundTrips(shot, SHOT_SIZE);
+
+    return testExitCode();
+}
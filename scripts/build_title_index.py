@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Build the title index (titles.bin) used to show game names.
+
+Album filenames end with a 32 hex digit ID of the game they were taken in.
+This script turns a list of such IDs and their game names into the sorted
+binary index read by the sysmodule. Copy the result to
+sdmc:/config/NX-ScreenUploader/titles.bin.
+
+Input is either a JSON object ({"<id>": "<name>", ...}) or a CSV file with
+one "<id>,<name>" pair per line.
+
+Usage: build_title_index.py <input.json|input.csv> [output.bin]
+"""
+
+import csv
+import json
+import re
+import struct
+import sys
+
+MAGIC = b"NXTI"
+VERSION = 1
+KEY_SIZE = 16
+NAME_SIZE = 48  # Including the NUL terminator
+RECORD_SIZE = KEY_SIZE + NAME_SIZE
+
+ID_PATTERN = re.compile(r"^[0-9A-Fa-f]{32}$")
+
+
+def load_entries(path):
+    with open(path, encoding="utf-8") as f:
+        if path.endswith(".json"):
+            return list(json.load(f).items())
+        return [(row[0], ",".join(row[1:])) for row in csv.reader(f) if row]
+
+
+def encode_name(name):
+    # Names end up in HTTP headers and JSON, keep them on one plain line
+    name = "".join(c for c in name if c.isprintable()).strip()
+    data = name.encode("utf-8")[: NAME_SIZE - 1]
+    # Never cut a multi-byte character in half
+    return data.decode("utf-8", errors="ignore").encode("utf-8")
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        print(__doc__.strip().splitlines()[-1], file=sys.stderr)
+        return 1
+
+    output = sys.argv[2] if len(sys.argv) == 3 else "titles.bin"
+
+    index = {}
+    for title_id, name in load_entries(sys.argv[1]):
+        title_id = title_id.strip()
+        if not ID_PATTERN.match(title_id):
+            print(f"Skipping invalid ID: {title_id!r}", file=sys.stderr)
+            continue
+        encoded = encode_name(name)
+        if encoded:
+            index[bytes.fromhex(title_id)] = encoded
+
+    with open(output, "wb") as f:
+        f.write(MAGIC)
+        f.write(struct.pack("<III", VERSION, len(index), RECORD_SIZE))
+        for key in sorted(index):
+            f.write(key)
+            f.write(index[key].ljust(NAME_SIZE, b"\0"))
+
+    print(f"✓ Wrote {len(index)} titles to {output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,206 @@
+#include "album_scanner.hpp"
+
+#include <sys/stat.h>
+
+#include <array>
+
+#include "clock.hpp"
+#include "logger.hpp"
+#include "stability.hpp"
+#include "upload.hpp"
+#include "utils.hpp"
+
+namespace {
+// Above the main thread so a scan is never held up by upload work, the
+// scanner sleeps nearly all the time
+constexpr int THREAD_PRIORITY = 0x2B;
+constexpr size_t THREAD_STACK_SIZE = 0x4000;  // 16KB
+// Scan interval while fast scanning is requested
+constexpr u64 FAST_SCAN_NS = 100'000'000ULL;
+// Give up waiting for an incomplete capture after this long
+constexpr u64 STABILITY_TIMEOUT_MS = 60'000ULL;
+
+// Static stack, keeps the scanner off the small heap
+alignas(0x1000) std::array<u8, THREAD_STACK_SIZE> g_stack;
+
+[[nodiscard]] bool fileExists(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+}  // namespace
+
+bool AlbumScanner::start(std::expected<std::string, std::string> lastItem,
+                         u64 intervalNs) {
+    if (m_running) return false;
+
+    m_lastItem = std::move(lastItem);
+    m_intervalNs = intervalNs;
+    m_stop = false;
+    m_pendingMovies.reserve(MAX_PENDING_MOVIES);
+
+    Result rc = threadCreate(&m_thread, threadMain, this, g_stack.data(),
+                             g_stack.size(), THREAD_PRIORITY, -2);
+    if (R_SUCCEEDED(rc)) {
+        rc = threadStart(&m_thread);
+        if (R_FAILED(rc)) threadClose(&m_thread);
+    }
+    if (R_FAILED(rc)) {
+        Logger::get().error()
+            << "Failed to start the album scanner: " << rc << endl;
+        return false;
+    }
+
+    m_running = true;
+    return true;
+}
+
+void AlbumScanner::stop() {
+    if (!m_running) return;
+
+    mutexLock(&m_mutex);
+    m_stop = true;
+    condvarWakeAll(&m_wake);
+    mutexUnlock(&m_mutex);
+
+    threadWaitForExit(&m_thread);
+    threadClose(&m_thread);
+    m_running = false;
+}
+
+void AlbumScanner::wait(u64 timeoutNs) {
+    // Checked under the lock, so a capture handed over right after the
+    // check still wakes us up
+    mutexLock(&m_mutex);
+    if (m_ring.empty()) {
+        condvarWaitTimeout(&m_captured, &m_mutex, timeoutNs);
+    }
+    mutexUnlock(&m_mutex);
+}
+
+void AlbumScanner::setFastScan(bool fast) {
+    mutexLock(&m_mutex);
+    m_fastScan = fast;
+    if (fast) {
+        condvarWakeAll(&m_wake);
+    }
+    mutexUnlock(&m_mutex);
+}
+
+void AlbumScanner::threadMain(void* arg) {
+    static_cast<AlbumScanner*>(arg)->run();
+}
+
+void AlbumScanner::run() {
+    mutexLock(&m_mutex);
+    while (!m_stop) {
+        mutexUnlock(&m_mutex);
+        const size_t handedOver = scan();
+        mutexLock(&m_mutex);
+
+        if (handedOver > 0) {
+            condvarWakeAll(&m_captured);
+        }
+        if (!m_stop) {
+            condvarWaitTimeout(&m_wake, &m_mutex,
+                               m_fastScan ? FAST_SCAN_NS : m_intervalNs);
+        }
+    }
+    mutexUnlock(&m_mutex);
+}
+
+// Hand over every item newer than the last one in order, as far as the
+// ring has room. Returns the number of items handed over.
+size_t AlbumScanner::scan() {
+    size_t handedOver = handOverPendingMovies();
+    const size_t freeSlots = m_ring.freeSlots();
+    if (freeSlots == 0) {
+        return handedOver;  // Backpressure, continue from m_lastItem later
+    }
+
+    m_newItems.clear();
+    if (!m_lastItem.has_value()) {
+        auto tmpItemResult = getLastAlbumItem();
+        if (tmpItemResult.has_value()) {
+            m_newItems.push_back(std::move(tmpItemResult.value()));
+        }
+    } else {
+        collectNewAlbumItems(m_lastItem.value(), freeSlots, m_newItems);
+    }
+
+    for (auto& path : m_newItems) {
+        size_t fs = 0;
+        if (m_pending.path != path) {
+            m_pending = PendingCapture{path, {}, Clock::get().tick()};
+        }
+        if (!readyOrTimedOut(m_pending, fs)) {
+            if (!isMovieFile(path) ||
+                m_pendingMovies.size() >= MAX_PENDING_MOVIES) {
+                // Stop at files that are still being written, they are
+                // picked up again on the next scan
+                break;
+            }
+            // A movie is still being recorded, check on it again on the
+            // next scans and carry on with the captures behind it
+            m_pendingMovies.push_back(std::move(m_pending));
+            m_pending = PendingCapture{};
+            m_lastItem = std::move(path);
+            continue;
+        }
+
+        if (!handOver(path, fs)) {
+            break;
+        }
+        m_lastItem = std::move(path);
+        ++handedOver;
+    }
+    return handedOver;
+}
+
+// Hand over the movies set aside earlier that are complete by now. Movies
+// deleted meanwhile are dropped so they don't hold a slot for good.
+size_t AlbumScanner::handOverPendingMovies() {
+    size_t handedOver = 0;
+    for (auto it = m_pendingMovies.begin(); it != m_pendingMovies.end();) {
+        if (!fileExists(it->path)) {
+            Logger::get().info()
+                << "Pending movie was deleted: " << it->path << endl;
+            it = m_pendingMovies.erase(it);
+            continue;
+        }
+        size_t fs = 0;
+        if (readyOrTimedOut(*it, fs)) {
+            if (!handOver(it->path, fs)) {
+                break;
+            }
+            ++handedOver;
+            it = m_pendingMovies.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return handedOver;
+}
+
+// Whether `pending` is complete, or has been incomplete for so long that it
+// is uploaded anyway. `fs` receives its size.
+bool AlbumScanner::readyOrTimedOut(PendingCapture& pending, size_t& fs) {
+    if (isCaptureComplete(pending.path, fs, pending.snapshot)) {
+        return true;
+    }
+    if (elapsedMs(pending.sinceTick) < STABILITY_TIMEOUT_MS) {
+        return false;
+    }
+    fs = filesize(pending.path);
+    if (fs == 0) {
+        return false;
+    }
+    Logger::get().warn() << "Capture still incomplete after "
+                         << STABILITY_TIMEOUT_MS / 1000
+                         << "s, uploading anyway: " << pending.path << endl;
+    return true;
+}
+
+bool AlbumScanner::handOver(const std::string& path, size_t fs) {
+    CaptureItem item{path, fs, isMovieFile(path), Clock::get().tick()};
+    return m_ring.push(item);
+}
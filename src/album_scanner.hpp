@@ -0,0 +1,90 @@
+#pragma once
+
+#include <switch.h>
+
+#include <expected>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "spsc_ring.hpp"
+#include "stability.hpp"
+#include "upload_queue.hpp"
+
+/**
+ * Polls the album for new captures on its own thread and hands them to the
+ * upload thread through a lock-free ring, so detection keeps its pace no
+ * matter how long transfers take. When the ring is full the scanner stops
+ * at the last capture it handed over and continues from there once the
+ * upload thread has taken some; the album itself holds the backlog, so
+ * nothing is dropped. Movies that are still being recorded are set aside
+ * and handed over once complete, so the screenshots behind them are not
+ * held up; captures otherwise arrive in album order.
+ */
+class AlbumScanner {
+   public:
+    static constexpr size_t RING_CAPACITY = 16;
+    // Incomplete movies set aside at once, the scan waits at the next one
+    static constexpr size_t MAX_PENDING_MOVIES = 4;
+
+    static AlbumScanner& get() noexcept {
+        static AlbumScanner instance;
+        return instance;
+    }
+
+    // Scan every `intervalNs` for items newer than `lastItem`. If lastItem
+    // is an error, the first valid item is handed over.
+    [[nodiscard]] bool start(std::expected<std::string, std::string> lastItem,
+                             u64 intervalNs);
+    // Stop the thread, must run before the album is unmounted
+    void stop();
+
+    // Upload thread only: the next detected capture
+    [[nodiscard]] std::optional<CaptureItem> pop() { return m_ring.pop(); }
+    [[nodiscard]] bool pending() const noexcept { return !m_ring.empty(); }
+    // Upload thread only: wait up to `timeoutNs` for a capture
+    void wait(u64 timeoutNs);
+
+    // Scan at a short interval, e.g. while a batch is lingering
+    void setFastScan(bool fast);
+
+   private:
+    // Capture that was found incomplete, since when and its last state
+    struct PendingCapture {
+        std::string path;
+        CaptureSnapshot snapshot;
+        u64 sinceTick{0};
+    };
+
+    AlbumScanner() {
+        mutexInit(&m_mutex);
+        condvarInit(&m_captured);
+        condvarInit(&m_wake);
+    }
+    AlbumScanner(const AlbumScanner&) = delete;
+    AlbumScanner& operator=(const AlbumScanner&) = delete;
+
+    static void threadMain(void* arg);
+    void run();
+    size_t scan();
+    size_t handOverPendingMovies();
+    [[nodiscard]] bool readyOrTimedOut(PendingCapture& pending, size_t& fs);
+    [[nodiscard]] bool handOver(const std::string& path, size_t fs);
+
+    SpscRing<CaptureItem, RING_CAPACITY> m_ring;
+    // Only for sleeping and waking up, the ring itself needs no lock
+    Mutex m_mutex;
+    CondVar m_captured;  // Upload thread waits for captures
+    CondVar m_wake;      // Scanner waits for its next scan
+    Thread m_thread{};
+    std::expected<std::string, std::string> m_lastItem;
+    std::vector<std::string> m_newItems;
+    // Capture the scan stopped at
+    PendingCapture m_pending;
+    // Movies the scan moved past, in album order
+    std::vector<PendingCapture> m_pendingMovies;
+    u64 m_intervalNs{0};
+    bool m_fastScan{false};
+    bool m_stop{false};
+    bool m_running{false};
+};
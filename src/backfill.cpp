@@ -0,0 +1,110 @@
+#include "backfill.hpp"
+
+#include <array>
+#include <cstdio>
+
+#include "logger.hpp"
+#include "utils.hpp"
+
+namespace {
+// Written in place of the cursor once the whole range has been uploaded
+constexpr std::string_view DONE_MARKER = "done";
+constexpr size_t MAX_LINE_LENGTH = 256;
+
+// Album day directory of a YYYY-MM-DD date, e.g. img:/2024/05/31
+[[nodiscard]] std::string albumDay(std::string_view date) {
+    std::string path{ALBUM_PATH};
+    path += date.substr(0, 4);
+    path += '/';
+    path += date.substr(5, 2);
+    path += '/';
+    path += date.substr(8, 2);
+    return path;
+}
+
+// Read one line without the trailing newline, false at end of file
+[[nodiscard]] bool readLine(FILE* f, std::string& line) {
+    std::array<char, MAX_LINE_LENGTH> buffer;
+    if (std::fgets(buffer.data(), buffer.size(), f) == nullptr) {
+        return false;
+    }
+    line = buffer.data();
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+        line.pop_back();
+    }
+    return true;
+}
+}  // namespace
+
+void Backfill::load(std::string_view from, std::string_view to) {
+    m_range = from;
+    m_range += ' ';
+    m_range += to;
+    m_cursor = albumDay(from) + "/";
+    m_lastDay = albumDay(to);
+    m_active = true;
+
+    // Resume only when the persisted state belongs to the same range
+    FILE* f = std::fopen(BACKFILL_PATH.data(), "r");
+    if (f == nullptr) {
+        return;
+    }
+    std::string range;
+    std::string cursor;
+    if (readLine(f, range) && range == m_range && readLine(f, cursor) &&
+        !cursor.empty()) {
+        if (cursor == DONE_MARKER) {
+            m_active = false;
+        } else {
+            m_cursor = std::move(cursor);
+        }
+    }
+    std::fclose(f);
+}
+
+size_t Backfill::next(size_t limit, std::vector<std::string>& out) {
+    if (!m_active) {
+        return 0;
+    }
+
+    const size_t initialSize = out.size();
+    collectNewAlbumItems(m_cursor, limit, out);
+
+    // Items come in chronological order, drop those past the last day
+    while (out.size() > initialSize) {
+        const std::string_view day =
+            std::string_view(out.back()).substr(0, m_lastDay.size());
+        if (day <= m_lastDay) break;
+        out.pop_back();
+    }
+
+    const size_t count = out.size() - initialSize;
+    if (count == 0) {
+        m_active = false;
+        m_cursor = DONE_MARKER;
+        persist();
+        Logger::get().info()
+            << "[Backfill] Finished range " << m_range << endl;
+    }
+    return count;
+}
+
+void Backfill::advance(std::string_view path) {
+    m_cursor = path;
+    persist();
+}
+
+void Backfill::persist() const {
+    FILE* f = std::fopen(BACKFILL_PATH.data(), "w");
+    if (f == nullptr) {
+        Logger::get().error()
+            << "[Backfill] Unable to save progress to " << BACKFILL_PATH
+            << endl;
+        return;
+    }
+    std::fputs(m_range.c_str(), f);
+    std::fputc('\n', f);
+    std::fputs(m_cursor.c_str(), f);
+    std::fputc('\n', f);
+    std::fclose(f);
+}
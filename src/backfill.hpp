@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "project.h"
+
+inline constexpr std::string_view BACKFILL_PATH =
+    "sdmc:/config/" APP_TITLE "/backfill.txt";
+
+/**
+ * Uploads the album items of a configured date range, oldest first.
+ * Items are pulled a few at a time from the album tree, so memory does not
+ * depend on the album size. The position reached is persisted after every
+ * item, and a finished range is remembered, so a restart resumes where it
+ * stopped and a completed range is not uploaded again.
+ */
+class Backfill {
+   public:
+    static Backfill& get() noexcept {
+        static Backfill instance;
+        return instance;
+    }
+
+    // Start or resume the range [from, to], dates given as YYYY-MM-DD
+    void load(std::string_view from, std::string_view to);
+
+    [[nodiscard]] bool active() const noexcept { return m_active; }
+    [[nodiscard]] std::string_view cursor() const noexcept { return m_cursor; }
+
+    // Append up to `limit` of the next items in the range to `out`. The
+    // range is marked finished when no items are left.
+    size_t next(size_t limit, std::vector<std::string>& out);
+
+    // Record that every item up to and including `path` has been handled
+    void advance(std::string_view path);
+
+   private:
+    Backfill() = default;
+    Backfill(const Backfill&) = delete;
+    Backfill& operator=(const Backfill&) = delete;
+
+    void persist() const;
+
+    std::string m_range;      // "<from> <to>", identifies the persisted state
+    std::string m_cursor;     // Last handled item, or the first day directory
+    std::string m_lastDay;    // "img:/YYYY/MM/DD" of the last day in range
+    bool m_active{false};
+};
@@ -0,0 +1,152 @@
+#include "bandwidth.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+// Smallest grant handed out while throttled, avoids tiny curl reads
+constexpr size_t MIN_GRANT = 0x400;  // 1KB
+// Bucket depth in fractions of a second worth of tokens
+constexpr size_t BURST_DIVISOR = 8;
+constexpr size_t MIN_BURST = 0x2000;  // 8KB, one upload buffer
+// Bounds of the pause of a transfer waiting for tokens
+constexpr u64 MIN_WAIT_NS = 1'000'000ULL;   // 1ms
+constexpr u64 MAX_WAIT_NS = 50'000'000ULL;  // 50ms
+// A waiting screenshot asks again within MAX_WAIT_NS
+constexpr u64 SCREENSHOT_WAIT_NS = MAX_WAIT_NS * 2;
+}  // namespace
+
+void BandwidthLimiter::setup(Bucket& bucket, size_t rate, u64 now) noexcept {
+    bucket.rate = rate;
+    bucket.burst = rate > 0 ? std::max(rate / BURST_DIVISOR, MIN_BURST) : 0;
+    bucket.tokens = bucket.burst;
+    bucket.lastTick = now;
+}
+
+void BandwidthLimiter::configure(size_t rate, size_t movieRate) noexcept {
+    mutexLock(&m_mutex);
+    const u64 now = armGetSystemTick();
+    setup(m_global, rate, now);
+    setup(m_movie, movieRate, now);
+    mutexUnlock(&m_mutex);
+}
+
+size_t BandwidthLimiter::rateFor(TrafficClass cls) const noexcept {
+    if (cls == TrafficClass::Movie && m_movie.rate > 0) {
+        return m_global.rate > 0 ? std::min(m_global.rate, m_movie.rate)
+                                 : m_movie.rate;
+    }
+    return m_global.rate;
+}
+
+void BandwidthLimiter::refill(Bucket& bucket, u64 now) noexcept {
+    if (bucket.rate == 0 || now <= bucket.lastTick) return;
+
+    const u64 freq = armGetSystemTickFreq();
+    const u64 elapsed = now - bucket.lastTick;
+
+    // A full second (or more) of idle time always fills the bucket, this
+    // also keeps the multiplication below far away from overflowing
+    if (elapsed >= freq) {
+        bucket.tokens = bucket.burst;
+        bucket.lastTick = now;
+        return;
+    }
+
+    const u64 added = elapsed * bucket.rate / freq;
+    if (added == 0) return;
+
+    // Only advance by the ticks actually converted to keep fractions
+    bucket.lastTick += added * freq / bucket.rate;
+    bucket.tokens =
+        static_cast<size_t>(std::min<u64>(bucket.tokens + added, bucket.burst));
+}
+
+size_t BandwidthLimiter::tryAcquire(TrafficClass cls, size_t wanted) noexcept {
+    if (wanted == 0) return 0;
+
+    const bool isMovie = cls == TrafficClass::Movie;
+
+    mutexLock(&m_mutex);
+    const u64 now = armGetSystemTick();
+    refill(m_global, now);
+    if (isMovie) refill(m_movie, now);
+
+    size_t available = std::numeric_limits<size_t>::max();
+    size_t rate = std::numeric_limits<size_t>::max();
+    if (m_global.rate > 0) {
+        available = m_global.tokens;
+        rate = m_global.rate;
+    }
+    if (isMovie && m_movie.rate > 0) {
+        available = std::min(available, m_movie.tokens);
+        rate = std::min(rate, m_movie.rate);
+    }
+
+    // Lower priority classes leave the tokens to waiting screenshots. A
+    // screenshot that stopped asking, e.g. because its transfer failed,
+    // no longer holds movies back after SCREENSHOT_WAIT_NS.
+    const bool yield = isMovie && m_screenshotWaitTick != 0 &&
+                       armTicksToNs(now - m_screenshotWaitTick) <
+                           SCREENSHOT_WAIT_NS;
+    const size_t need = std::min(wanted, MIN_GRANT);
+
+    if (!yield && available >= need) {
+        const size_t grant = std::min(wanted, available);
+        if (m_global.rate > 0) m_global.tokens -= grant;
+        if (isMovie && m_movie.rate > 0) m_movie.tokens -= grant;
+        if (!isMovie) m_screenshotWaitTick = 0;
+        mutexUnlock(&m_mutex);
+        return grant;
+    }
+
+    u64 waitNs = MIN_WAIT_NS;
+    if (!yield) {
+        waitNs = static_cast<u64>(need - available) * 1'000'000'000ULL / rate;
+    }
+    waitNs = std::clamp(waitNs, MIN_WAIT_NS, MAX_WAIT_NS);
+
+    const u64 resumeTick = now + armNsToTicks(waitNs);
+    if (m_resumeTick == 0 || resumeTick < m_resumeTick) {
+        m_resumeTick = resumeTick;
+    }
+    if (!isMovie) {
+        m_screenshotWaitTick = now;
+    }
+    mutexUnlock(&m_mutex);
+    return 0;
+}
+
+void BandwidthLimiter::refund(TrafficClass cls, size_t unused) noexcept {
+    if (unused == 0) return;
+
+    mutexLock(&m_mutex);
+    if (m_global.rate > 0) {
+        m_global.tokens = std::min(m_global.tokens + unused, m_global.burst);
+    }
+    if (cls == TrafficClass::Movie && m_movie.rate > 0) {
+        m_movie.tokens = std::min(m_movie.tokens + unused, m_movie.burst);
+    }
+    mutexUnlock(&m_mutex);
+}
+
+std::optional<u64> BandwidthLimiter::resumeDelayNs() noexcept {
+    mutexLock(&m_mutex);
+    std::optional<u64> delay;
+    if (m_resumeTick != 0) {
+        const u64 now = armGetSystemTick();
+        delay = m_resumeTick > now ? armTicksToNs(m_resumeTick - now) : 0;
+    }
+    mutexUnlock(&m_mutex);
+    return delay;
+}
+
+bool BandwidthLimiter::takeResume() noexcept {
+    mutexLock(&m_mutex);
+    const bool due = m_resumeTick != 0 && armGetSystemTick() >= m_resumeTick;
+    if (due) {
+        m_resumeTick = 0;
+    }
+    mutexUnlock(&m_mutex);
+    return due;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <switch.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+// Traffic classes in priority order, lower values are served first
+enum class TrafficClass : uint8_t {
+    Screenshot = 0,
+    Movie = 1,
+};
+
+/**
+ * Global token-bucket bandwidth limiter shared by all transfers.
+ * All rates are in bytes per second, 0 means unlimited.
+ * Thread-safe: concurrent uploads draw from the same buckets, and a movie
+ * transfer yields while any screenshot transfer is waiting for tokens.
+ * Nothing blocks: a transfer without tokens is paused and resumed by the
+ * transfer loop, so it never holds up the other streams it runs with.
+ */
+class BandwidthLimiter {
+   public:
+    static BandwidthLimiter& get() noexcept {
+        static BandwidthLimiter instance;
+        return instance;
+    }
+
+    void configure(size_t rate, size_t movieRate) noexcept;
+
+    [[nodiscard]] bool enabled() const noexcept {
+        return m_global.rate > 0 || m_movie.rate > 0;
+    }
+
+    // Effective rate for a traffic class (0 = unlimited)
+    [[nodiscard]] size_t rateFor(TrafficClass cls) const noexcept;
+
+    // Number of bytes the caller may send now (0..wanted). With 0 the
+    // caller pauses its transfer until takeResume() says to try again.
+    [[nodiscard]] size_t tryAcquire(TrafficClass cls, size_t wanted) noexcept;
+    // Give back the part of a grant that was not sent, e.g. after a short
+    // read at the end of a file
+    void refund(TrafficClass cls, size_t unused) noexcept;
+
+    // Time until a paused transfer may try again, nullopt when none is
+    // paused
+    [[nodiscard]] std::optional<u64> resumeDelayNs() noexcept;
+    // True once paused transfers may try again. The pause is then
+    // forgotten; transfers still short of tokens pause once more.
+    [[nodiscard]] bool takeResume() noexcept;
+
+   private:
+    struct Bucket {
+        size_t rate{0};
+        size_t burst{0};
+        size_t tokens{0};
+        u64 lastTick{0};
+    };
+
+    BandwidthLimiter() { mutexInit(&m_mutex); }
+    BandwidthLimiter(const BandwidthLimiter&) = delete;
+    BandwidthLimiter& operator=(const BandwidthLimiter&) = delete;
+
+    static void refill(Bucket& bucket, u64 now) noexcept;
+    static void setup(Bucket& bucket, size_t rate, u64 now) noexcept;
+
+    Mutex m_mutex;
+    Bucket m_global;
+    Bucket m_movie;
+    // Earliest tick a paused transfer may try again, 0 when none is paused
+    u64 m_resumeTick{0};
+    // Last time a screenshot was refused tokens, 0 once it got them
+    u64 m_screenshotWaitTick{0};
+};
@@ -0,0 +1,60 @@
+#include "circuit.hpp"
+
+#include <algorithm>
+
+#include "clock.hpp"
+#include "logger.hpp"
+
+bool CircuitBreaker::allows(Destination dest) noexcept {
+    Circuit& circuit = m_circuits[static_cast<size_t>(dest)];
+    if (circuit.state == State::Closed) {
+        return true;
+    }
+    // A half-open circuit waits for its probe. Probes that never reached
+    // the network leave no result, so they expire after a cooldown too.
+    const u64 now = Clock::get().tick();
+    if (armTicksToNs(now - circuit.sinceTick) < circuit.cooldownNs) {
+        Logger::get().debug() << "[" << destinationName(dest)
+                              << "] Circuit open, skipping attempt" << endl;
+        return false;
+    }
+    circuit.state = State::HalfOpen;
+    circuit.sinceTick = now;
+    Logger::get().info() << "[" << destinationName(dest)
+                         << "] Circuit half-open, sending a probe" << endl;
+    return true;
+}
+
+void CircuitBreaker::record(Destination dest, bool failed) noexcept {
+    Circuit& circuit = m_circuits[static_cast<size_t>(dest)];
+    if (!failed) {
+        if (circuit.state != State::Closed) {
+            Logger::get().info() << "[" << destinationName(dest)
+                                 << "] Circuit closed" << endl;
+        }
+        circuit = Circuit{};
+        return;
+    }
+
+    ++circuit.failures;
+    if (circuit.state == State::HalfOpen) {
+        circuit.cooldownNs = std::min(circuit.cooldownNs * 2, COOLDOWN_MAX_NS);
+    } else if (circuit.state == State::Open ||
+               circuit.failures < FAILURE_THRESHOLD) {
+        return;
+    }
+    circuit.state = State::Open;
+    circuit.sinceTick = Clock::get().tick();
+    Logger::get().warn() << "[" << destinationName(dest)
+                         << "] Circuit open after " << circuit.failures
+                         << " failures, pausing for "
+                         << circuit.cooldownNs / 1'000'000'000ULL << "s"
+                         << endl;
+}
+
+void CircuitBreaker::pause(Destination dest, u64 pauseNs) noexcept {
+    Circuit& circuit = m_circuits[static_cast<size_t>(dest)];
+    circuit.state = State::Open;
+    circuit.sinceTick = Clock::get().tick();
+    circuit.cooldownNs = pauseNs;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <switch.h>
+
+#include <array>
+
+#include "upload.hpp"
+
+// Whether a transfer shows its service failing: it didn't answer or
+// answered that it is unavailable. Other errors, e.g. a rejected file,
+// show that the service is up.
+[[nodiscard]] constexpr bool serviceFailed(bool completed,
+                                           long status) noexcept {
+    if (!completed) {
+        return status == 0 || status >= 500;
+    }
+    return status >= 500 || status == 429;
+}
+
+/**
+ * Circuit breaker per destination. After FAILURE_THRESHOLD failed
+ * transfers in a row the circuit opens and attempts fail right away, so a
+ * dead service doesn't cost every capture its retries and timeouts. Once
+ * the cooldown has passed a single probe goes through (half-open): success
+ * closes the circuit, failure opens it again for twice as long.
+ */
+class CircuitBreaker {
+   public:
+    // Consecutive failed transfers that open a destination's circuit
+    static constexpr int FAILURE_THRESHOLD = 3;
+    // Wait before probing an open circuit, doubled after every failed probe
+    static constexpr u64 COOLDOWN_NS = 60'000'000'000ULL;
+    static constexpr u64 COOLDOWN_MAX_NS = 900'000'000'000ULL;
+
+    static CircuitBreaker& get() noexcept {
+        static CircuitBreaker instance;
+        return instance;
+    }
+
+    // Whether an attempt on `dest` may go ahead
+    [[nodiscard]] bool allows(Destination dest) noexcept;
+    // Feed in the outcome of a transfer to `dest`
+    void record(Destination dest, bool failed) noexcept;
+    // Open the circuit of `dest` for `pauseNs`, e.g. as long as a rate
+    // limit lasts
+    void pause(Destination dest, u64 pauseNs) noexcept;
+    // Close every circuit, as after a restart
+    void reset() noexcept { m_circuits = {}; }
+
+   private:
+    enum class State : uint8_t { Closed, Open, HalfOpen };
+
+    struct Circuit {
+        State state{State::Closed};
+        int failures{0};
+        u64 sinceTick{0};  // Opened or last probe granted
+        u64 cooldownNs{COOLDOWN_NS};
+    };
+
+    CircuitBreaker() = default;
+    CircuitBreaker(const CircuitBreaker&) = delete;
+    CircuitBreaker& operator=(const CircuitBreaker&) = delete;
+
+    std::array<Circuit, DESTINATION_COUNT> m_circuits{};
+};
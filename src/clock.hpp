@@ -0,0 +1,44 @@
+#pragma once
+
+#include <switch.h>
+
+/**
+ * Time source of the upload scheduling: queue aging, batch lingering,
+ * idle timeouts and circuit breakers. It follows the system tick, except
+ * in a host replay of a trace (host/replay_trace.cpp), which runs it on
+ * virtual time: sleeping moves the clock forward instead of waiting, so
+ * hours of recorded use go through the real loop in seconds.
+ */
+class Clock {
+   public:
+    static Clock& get() noexcept {
+        static Clock instance;
+        return instance;
+    }
+
+    [[nodiscard]] u64 tick() const noexcept {
+        return m_virtual ? m_virtualTick : armGetSystemTick();
+    }
+
+    void sleep(u64 ns) noexcept {
+        if (m_virtual) {
+            m_virtualTick += armNsToTicks(ns);
+        } else {
+            svcSleepThread(static_cast<s64>(ns));
+        }
+    }
+
+    // Run on virtual time from `tick` on, for replays only
+    void setVirtual(u64 tick) noexcept {
+        m_virtual = true;
+        m_virtualTick = tick;
+    }
+
+   private:
+    Clock() = default;
+    Clock(const Clock&) = delete;
+    Clock& operator=(const Clock&) = delete;
+
+    u64 m_virtualTick{0};
+    bool m_virtual{false};
+};
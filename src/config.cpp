@@ -3,6 +3,8 @@
 #include <minIni.h>
 #include <sys/stat.h>
 
+#include <algorithm>
+
 #include "logger.hpp"
 #include "project.h"
 
@@ -37,6 +39,23 @@ static long ini_get_long(const char* section, const char* key,
     return ini_getl(section, key, default_value, CONFIG_PATH);
 }
 
+// Helper: split a comma-separated list, dropping spaces and empty entries
+static std::vector<std::string> split_list(std::string_view value) {
+    std::vector<std::string> items;
+    while (!value.empty()) {
+        const size_t comma = value.find(',');
+        std::string_view item = value.substr(0, comma);
+        while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+        while (!item.empty() && item.back() == ' ') item.remove_suffix(1);
+        if (!item.empty()) {
+            items.emplace_back(item);
+        }
+        if (comma == std::string_view::npos) break;
+        value.remove_prefix(comma + 1);
+    }
+    return items;
+}
+
 // Helper: check if config file exists
 static bool configFileExists() {
     struct stat buffer;
@@ -58,12 +77,14 @@ bool Config::refresh() {
         ini_get_bool("general", "ntfy", ConfigDefaults::NTFY_ENABLED);
     m_discordEnabled =
         ini_get_bool("general", "discord", ConfigDefaults::DISCORD_ENABLED);
+    m_s3Enabled = ini_get_bool("general", "s3", ConfigDefaults::S3_ENABLED);
 
     // Read Telegram configuration from [telegram] section
     m_telegramBotToken = ini_get_string("telegram", "bot_token",
                                         ConfigDefaults::TELEGRAM_BOT_TOKEN);
-    m_telegramChatId =
-        ini_get_string("telegram", "chat_id", ConfigDefaults::TELEGRAM_CHAT_ID);
+    // One or more chats, the capture is uploaded to the first one
+    m_telegramChatIds = split_list(ini_get_string(
+        "telegram", "chat_id", ConfigDefaults::TELEGRAM_CHAT_ID));
     m_telegramApiUrl =
         ini_get_string("telegram", "api_url", ConfigDefaults::TELEGRAM_API_URL);
     m_telegramUploadScreenshots =
@@ -76,6 +97,8 @@ bool Config::refresh() {
     // Stored directly as string to avoid unnecessary conversions
     m_telegramUploadMode = ini_get_string("telegram", "upload_mode",
                                           ConfigDefaults::TELEGRAM_UPLOAD_MODE);
+    m_telegramPreview = ini_get_bool("telegram", "preview",
+                                     ConfigDefaults::TELEGRAM_PREVIEW);
 
     // Read Ntfy configuration from [ntfy] section
     m_ntfyUrl = ini_get_string("ntfy", "url", ConfigDefaults::NTFY_URL);
@@ -91,8 +114,9 @@ bool Config::refresh() {
     // Read Discord configuration from [discord] section
     m_discordBotToken = ini_get_string("discord", "bot_token",
                                         ConfigDefaults::DISCORD_BOT_TOKEN);
-    m_discordChannelId =
-        ini_get_string("discord", "channel_id", ConfigDefaults::DISCORD_CHANNEL_ID);
+    // One or more channels, the capture is uploaded to the first one
+    m_discordChannelIds = split_list(ini_get_string(
+        "discord", "channel_id", ConfigDefaults::DISCORD_CHANNEL_ID));
     m_discordApiUrl =
         ini_get_string("discord", "api_url", ConfigDefaults::DISCORD_API_URL);
     m_discordUploadScreenshots =
@@ -101,6 +125,30 @@ bool Config::refresh() {
     m_discordUploadMovies = ini_get_bool(
         "discord", "upload_movies", ConfigDefaults::DISCORD_UPLOAD_MOVIES);                   
 
+    // Read S3 configuration from [s3] section
+    m_s3Endpoint =
+        ini_get_string("s3", "endpoint", ConfigDefaults::S3_ENDPOINT);
+    // No trailing slash, object paths are appended to the endpoint
+    while (m_s3Endpoint.ends_with('/')) {
+        m_s3Endpoint.pop_back();
+    }
+    m_s3Region = ini_get_string("s3", "region", ConfigDefaults::S3_REGION);
+    m_s3Bucket = ini_get_string("s3", "bucket", ConfigDefaults::S3_BUCKET);
+    m_s3AccessKey =
+        ini_get_string("s3", "access_key", ConfigDefaults::S3_ACCESS_KEY);
+    m_s3SecretKey =
+        ini_get_string("s3", "secret_key", ConfigDefaults::S3_SECRET_KEY);
+    m_s3Prefix = ini_get_string("s3", "prefix", ConfigDefaults::S3_PREFIX);
+    m_s3UploadScreenshots = ini_get_bool(
+        "s3", "upload_screenshots", ConfigDefaults::S3_UPLOAD_SCREENSHOTS);
+    m_s3UploadMovies =
+        ini_get_bool("s3", "upload_movies", ConfigDefaults::S3_UPLOAD_MOVIES);
+    m_s3PartSizeMb = std::clamp(
+        static_cast<int>(ini_get_long("s3", "part_size_mb",
+                                      ConfigDefaults::S3_PART_SIZE_MB)),
+        ConfigDefaults::S3_PART_SIZE_MINIMUM,
+        ConfigDefaults::S3_PART_SIZE_MAXIMUM);
+
     // Read general settings
     m_keepLogs =
         ini_get_bool("general", "keep_logs", ConfigDefaults::KEEP_LOGS);
@@ -111,6 +159,43 @@ bool Config::refresh() {
                                       ConfigDefaults::CHECK_INTERVAL_SECONDS)),
         ConfigDefaults::CHECK_INTERVAL_MINIMUM);
 
+    m_skipDuplicates = ini_get_bool("general", "skip_duplicates",
+                                    ConfigDefaults::SKIP_DUPLICATES);
+
+    m_sendDigest =
+        ini_get_bool("general", "send_digest", ConfigDefaults::SEND_DIGEST);
+
+    // Read retry spool size per destination, 0 disables the spool
+    m_spoolMaxItems = std::clamp(
+        static_cast<int>(ini_get_long("general", "spool_max_items",
+                                      ConfigDefaults::SPOOL_MAX_ITEMS)),
+        0, ConfigDefaults::SPOOL_MAX_ITEMS_MAXIMUM);
+
+    m_traceEnabled =
+        ini_get_bool("general", "trace", ConfigDefaults::TRACE_ENABLED);
+
+    // Read network idle timeout (seconds), 0 keeps the network up
+    m_networkIdleTimeout = std::clamp(
+        static_cast<int>(ini_get_long("general", "network_idle_timeout",
+                                      ConfigDefaults::NETWORK_IDLE_TIMEOUT)),
+        0, ConfigDefaults::NETWORK_IDLE_TIMEOUT_MAXIMUM);
+
+    // Read batch linger window (milliseconds), 0 disables batching
+    m_batchLingerMs = std::clamp(
+        static_cast<int>(ini_get_long("general", "batch_linger_ms",
+                                      ConfigDefaults::BATCH_LINGER_MS)),
+        0, ConfigDefaults::BATCH_LINGER_MAXIMUM);
+
+    // Read bandwidth limits (KB/s), negative values are treated as unlimited
+    m_uploadRateLimit = std::max(
+        static_cast<int>(ini_get_long("general", "rate_limit",
+                                      ConfigDefaults::UPLOAD_RATE_LIMIT)),
+        0);
+    m_movieRateLimit = std::max(
+        static_cast<int>(ini_get_long("general", "movie_rate_limit",
+                                      ConfigDefaults::MOVIE_RATE_LIMIT)),
+        0);
+
     // ========================================================================
     // Validate configuration and disable invalid channels
     // ========================================================================
@@ -125,9 +210,37 @@ bool Config::refresh() {
         m_telegramUploadMode = ConfigDefaults::TELEGRAM_UPLOAD_MODE;
     }
 
+    // Read backfill range, a single day when only `from` is set
+    m_backfillFrom =
+        ini_get_string("backfill", "from", ConfigDefaults::BACKFILL_FROM, 16);
+    m_backfillTo =
+        ini_get_string("backfill", "to", ConfigDefaults::BACKFILL_TO, 16);
+    if (m_backfillTo.empty()) {
+        m_backfillTo = m_backfillFrom;
+    }
+    if (!m_backfillFrom.empty() &&
+        (!ConfigDefaults::isDateValid(m_backfillFrom) ||
+         !ConfigDefaults::isDateValid(m_backfillTo) ||
+         m_backfillFrom > m_backfillTo)) {
+        Logger::get().warn()
+            << "Backfill disabled: Invalid range '" << m_backfillFrom
+            << "' to '" << m_backfillTo << "' (expected YYYY-MM-DD)" << endl;
+        m_backfillFrom.clear();
+        m_backfillTo.clear();
+    }
+
+    // Read LAN pull server settings from [server] section
+    m_serverEnabled =
+        ini_get_bool("server", "enabled", ConfigDefaults::SERVER_ENABLED);
+    m_serverPort = std::clamp(
+        static_cast<int>(ini_get_long("server", "port",
+                                      ConfigDefaults::SERVER_PORT)),
+        ConfigDefaults::SERVER_PORT_MINIMUM,
+        ConfigDefaults::SERVER_PORT_MAXIMUM);
+
     // Validate Telegram configuration
     if (m_telegramEnabled && !ConfigDefaults::isTelegramValid(
-                                 m_telegramBotToken, m_telegramChatId)) {
+                                 m_telegramBotToken, getTelegramChatId())) {
         Logger::get().warn()
             << "Telegram channel disabled: Invalid or missing configuration "
                "(bot_token and/or chat_id are not set or are set to "
@@ -147,7 +260,7 @@ bool Config::refresh() {
 
     // Validate Discord configuration
     if (m_discordEnabled && !ConfigDefaults::isDiscordValid(
-                                 m_discordBotToken, m_discordChannelId)) {
+                                 m_discordBotToken, getDiscordChannelId())) {
         Logger::get().warn()
             << "discord channel disabled: Invalid or missing configuration "
                "(bot_token and/or channel_id are not set or are set to "
@@ -156,8 +269,20 @@ bool Config::refresh() {
         m_discordEnabled = false;
     }
 
+    // Validate S3 configuration
+    if (m_s3Enabled &&
+        !ConfigDefaults::isS3Valid(m_s3Endpoint, m_s3Bucket, m_s3AccessKey,
+                                   m_s3SecretKey)) {
+        Logger::get().warn()
+            << "S3 channel disabled: Invalid or missing configuration "
+               "(endpoint, bucket, access_key and/or secret_key are not set)"
+            << endl;
+        m_s3Enabled = false;
+    }
+
     // Check if at least one channel is enabled
-    if (!m_telegramEnabled && !m_ntfyEnabled && !m_discordEnabled) {
+    if (!m_telegramEnabled && !m_ntfyEnabled && !m_discordEnabled &&
+        !m_s3Enabled) {
         return false;  // Indicate failure - no valid upload channel available
     }
 
@@ -169,7 +294,8 @@ std::string_view Config::getTelegramBotToken() const noexcept {
 }
 
 std::string_view Config::getTelegramChatId() const noexcept {
-    return m_telegramChatId;
+    return m_telegramChatIds.empty() ? std::string_view{}
+                                     : m_telegramChatIds.front();
 }
 
 std::string_view Config::getTelegramApiUrl() const noexcept {
@@ -181,7 +307,8 @@ std::string_view Config::getDiscordBotToken() const noexcept {
 }
 
 std::string_view Config::getDiscordChannelId() const noexcept {
-    return m_discordChannelId;
+    return m_discordChannelIds.empty() ? std::string_view{}
+                                       : m_discordChannelIds.front();
 }
 
 std::string_view Config::getDiscordApiUrl() const noexcept {
@@ -197,3 +324,29 @@ std::string_view Config::getNtfyToken() const noexcept { return m_ntfyToken; }
 std::string_view Config::getNtfyPriority() const noexcept {
     return m_ntfyPriority;
 }
+
+std::string_view Config::getS3Endpoint() const noexcept {
+    return m_s3Endpoint;
+}
+
+std::string_view Config::getS3Region() const noexcept { return m_s3Region; }
+
+std::string_view Config::getS3Bucket() const noexcept { return m_s3Bucket; }
+
+std::string_view Config::getS3AccessKey() const noexcept {
+    return m_s3AccessKey;
+}
+
+std::string_view Config::getS3SecretKey() const noexcept {
+    return m_s3SecretKey;
+}
+
+std::string_view Config::getS3Prefix() const noexcept { return m_s3Prefix; }
+
+std::string_view Config::getBackfillFrom() const noexcept {
+    return m_backfillFrom;
+}
+
+std::string_view Config::getBackfillTo() const noexcept {
+    return m_backfillTo;
+}
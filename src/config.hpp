@@ -1,7 +1,9 @@
 #pragma once
 
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "config_defaults.hpp"
 
@@ -21,6 +23,32 @@ class Config {
     [[nodiscard]] constexpr bool keepLogs() const noexcept {
         return m_keepLogs;
     }
+    [[nodiscard]] constexpr int getBatchLingerMs() const noexcept {
+        return m_batchLingerMs;
+    }
+    [[nodiscard]] constexpr bool skipDuplicates() const noexcept {
+        return m_skipDuplicates;
+    }
+    [[nodiscard]] constexpr bool sendDigest() const noexcept {
+        return m_sendDigest;
+    }
+    [[nodiscard]] constexpr int getSpoolMaxItems() const noexcept {
+        return m_spoolMaxItems;
+    }
+    [[nodiscard]] constexpr bool traceEnabled() const noexcept {
+        return m_traceEnabled;
+    }
+    [[nodiscard]] constexpr int getNetworkIdleTimeout() const noexcept {
+        return m_networkIdleTimeout;
+    }
+
+    // Bandwidth limits in KB/s (0 = unlimited)
+    [[nodiscard]] constexpr int getUploadRateLimit() const noexcept {
+        return m_uploadRateLimit;
+    }
+    [[nodiscard]] constexpr int getMovieRateLimit() const noexcept {
+        return m_movieRateLimit;
+    }
 
     // Upload destination toggles
     [[nodiscard]] constexpr bool telegramEnabled() const noexcept {
@@ -32,10 +60,19 @@ class Config {
     [[nodiscard]] constexpr bool discordEnabled() const noexcept {
         return m_discordEnabled;
     }
+    [[nodiscard]] constexpr bool s3Enabled() const noexcept {
+        return m_s3Enabled;
+    }
 
     // Telegram configuration
     [[nodiscard]] std::string_view getTelegramBotToken() const noexcept;
+    // First configured chat, the one captures are uploaded to
     [[nodiscard]] std::string_view getTelegramChatId() const noexcept;
+    // All chats, the first one followed by those that get a copy
+    [[nodiscard]] std::span<const std::string> getTelegramChatIds()
+        const noexcept {
+        return m_telegramChatIds;
+    }
     [[nodiscard]] std::string_view getTelegramApiUrl() const noexcept;
     [[nodiscard]] constexpr bool telegramUploadScreenshots() const noexcept {
         return m_telegramUploadScreenshots;
@@ -46,6 +83,9 @@ class Config {
     [[nodiscard]] std::string_view getTelegramUploadMode() const noexcept {
         return m_telegramUploadMode;
     }
+    [[nodiscard]] constexpr bool telegramPreview() const noexcept {
+        return m_telegramPreview;
+    }
 
     // Ntfy configuration
     [[nodiscard]] std::string_view getNtfyUrl() const noexcept;
@@ -61,7 +101,13 @@ class Config {
 
     // Discord configuration
     [[nodiscard]] std::string_view getDiscordBotToken() const noexcept;
+    // First configured channel, the one captures are uploaded to
     [[nodiscard]] std::string_view getDiscordChannelId() const noexcept;
+    // All channels, the first one followed by those that get a forward
+    [[nodiscard]] std::span<const std::string> getDiscordChannelIds()
+        const noexcept {
+        return m_discordChannelIds;
+    }
     [[nodiscard]] std::string_view getDiscordApiUrl() const noexcept;
     [[nodiscard]] constexpr bool discordUploadScreenshots() const noexcept {
         return m_discordUploadScreenshots;
@@ -70,6 +116,38 @@ class Config {
         return m_discordUploadMovies;
     }
 
+    // S3 configuration
+    [[nodiscard]] std::string_view getS3Endpoint() const noexcept;
+    [[nodiscard]] std::string_view getS3Region() const noexcept;
+    [[nodiscard]] std::string_view getS3Bucket() const noexcept;
+    [[nodiscard]] std::string_view getS3AccessKey() const noexcept;
+    [[nodiscard]] std::string_view getS3SecretKey() const noexcept;
+    [[nodiscard]] std::string_view getS3Prefix() const noexcept;
+    [[nodiscard]] constexpr bool s3UploadScreenshots() const noexcept {
+        return m_s3UploadScreenshots;
+    }
+    [[nodiscard]] constexpr bool s3UploadMovies() const noexcept {
+        return m_s3UploadMovies;
+    }
+    [[nodiscard]] constexpr int getS3PartSizeMb() const noexcept {
+        return m_s3PartSizeMb;
+    }
+
+    // Backfill range, empty when disabled
+    [[nodiscard]] std::string_view getBackfillFrom() const noexcept;
+    [[nodiscard]] std::string_view getBackfillTo() const noexcept;
+    [[nodiscard]] bool backfillEnabled() const noexcept {
+        return !m_backfillFrom.empty();
+    }
+
+    // LAN pull server
+    [[nodiscard]] constexpr bool serverEnabled() const noexcept {
+        return m_serverEnabled;
+    }
+    [[nodiscard]] constexpr int getServerPort() const noexcept {
+        return m_serverPort;
+    }
+
     bool error{false};
 
    private:
@@ -81,15 +159,17 @@ class Config {
     bool m_telegramEnabled{ConfigDefaults::TELEGRAM_ENABLED};
     bool m_ntfyEnabled{ConfigDefaults::NTFY_ENABLED};
     bool m_discordEnabled{ConfigDefaults::DISCORD_ENABLED};
+    bool m_s3Enabled{ConfigDefaults::S3_ENABLED};
 
     // Telegram configuration
     std::string m_telegramBotToken{ConfigDefaults::TELEGRAM_BOT_TOKEN};
-    std::string m_telegramChatId{ConfigDefaults::TELEGRAM_CHAT_ID};
+    std::vector<std::string> m_telegramChatIds;
     std::string m_telegramApiUrl{ConfigDefaults::TELEGRAM_API_URL};
     bool m_telegramUploadScreenshots{
         ConfigDefaults::TELEGRAM_UPLOAD_SCREENSHOTS};
     bool m_telegramUploadMovies{ConfigDefaults::TELEGRAM_UPLOAD_MOVIES};
     std::string m_telegramUploadMode{ConfigDefaults::TELEGRAM_UPLOAD_MODE};
+    bool m_telegramPreview{ConfigDefaults::TELEGRAM_PREVIEW};
 
     // Ntfy configuration
     std::string m_ntfyUrl{ConfigDefaults::NTFY_URL};
@@ -101,13 +181,42 @@ class Config {
 
     // Discord configuration
     std::string m_discordBotToken{ConfigDefaults::DISCORD_BOT_TOKEN};
-    std::string m_discordChannelId{ConfigDefaults::DISCORD_CHANNEL_ID};
+    std::vector<std::string> m_discordChannelIds;
     std::string m_discordApiUrl{ConfigDefaults::DISCORD_API_URL};
     bool m_discordUploadScreenshots{
         ConfigDefaults::DISCORD_UPLOAD_SCREENSHOTS};
     bool m_discordUploadMovies{ConfigDefaults::DISCORD_UPLOAD_MOVIES};
 
+    // S3 configuration
+    std::string m_s3Endpoint{ConfigDefaults::S3_ENDPOINT};
+    std::string m_s3Region{ConfigDefaults::S3_REGION};
+    std::string m_s3Bucket{ConfigDefaults::S3_BUCKET};
+    std::string m_s3AccessKey{ConfigDefaults::S3_ACCESS_KEY};
+    std::string m_s3SecretKey{ConfigDefaults::S3_SECRET_KEY};
+    std::string m_s3Prefix{ConfigDefaults::S3_PREFIX};
+    bool m_s3UploadScreenshots{ConfigDefaults::S3_UPLOAD_SCREENSHOTS};
+    bool m_s3UploadMovies{ConfigDefaults::S3_UPLOAD_MOVIES};
+    int m_s3PartSizeMb{ConfigDefaults::S3_PART_SIZE_MB};
+
     // General settings
     bool m_keepLogs{ConfigDefaults::KEEP_LOGS};
     int m_checkIntervalSeconds{ConfigDefaults::CHECK_INTERVAL_SECONDS};
+    int m_batchLingerMs{ConfigDefaults::BATCH_LINGER_MS};
+    bool m_skipDuplicates{ConfigDefaults::SKIP_DUPLICATES};
+    bool m_sendDigest{ConfigDefaults::SEND_DIGEST};
+    int m_spoolMaxItems{ConfigDefaults::SPOOL_MAX_ITEMS};
+    bool m_traceEnabled{ConfigDefaults::TRACE_ENABLED};
+    int m_networkIdleTimeout{ConfigDefaults::NETWORK_IDLE_TIMEOUT};
+
+    // Backfill range
+    std::string m_backfillFrom{ConfigDefaults::BACKFILL_FROM};
+    std::string m_backfillTo{ConfigDefaults::BACKFILL_TO};
+
+    // LAN pull server
+    bool m_serverEnabled{ConfigDefaults::SERVER_ENABLED};
+    int m_serverPort{ConfigDefaults::SERVER_PORT};
+
+    // Bandwidth limits
+    int m_uploadRateLimit{ConfigDefaults::UPLOAD_RATE_LIMIT};
+    int m_movieRateLimit{ConfigDefaults::MOVIE_RATE_LIMIT};
 };
@@ -24,6 +24,21 @@ namespace ConfigDefaults {
 constexpr int CHECK_INTERVAL_SECONDS = 3;
 constexpr int CHECK_INTERVAL_MINIMUM = 1;
 constexpr bool KEEP_LOGS = false;
+constexpr int BATCH_LINGER_MS = 0;
+constexpr int BATCH_LINGER_MAXIMUM = 10000;
+constexpr bool SKIP_DUPLICATES = true;
+constexpr bool SEND_DIGEST = false;
+constexpr int SPOOL_MAX_ITEMS = 64;
+constexpr int SPOOL_MAX_ITEMS_MAXIMUM = 1024;
+constexpr bool TRACE_ENABLED = false;
+constexpr int NETWORK_IDLE_TIMEOUT = 0;
+constexpr int NETWORK_IDLE_TIMEOUT_MAXIMUM = 86400;
+
+// ============================================================================
+// Bandwidth limits (KB/s, 0 = unlimited)
+// ============================================================================
+constexpr int UPLOAD_RATE_LIMIT = 0;
+constexpr int MOVIE_RATE_LIMIT = 0;
 
 // ============================================================================
 // Upload destination toggles
@@ -31,6 +46,7 @@ constexpr bool KEEP_LOGS = false;
 constexpr bool TELEGRAM_ENABLED = false;
 constexpr bool NTFY_ENABLED = false;
 constexpr bool DISCORD_ENABLED = true;
+constexpr bool S3_ENABLED = false;
 
 // ============================================================================
 // Telegram configuration
@@ -41,6 +57,7 @@ constexpr std::string_view TELEGRAM_API_URL = "https://api.telegram.org";
 constexpr bool TELEGRAM_UPLOAD_SCREENSHOTS = true;
 constexpr bool TELEGRAM_UPLOAD_MOVIES = true;
 constexpr std::string_view TELEGRAM_UPLOAD_MODE = UploadMode::Compressed;
+constexpr bool TELEGRAM_PREVIEW = false;
 
 // ============================================================================
 // Ntfy configuration
@@ -61,6 +78,36 @@ constexpr std::string_view DISCORD_API_URL = "https://discord.com/api/v10";
 constexpr bool DISCORD_UPLOAD_SCREENSHOTS = true;
 constexpr bool DISCORD_UPLOAD_MOVIES = false;
 
+// ============================================================================
+// S3-compatible storage configuration
+// ============================================================================
+constexpr std::string_view S3_ENDPOINT = "";
+constexpr std::string_view S3_REGION = "us-east-1";
+constexpr std::string_view S3_BUCKET = "";
+constexpr std::string_view S3_ACCESS_KEY = "";
+constexpr std::string_view S3_SECRET_KEY = "";
+constexpr std::string_view S3_PREFIX = "";
+constexpr bool S3_UPLOAD_SCREENSHOTS = true;
+constexpr bool S3_UPLOAD_MOVIES = true;
+// Multipart part size in MB, S3 requires at least 5MB per part
+constexpr int S3_PART_SIZE_MB = 8;
+constexpr int S3_PART_SIZE_MINIMUM = 5;
+constexpr int S3_PART_SIZE_MAXIMUM = 512;
+
+// ============================================================================
+// Backfill range (YYYY-MM-DD, empty = disabled)
+// ============================================================================
+constexpr std::string_view BACKFILL_FROM = "";
+constexpr std::string_view BACKFILL_TO = "";
+
+// ============================================================================
+// LAN pull server
+// ============================================================================
+constexpr bool SERVER_ENABLED = false;
+constexpr int SERVER_PORT = 8080;
+constexpr int SERVER_PORT_MINIMUM = 1024;
+constexpr int SERVER_PORT_MAXIMUM = 65535;
+
 // ============================================================================
 // Configuration validation utilities
 // ============================================================================
@@ -74,6 +121,34 @@ constexpr bool isUploadModeValid(std::string_view mode) noexcept {
            mode == UploadMode::Both;
 }
 
+/**
+ * Check if S3 configuration is valid
+ * Returns true if S3 is properly configured
+ */
+constexpr bool isS3Valid(std::string_view endpoint, std::string_view bucket,
+                         std::string_view accessKey,
+                         std::string_view secretKey) noexcept {
+    // The endpoint must name its scheme, everything else must be set
+    return (endpoint.starts_with("http://") ||
+            endpoint.starts_with("https://")) &&
+           !bucket.empty() && !accessKey.empty() && !secretKey.empty();
+}
+
+/**
+ * Check if a date is in YYYY-MM-DD form
+ * Returns true if every position holds a digit or the expected dash
+ */
+constexpr bool isDateValid(std::string_view date) noexcept {
+    if (date.size() != 10) return false;
+    for (size_t i = 0; i < date.size(); ++i) {
+        const bool isDash = i == 4 || i == 7;
+        if (isDash ? date[i] != '-' : (date[i] < '0' || date[i] > '9')) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /**
  * Check if Telegram configuration is valid
  * Returns true if Telegram is properly configured
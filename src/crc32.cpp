@@ -0,0 +1,94 @@
+#include "crc32.hpp"
+
+#include <cstring>
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#elif defined(__SSE4_2__)
+#include <nmmintrin.h>
+#else
+#include <array>
+#endif
+
+namespace {
+
+#if defined(__ARM_FEATURE_CRC32)
+
+inline uint32_t crcByte(uint32_t crc, uint8_t value) noexcept {
+    return __crc32cb(crc, value);
+}
+
+inline uint32_t crcWord(uint32_t crc, uint64_t value) noexcept {
+    return __crc32cd(crc, value);
+}
+
+#elif defined(__SSE4_2__)
+
+inline uint32_t crcByte(uint32_t crc, uint8_t value) noexcept {
+    return _mm_crc32_u8(crc, value);
+}
+
+inline uint32_t crcWord(uint32_t crc, uint64_t value) noexcept {
+    return static_cast<uint32_t>(_mm_crc32_u64(crc, value));
+}
+
+#else
+
+// Reflected Castagnoli polynomial
+constexpr uint32_t CRC32C_POLY = 0x82F63B78;
+
+constexpr std::array<uint32_t, 256> makeTable() noexcept {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < table.size(); ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<uint32_t, 256> CRC_TABLE = makeTable();
+
+inline uint32_t crcByte(uint32_t crc, uint8_t value) noexcept {
+    return (crc >> 8) ^ CRC_TABLE[(crc ^ value) & 0xFF];
+}
+
+inline uint32_t crcWord(uint32_t crc, uint64_t value) noexcept {
+    // Little-endian byte order, same as the hardware instructions
+    for (int i = 0; i < 8; ++i) {
+        crc = crcByte(crc, static_cast<uint8_t>(value >> (i * 8)));
+    }
+    return crc;
+}
+
+#endif
+
+}  // namespace
+
+uint32_t crc32c(uint32_t crc, const void* data, size_t size) noexcept {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+
+    // Align to 8 bytes, then consume whole words
+    while (size > 0 && (reinterpret_cast<uintptr_t>(bytes) & 7) != 0) {
+        crc = crcByte(crc, *bytes++);
+        --size;
+    }
+
+    while (size >= sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        crc = crcWord(crc, word);
+        bytes += sizeof(word);
+        size -= sizeof(word);
+    }
+
+    while (size > 0) {
+        crc = crcByte(crc, *bytes++);
+        --size;
+    }
+
+    return ~crc;
+}
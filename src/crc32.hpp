@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32C (Castagnoli) of a buffer, continuing from a previous value
+// (start with 0). Uses the ARMv8 CRC32 instructions on the Switch, SSE4.2
+// on x86 hosts and a table-driven fallback elsewhere.
+[[nodiscard]] uint32_t crc32c(uint32_t crc, const void* data,
+                              size_t size) noexcept;
@@ -0,0 +1,189 @@
+#include "exif.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace {
+
+constexpr uint8_t MARKER_PREFIX = 0xFF;
+constexpr uint8_t MARKER_SOI = 0xD8;
+constexpr uint8_t MARKER_SOS = 0xDA;
+constexpr uint8_t MARKER_APP1 = 0xE1;
+// Metadata segments come first, give up if EXIF isn't among them
+constexpr int MAX_SEGMENTS = 8;
+
+constexpr std::array<uint8_t, 6> EXIF_HEADER{'E', 'x', 'i', 'f', 0, 0};
+constexpr size_t TIFF_HEADER_SIZE = 8;
+constexpr size_t IFD_ENTRY_SIZE = 12;
+// IFDs of thumbnails written by cameras and consoles are short
+constexpr uint16_t MAX_IFD_ENTRIES = 64;
+
+constexpr uint16_t TYPE_SHORT = 3;
+constexpr uint16_t TYPE_LONG = 4;
+constexpr uint16_t TAG_THUMBNAIL_OFFSET = 0x0201;  // JPEGInterchangeFormat
+constexpr uint16_t TAG_THUMBNAIL_LENGTH = 0x0202;
+
+[[nodiscard]] bool readAt(FILE* f, size_t offset, void* buffer,
+                          size_t length) {
+    return std::fseek(f, static_cast<long>(offset), SEEK_SET) == 0 &&
+           std::fread(buffer, 1, length, f) == length;
+}
+
+// Reads TIFF integers in the byte order the TIFF header declares
+struct TiffReader {
+    bool bigEndian{false};
+
+    [[nodiscard]] uint16_t u16(const uint8_t* p) const noexcept {
+        return bigEndian ? static_cast<uint16_t>((p[0] << 8) | p[1])
+                         : static_cast<uint16_t>((p[1] << 8) | p[0]);
+    }
+    [[nodiscard]] uint32_t u32(const uint8_t* p) const noexcept {
+        return bigEndian ? (static_cast<uint32_t>(u16(p)) << 16) | u16(p + 2)
+                         : (static_cast<uint32_t>(u16(p + 2)) << 16) | u16(p);
+    }
+    // Value of a SHORT or LONG entry with a count of one
+    [[nodiscard]] std::optional<uint32_t> value(
+        const uint8_t* entry) const noexcept {
+        if (u32(entry + 4) != 1) return std::nullopt;
+        switch (u16(entry + 2)) {
+            case TYPE_SHORT:
+                return u16(entry + 8);
+            case TYPE_LONG:
+                return u32(entry + 8);
+            default:
+                return std::nullopt;
+        }
+    }
+};
+
+// Locate the TIFF data of the APP1 segment. Sets `tiffStart` and
+// `tiffSize` on success.
+[[nodiscard]] bool findExif(FILE* f, size_t fileSize, size_t& tiffStart,
+                            size_t& tiffSize) {
+    std::array<uint8_t, 4> header{};
+    if (!readAt(f, 0, header.data(), 2) || header[0] != MARKER_PREFIX ||
+        header[1] != MARKER_SOI) {
+        return false;
+    }
+
+    size_t offset = 2;
+    for (int i = 0; i < MAX_SEGMENTS; ++i) {
+        // Marker followed by the segment length, which counts itself
+        if (offset + header.size() > fileSize ||
+            !readAt(f, offset, header.data(), header.size()) ||
+            header[0] != MARKER_PREFIX || header[1] == MARKER_SOS) {
+            return false;
+        }
+        const size_t length = (static_cast<size_t>(header[2]) << 8) |
+                              header[3];
+        if (length < 2 || offset + 2 + length > fileSize) {
+            return false;
+        }
+
+        if (header[1] == MARKER_APP1 &&
+            length >= 2 + EXIF_HEADER.size() + TIFF_HEADER_SIZE) {
+            std::array<uint8_t, EXIF_HEADER.size()> exif{};
+            if (!readAt(f, offset + 4, exif.data(), exif.size())) {
+                return false;
+            }
+            if (exif == EXIF_HEADER) {
+                tiffStart = offset + 4 + EXIF_HEADER.size();
+                tiffSize = length - 2 - EXIF_HEADER.size();
+                return true;
+            }
+        }
+        offset += 2 + length;
+    }
+    return false;
+}
+
+// Number of entries of the IFD at `ifd`, if the IFD including the offset
+// of the next one lies within the TIFF data
+[[nodiscard]] std::optional<uint16_t> readIfdCount(FILE* f, size_t tiffStart,
+                                                   size_t tiffSize, size_t ifd,
+                                                   const TiffReader& reader) {
+    std::array<uint8_t, 2> count{};
+    if (ifd < TIFF_HEADER_SIZE || ifd + count.size() > tiffSize ||
+        !readAt(f, tiffStart + ifd, count.data(), count.size())) {
+        return std::nullopt;
+    }
+    const uint16_t entries = reader.u16(count.data());
+    if (entries > MAX_IFD_ENTRIES ||
+        ifd + 2 + entries * IFD_ENTRY_SIZE + 4 > tiffSize) {
+        return std::nullopt;
+    }
+    return entries;
+}
+
+}  // namespace
+
+std::optional<ExifThumbnail> exifFindThumbnail(FILE* f, size_t fileSize) {
+    size_t tiffStart = 0;
+    size_t tiffSize = 0;
+    if (!findExif(f, fileSize, tiffStart, tiffSize)) {
+        return std::nullopt;
+    }
+
+    std::array<uint8_t, TIFF_HEADER_SIZE> tiff{};
+    if (!readAt(f, tiffStart, tiff.data(), tiff.size())) {
+        return std::nullopt;
+    }
+    TiffReader reader;
+    if (tiff[0] == 'M' && tiff[1] == 'M') {
+        reader.bigEndian = true;
+    } else if (tiff[0] != 'I' || tiff[1] != 'I') {
+        return std::nullopt;
+    }
+    if (reader.u16(&tiff[2]) != 42) {
+        return std::nullopt;
+    }
+
+    // IFD0 describes the main image, the offset after its entries leads to
+    // IFD1 which describes the thumbnail. Offsets are relative to the TIFF
+    // header.
+    const uint32_t ifd0 = reader.u32(&tiff[4]);
+    const auto ifd0Count = readIfdCount(f, tiffStart, tiffSize, ifd0, reader);
+    if (!ifd0Count) {
+        return std::nullopt;
+    }
+    std::array<uint8_t, IFD_ENTRY_SIZE> entry{};
+    if (!readAt(f, tiffStart + ifd0 + 2 + *ifd0Count * IFD_ENTRY_SIZE,
+                entry.data(), 4)) {
+        return std::nullopt;
+    }
+    const uint32_t ifd1 = reader.u32(entry.data());
+    const auto ifd1Count = readIfdCount(f, tiffStart, tiffSize, ifd1, reader);
+    if (!ifd1Count) {
+        return std::nullopt;  // No thumbnail
+    }
+
+    std::optional<uint32_t> thumbnailOffset;
+    std::optional<uint32_t> thumbnailLength;
+    for (uint16_t i = 0; i < *ifd1Count; ++i) {
+        if (!readAt(f, tiffStart + ifd1 + 2 + i * IFD_ENTRY_SIZE,
+                    entry.data(), entry.size())) {
+            return std::nullopt;
+        }
+        const uint16_t tag = reader.u16(entry.data());
+        if (tag == TAG_THUMBNAIL_OFFSET) {
+            thumbnailOffset = reader.value(entry.data());
+        } else if (tag == TAG_THUMBNAIL_LENGTH) {
+            thumbnailLength = reader.value(entry.data());
+        }
+    }
+    if (!thumbnailOffset || !thumbnailLength || *thumbnailLength < 4 ||
+        *thumbnailOffset > tiffSize ||
+        *thumbnailLength > tiffSize - *thumbnailOffset) {
+        return std::nullopt;
+    }
+
+    // The thumbnail must be a JPEG itself, older files may carry raw pixels
+    const ExifThumbnail thumbnail{tiffStart + *thumbnailOffset,
+                                  *thumbnailLength};
+    std::array<uint8_t, 2> soi{};
+    if (!readAt(f, thumbnail.offset, soi.data(), soi.size()) ||
+        soi[0] != MARKER_PREFIX || soi[1] != MARKER_SOI) {
+        return std::nullopt;
+    }
+    return thumbnail;
+}
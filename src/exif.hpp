@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <optional>
+
+// Location of the JPEG thumbnail embedded in a JPEG file's EXIF data
+struct ExifThumbnail {
+    size_t offset{0};  // From the start of the file
+    size_t length{0};
+};
+
+// Find the thumbnail that IFD1 of the APP1 (EXIF) segment points to. Only
+// segment headers and IFD entries are read, nothing is decoded. The file
+// position is left undefined.
+[[nodiscard]] std::optional<ExifThumbnail> exifFindThumbnail(FILE* f,
+                                                             size_t fileSize);
@@ -0,0 +1,180 @@
+#include "fingerprint.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <string>
+
+#include "crc32.hpp"
+#include "logger.hpp"
+
+namespace {
+constexpr uint32_t FINGERPRINTS_MAGIC = 0x3246584E;  // "NXF2"
+constexpr size_t HASH_BUFFER_SIZE = 0x2000;          // 8KB
+// Bytes hashed at each end of a file for the quick comparison
+constexpr size_t EDGE_SIZE = 0x1000;  // 4KB
+
+// On-disk header, followed by CAPACITY records
+struct FileHeader {
+    uint32_t magic;
+    uint32_t count;
+    uint32_t next;
+};
+
+// Hash the first and last EDGE_SIZE bytes of a file. Captures of the same
+// size almost always differ there already, their JPEG or MP4 headers
+// carry the capture time.
+[[nodiscard]] bool hashEdges(std::string_view path, size_t size,
+                             uint32_t& crc) {
+    FILE* f = std::fopen(std::string(path).c_str(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+
+    std::array<uint8_t, EDGE_SIZE> buffer;
+    const size_t head = std::min(size, EDGE_SIZE);
+    bool ok = std::fread(buffer.data(), 1, head, f) == head;
+    crc = crc32c(0, buffer.data(), head);
+
+    const size_t tailStart = std::max(head, size - head);
+    const size_t tail = size - tailStart;
+    if (ok && tail > 0) {
+        ok = std::fseek(f, static_cast<long>(tailStart), SEEK_SET) == 0 &&
+             std::fread(buffer.data(), 1, tail, f) == tail;
+        crc = crc32c(crc, buffer.data(), tail);
+    }
+
+    std::fclose(f);
+    return ok;
+}
+
+// Hash a whole file, only used when a recorded entry has the same size
+// and edges
+[[nodiscard]] bool hashFile(std::string_view path, uint32_t& crc) {
+    FILE* f = std::fopen(std::string(path).c_str(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+
+    std::array<uint8_t, HASH_BUFFER_SIZE> buffer;
+    crc = 0;
+    size_t bytesRead;
+    while ((bytesRead = std::fread(buffer.data(), 1, buffer.size(), f)) > 0) {
+        crc = crc32c(crc, buffer.data(), bytesRead);
+    }
+
+    const bool ok = !std::ferror(f);
+    std::fclose(f);
+    return ok;
+}
+}  // namespace
+
+void FingerprintStore::load() {
+    m_count = 0;
+    m_next = 0;
+    m_synced = false;
+
+    FILE* f = std::fopen(FINGERPRINTS_PATH.data(), "rb");
+    if (f == nullptr) {
+        return;
+    }
+
+    FileHeader header{};
+    if (std::fread(&header, sizeof(header), 1, f) == 1 &&
+        header.magic == FINGERPRINTS_MAGIC && header.count <= CAPACITY &&
+        header.next < CAPACITY &&
+        std::fread(m_entries.data(), sizeof(Fingerprint), header.count, f) ==
+            header.count) {
+        m_count = header.count;
+        m_next = header.next;
+        m_synced = true;
+    } else {
+        // Including files of older versions, which had no edge CRC
+        Logger::get().warn() << "Ignoring invalid fingerprint file" << endl;
+    }
+
+    std::fclose(f);
+}
+
+bool FingerprintStore::containsSize(uint32_t size) const noexcept {
+    for (size_t i = 0; i < m_count; ++i) {
+        if (m_entries[i].size == size) return true;
+    }
+    return false;
+}
+
+bool FingerprintStore::containsEdges(uint32_t size,
+                                     uint32_t edgeCrc) const noexcept {
+    for (size_t i = 0; i < m_count; ++i) {
+        if (m_entries[i].size == size && m_entries[i].edgeCrc == edgeCrc) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FingerprintStore::contains(uint32_t size, uint32_t crc) const noexcept {
+    for (size_t i = 0; i < m_count; ++i) {
+        if (m_entries[i].size == size && m_entries[i].crc == crc) return true;
+    }
+    return false;
+}
+
+bool FingerprintStore::isDuplicate(std::string_view path, size_t size) const {
+    const auto size32 = static_cast<uint32_t>(size);
+    if (!containsSize(size32)) {
+        return false;
+    }
+
+    uint32_t edgeCrc;
+    if (!hashEdges(path, size, edgeCrc) || !containsEdges(size32, edgeCrc)) {
+        return false;
+    }
+
+    uint32_t crc;
+    return hashFile(path, crc) && contains(size32, crc);
+}
+
+void FingerprintStore::add(std::string_view path, size_t size, uint32_t crc) {
+    const auto size32 = static_cast<uint32_t>(size);
+    uint32_t edgeCrc;
+    if (contains(size32, crc) || !hashEdges(path, size, edgeCrc)) {
+        return;
+    }
+
+    const size_t index = m_next;
+    m_entries[index] = Fingerprint{size32, edgeCrc, crc};
+    m_next = (m_next + 1) % CAPACITY;
+    if (m_count < CAPACITY) ++m_count;
+
+    persist(index);
+}
+
+void FingerprintStore::persist(size_t index) {
+    // Rewrite only the header and the changed record. A missing or
+    // outdated file is written whole, or the entries it lacks would be
+    // lost on the next load.
+    FILE* f = m_synced ? std::fopen(FINGERPRINTS_PATH.data(), "r+b") : nullptr;
+    const bool whole = f == nullptr;
+    if (whole) {
+        f = std::fopen(FINGERPRINTS_PATH.data(), "wb");
+    }
+    if (f == nullptr) {
+        Logger::get().error() << "Unable to write fingerprint file" << endl;
+        m_synced = false;
+        return;
+    }
+
+    const FileHeader header{FINGERPRINTS_MAGIC, static_cast<uint32_t>(m_count),
+                            static_cast<uint32_t>(m_next)};
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1;
+    if (whole) {
+        ok = ok && std::fwrite(m_entries.data(), sizeof(Fingerprint), m_count,
+                               f) == m_count;
+    } else {
+        const size_t offset = sizeof(header) + index * sizeof(Fingerprint);
+        ok = ok && std::fseek(f, static_cast<long>(offset), SEEK_SET) == 0 &&
+             std::fwrite(&m_entries[index], sizeof(Fingerprint), 1, f) == 1;
+    }
+    m_synced = std::fclose(f) == 0 && ok;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "project.h"
+
+inline constexpr std::string_view FINGERPRINTS_PATH =
+    "sdmc:/config/" APP_TITLE "/fingerprints.bin";
+
+// Content fingerprint of an uploaded capture
+struct Fingerprint {
+    uint32_t size;
+    uint32_t edgeCrc;  // Of the first and last few KB
+    uint32_t crc;      // Of the whole file
+};
+
+/**
+ * Compact persistent set of fingerprints of already uploaded captures.
+ * Holds the most recent CAPACITY entries in a ring that is mirrored to the
+ * SD card record by record. Lookups first match on file size, then on a
+ * CRC of both ends of the file, so that the file only has to be hashed
+ * whole when an entry matches both.
+ */
+class FingerprintStore {
+   public:
+    static constexpr size_t CAPACITY = 512;
+
+    static FingerprintStore& get() noexcept {
+        static FingerprintStore instance;
+        return instance;
+    }
+
+    void load();
+
+    // True when the file content matches a recorded upload
+    [[nodiscard]] bool isDuplicate(std::string_view path, size_t size) const;
+    // Record an upload of `path` whose content hashed to `crc`
+    void add(std::string_view path, size_t size, uint32_t crc);
+
+    [[nodiscard]] size_t count() const noexcept { return m_count; }
+
+   private:
+    FingerprintStore() = default;
+    FingerprintStore(const FingerprintStore&) = delete;
+    FingerprintStore& operator=(const FingerprintStore&) = delete;
+
+    [[nodiscard]] bool containsSize(uint32_t size) const noexcept;
+    [[nodiscard]] bool containsEdges(uint32_t size,
+                                     uint32_t edgeCrc) const noexcept;
+    [[nodiscard]] bool contains(uint32_t size, uint32_t crc) const noexcept;
+    void persist(size_t index);
+
+    std::array<Fingerprint, CAPACITY> m_entries{};
+    size_t m_count{0};
+    size_t m_next{0};
+    // Whether the file holds every entry, otherwise the next write
+    // replaces it as a whole
+    bool m_synced{false};
+};
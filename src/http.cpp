@@ -0,0 +1,163 @@
+#include "http.hpp"
+
+#include <algorithm>
+
+#include "bandwidth.hpp"
+#include "logger.hpp"
+
+namespace {
+// Longest wait for socket activity while transfers run concurrently
+constexpr int POLL_TIMEOUT_MS = 1000;
+
+// Wait for socket activity, but not past the time a paused transfer may
+// go on
+int pollTimeoutMs() {
+    const auto resumeNs = BandwidthLimiter::get().resumeDelayNs();
+    if (!resumeNs.has_value()) {
+        return POLL_TIMEOUT_MS;
+    }
+    const u64 resumeMs = (resumeNs.value() + 999'999ULL) / 1'000'000ULL;
+    return static_cast<int>(
+        std::min<u64>(resumeMs, static_cast<u64>(POLL_TIMEOUT_MS)));
+}
+}  // namespace
+
+bool HttpSession::setup() {
+    if (m_share != nullptr) {
+        return true;
+    }
+
+    m_share = curl_share_init();
+    if (m_share == nullptr) {
+        Logger::get().error() << "curl_share_init() failed" << endl;
+        return false;
+    }
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    if (m_multi == nullptr) {
+        // Every transfer runs on the multi handle, throttled transfers
+        // can only be resumed from its loop
+        m_multi = curl_multi_init();
+        if (m_multi == nullptr) {
+            Logger::get().error() << "curl_multi_init() failed" << endl;
+            return false;
+        }
+        curl_multi_setopt(m_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        // HTTP/2 multiplexes on one connection (PIPEWAIT), HTTP/1.1
+        // needs a connection per parallel transfer
+        curl_multi_setopt(m_multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+                          MAX_STREAMS);
+        curl_multi_setopt(m_multi, CURLMOPT_MAX_CONCURRENT_STREAMS,
+                          MAX_STREAMS);
+
+        const curl_version_info_data* info =
+            curl_version_info(CURLVERSION_NOW);
+        m_http2 = info != nullptr && (info->features & CURL_VERSION_HTTP2);
+        Logger::get().info() << (m_http2 ? "HTTP/2 enabled"
+                                         : "HTTP/2 unavailable, using HTTP/1.1")
+                             << endl;
+    }
+
+    return true;
+}
+
+CURL* HttpSession::createHandle() {
+    if (!setup()) {
+        return nullptr;
+    }
+
+    CURL* curl = curl_easy_init();
+    if (curl == nullptr) {
+        return nullptr;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_SHARE, m_share);
+    if (m_http2) {
+        // Negotiated through ALPN, servers without h2 get HTTP/1.1
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION,
+                         CURL_HTTP_VERSION_2TLS);
+        // Wait for a connection that can multiplex rather than opening
+        // another one
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+    }
+    return curl;
+}
+
+void HttpSession::performAll(std::span<CURL* const> handles,
+                             std::span<CURLcode> results) {
+    for (size_t i = 0; i < handles.size(); ++i) {
+        results[i] = CURLE_FAILED_INIT;
+        curl_multi_add_handle(m_multi, handles[i]);
+    }
+
+    int running = 0;
+    do {
+        CURLMcode mc = curl_multi_perform(m_multi, &running);
+        if (mc == CURLM_OK && running > 0) {
+            mc = curl_multi_poll(m_multi, nullptr, 0, pollTimeoutMs(),
+                                 nullptr);
+        }
+        if (mc != CURLM_OK) {
+            Logger::get().error()
+                << "curl_multi failed: " << curl_multi_strerror(mc) << endl;
+            break;
+        }
+        // Transfers still short of tokens pause again right away
+        if (BandwidthLimiter::get().takeResume()) {
+            for (CURL* curl : handles) {
+                curl_easy_pause(curl, CURLPAUSE_CONT);
+            }
+        }
+    } while (running > 0);
+
+    int queued = 0;
+    while (CURLMsg* msg = curl_multi_info_read(m_multi, &queued)) {
+        if (msg->msg != CURLMSG_DONE) continue;
+        for (size_t i = 0; i < handles.size(); ++i) {
+            if (handles[i] == msg->easy_handle) {
+                results[i] = msg->data.result;
+            }
+        }
+    }
+
+    for (CURL* curl : handles) {
+        curl_multi_remove_handle(m_multi, curl);
+    }
+    m_lastTransferTick = armGetSystemTick();
+}
+
+CURLcode HttpSession::perform(CURL* curl) {
+    CURLcode result = CURLE_FAILED_INIT;
+    performAll({&curl, 1}, {&result, 1});
+    return result;
+}
+
+void HttpSession::closeIdle(u64 idleNs) {
+    if (m_share == nullptr ||
+        armTicksToNs(armGetSystemTick() - m_lastTransferTick) < idleNs) {
+        return;
+    }
+    Logger::get().debug() << "Closing idle connections" << endl;
+    closeConnections();
+}
+
+void HttpSession::closeConnections() {
+    // Connections live in the share, dropping it closes them. All handles
+    // have been cleaned up by now, so nothing references it.
+    if (m_share != nullptr) {
+        curl_share_cleanup(m_share);
+        m_share = nullptr;
+    }
+}
+
+void HttpSession::cleanup() {
+    closeConnections();
+    if (m_multi != nullptr) {
+        curl_multi_cleanup(m_multi);
+        m_multi = nullptr;
+    }
+}
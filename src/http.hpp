@@ -0,0 +1,64 @@
+#pragma once
+
+#include <curl/curl.h>
+#include <switch.h>
+
+#include <cstddef>
+#include <span>
+
+// Socket send buffer bounds. The socket service reserves memory for the
+// maximum, uploads to low-BDP destinations use less.
+inline constexpr size_t TCP_TX_BUF_SIZE = 0x800;
+inline constexpr size_t TCP_TX_BUF_SIZE_MAX = 0x2EE0;
+
+/**
+ * Shared HTTP transport for all uploads.
+ * Handles created here share one connection, DNS and TLS session cache, so
+ * consecutive uploads to the same host reuse a warm connection instead of
+ * paying a new handshake and slow start. HTTP/2 is negotiated when libcurl
+ * supports it, with HTTP/1.1 as fallback, and concurrent transfers to one
+ * host are multiplexed over a single connection.
+ */
+class HttpSession {
+   public:
+    // Parallel transfers per host: streams of one h2 connection, or
+    // HTTP/1.1 connections, each with its own socket and TLS buffers
+    static constexpr long MAX_STREAMS = 2;
+
+    static HttpSession& get() noexcept {
+        static HttpSession instance;
+        return instance;
+    }
+
+    // New easy handle bound to the shared caches, nullptr on failure
+    [[nodiscard]] CURL* createHandle();
+
+    // Run transfers concurrently and store each handle's result. Transfers
+    // paused by the bandwidth limiter are resumed as tokens come in.
+    void performAll(std::span<CURL* const> handles,
+                    std::span<CURLcode> results);
+    // Run a single transfer, see performAll()
+    [[nodiscard]] CURLcode perform(CURL* curl);
+
+    // Close the connections once no transfer has run for `idleNs`, freeing
+    // their sockets and TLS state
+    void closeIdle(u64 idleNs);
+    // Release everything, must run before curl_global_cleanup()
+    void cleanup();
+
+    [[nodiscard]] bool http2() const noexcept { return m_http2; }
+
+   private:
+    HttpSession() = default;
+    HttpSession(const HttpSession&) = delete;
+    HttpSession& operator=(const HttpSession&) = delete;
+
+    bool setup();
+    void closeConnections();
+
+    CURLSH* m_share{nullptr};
+    CURLM* m_multi{nullptr};
+    // End of the last transfer
+    u64 m_lastTransferTick{0};
+    bool m_http2{false};
+};
@@ -0,0 +1,272 @@
+#include "json_stream.hpp"
+
+#include <algorithm>
+
+namespace {
+[[nodiscard]] constexpr bool isSpace(char c) noexcept {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+[[nodiscard]] constexpr bool isLiteralChar(char c) noexcept {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+           c == '-' || c == '+' || c == '.' || c == 'E';
+}
+
+// Character a simple escape like \n stands for, \" \\ and \/ stand for
+// themselves
+[[nodiscard]] constexpr char unescaped(char c) noexcept {
+    switch (c) {
+        case 'b':
+            return '\b';
+        case 'f':
+            return '\f';
+        case 'n':
+            return '\n';
+        case 'r':
+            return '\r';
+        case 't':
+            return '\t';
+        default:
+            return c;
+    }
+}
+
+[[nodiscard]] constexpr int hexValue(char c) noexcept {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+}  // namespace
+
+void JsonStream::feed(std::string_view bytes) noexcept {
+    for (const char c : bytes) {
+        if (m_state == State::Failed) return;
+        step(c);
+    }
+}
+
+std::string_view JsonStream::key(size_t level) const noexcept {
+    if (level >= m_depth || level >= MAX_DEPTH) return {};
+    const Level& l = m_levels[level];
+    return {l.key.data(), l.keyLength};
+}
+
+bool JsonStream::isArray(size_t level) const noexcept {
+    return level < m_depth && ((m_arrays >> level) & 1) != 0;
+}
+
+uint32_t JsonStream::index(size_t level) const noexcept {
+    if (level >= m_depth || level >= MAX_DEPTH) return 0;
+    return m_levels[level].index;
+}
+
+bool JsonStream::path(
+    std::initializer_list<std::string_view> parts) const noexcept {
+    if (parts.size() != m_depth) return false;
+    size_t level = 0;
+    for (const std::string_view part : parts) {
+        const bool matches =
+            isArray(level) ? part == "*" : part == key(level);
+        if (!matches) return false;
+        ++level;
+    }
+    return true;
+}
+
+void JsonStream::step(char c) noexcept {
+    switch (m_state) {
+        case State::String:
+            if (c == '"') {
+                finishString();
+            } else if (c == '\\') {
+                m_state = State::Escape;
+            } else {
+                append(c);
+            }
+            return;
+
+        case State::Escape:
+            if (c == 'u') {
+                m_codePoint = 0;
+                m_unicodeDigits = 0;
+                m_state = State::Unicode;
+            } else {
+                append(unescaped(c));
+                m_state = State::String;
+            }
+            return;
+
+        case State::Unicode: {
+            const int digit = hexValue(c);
+            if (digit < 0) {
+                m_state = State::Failed;
+                return;
+            }
+            m_codePoint = (m_codePoint << 4) | static_cast<uint32_t>(digit);
+            if (++m_unicodeDigits == 4) {
+                appendCodePoint(m_codePoint);
+                m_state = State::String;
+            }
+            return;
+        }
+
+        case State::Literal:
+            if (isLiteralChar(c)) {
+                append(c);
+                return;
+            }
+            finishLiteral();
+            break;  // The delimiter is handled below
+
+        default:
+            break;
+    }
+
+    if (isSpace(c)) return;
+
+    switch (m_state) {
+        case State::Value:
+            if (!startValue(c)) m_state = State::Failed;
+            return;
+
+        case State::ValueOrEnd:
+            if (c == ']') {
+                pop(c);
+            } else if (!startValue(c)) {
+                m_state = State::Failed;
+            }
+            return;
+
+        case State::KeyOrEnd:
+            if (c == '}') {
+                pop(c);
+                return;
+            }
+            [[fallthrough]];
+        case State::Key:
+            if (c == '"') {
+                m_valueLength = 0;
+                m_stringIsKey = true;
+                m_state = State::String;
+            } else {
+                m_state = State::Failed;
+            }
+            return;
+
+        case State::Colon:
+            m_state = c == ':' ? State::Value : State::Failed;
+            return;
+
+        case State::AfterValue:
+            if (c == ',') {
+                const bool inArray = isArray(m_depth - 1);
+                if (inArray && m_depth <= MAX_DEPTH) {
+                    ++m_levels[m_depth - 1].index;
+                }
+                m_state = inArray ? State::Value : State::Key;
+            } else if (c == '}' || c == ']') {
+                pop(c);
+            } else {
+                m_state = State::Failed;
+            }
+            return;
+
+        case State::Done:
+        default:
+            m_state = State::Failed;
+            return;
+    }
+}
+
+bool JsonStream::startValue(char c) noexcept {
+    if (c == '{') {
+        m_state = State::KeyOrEnd;
+        push(false);
+    } else if (c == '[') {
+        m_state = State::ValueOrEnd;
+        push(true);
+    } else if (c == '"') {
+        m_valueLength = 0;
+        m_stringIsKey = false;
+        m_state = State::String;
+    } else if (isLiteralChar(c)) {
+        m_valueLength = 0;
+        append(c);
+        m_state = State::Literal;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void JsonStream::push(bool isArray) noexcept {
+    if (m_depth == MAX_NESTING) {
+        m_state = State::Failed;
+        return;
+    }
+    if (m_depth < MAX_DEPTH) {
+        m_levels[m_depth] = Level{};
+    }
+    const uint64_t bit = uint64_t{1} << m_depth;
+    m_arrays = isArray ? m_arrays | bit : m_arrays & ~bit;
+    ++m_depth;
+}
+
+void JsonStream::pop(char close) noexcept {
+    if (m_depth == 0 || isArray(m_depth - 1) != (close == ']')) {
+        m_state = State::Failed;
+        return;
+    }
+    --m_depth;
+    m_state = m_depth == 0 ? State::Done : State::AfterValue;
+}
+
+void JsonStream::append(char c) noexcept {
+    if (m_valueLength < m_value.size()) {
+        m_value[m_valueLength++] = c;
+    }
+}
+
+void JsonStream::appendCodePoint(uint32_t codePoint) noexcept {
+    if (codePoint < 0x80) {
+        append(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        append(static_cast<char>(0xC0 | (codePoint >> 6)));
+        append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint >= 0xD800 && codePoint < 0xE000) {
+        append('?');  // Surrogate pairs are not combined
+    } else {
+        append(static_cast<char>(0xE0 | (codePoint >> 12)));
+        append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+void JsonStream::finishString() noexcept {
+    if (!m_stringIsKey) {
+        emit(true);
+        m_state = m_depth == 0 ? State::Done : State::AfterValue;
+        return;
+    }
+
+    if (m_depth <= MAX_DEPTH) {
+        Level& level = m_levels[m_depth - 1];
+        level.keyLength =
+            static_cast<uint8_t>(std::min(m_valueLength, level.key.size()));
+        std::copy_n(m_value.begin(), level.keyLength, level.key.begin());
+    }
+    m_state = State::Colon;
+}
+
+void JsonStream::finishLiteral() noexcept {
+    emit(false);
+    m_state = m_depth == 0 ? State::Done : State::AfterValue;
+}
+
+void JsonStream::emit(bool isString) noexcept {
+    if (m_depth <= MAX_DEPTH) {
+        m_handler(m_context, *this, {m_value.data(), m_valueLength},
+                  isString);
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+
+/**
+ * Incremental JSON scanner for API responses.
+ * Bytes are fed as they arrive and every scalar value is reported to a
+ * handler together with its path, so a response is never buffered and
+ * nothing is allocated. Keys and values longer than the fixed buffers are
+ * truncated; values nested deeper than MAX_DEPTH are skipped. Anything
+ * that is not JSON, e.g. an HTML error page from a proxy, or nesting
+ * deeper than MAX_NESTING stops the scan.
+ */
+class JsonStream {
+   public:
+    static constexpr size_t MAX_DEPTH = 8;
+    static constexpr size_t MAX_NESTING = 64;
+    static constexpr size_t MAX_KEY = 32;
+    static constexpr size_t MAX_VALUE = 256;
+
+    // Called for every string, number, boolean and null. `isString` tells
+    // "1" from 1; strings are unescaped.
+    using Handler = void (*)(void* context, const JsonStream& json,
+                             std::string_view value, bool isString);
+
+    JsonStream(Handler handler, void* context) noexcept
+        : m_handler(handler), m_context(context) {}
+
+    void feed(std::string_view bytes) noexcept;
+
+    // Path of the value being reported: the number of enclosing containers
+    // and, per level, the member name or the array index
+    [[nodiscard]] size_t depth() const noexcept { return m_depth; }
+    [[nodiscard]] std::string_view key(size_t level) const noexcept;
+    [[nodiscard]] bool isArray(size_t level) const noexcept;
+    [[nodiscard]] uint32_t index(size_t level) const noexcept;
+    // Whether the path is exactly `parts`, where "*" matches any element
+    // of an array, e.g. path({"result", "photo", "*", "file_id"})
+    [[nodiscard]] bool path(
+        std::initializer_list<std::string_view> parts) const noexcept;
+
+    [[nodiscard]] bool failed() const noexcept {
+        return m_state == State::Failed;
+    }
+
+   private:
+    enum class State : uint8_t {
+        Value,        // Expecting a value
+        ValueOrEnd,   // Expecting a value or ']' right after '['
+        Key,          // Expecting a member name
+        KeyOrEnd,     // Expecting a member name or '}' right after '{'
+        Colon,        // Expecting ':' after a member name
+        AfterValue,   // Expecting ',' or the end of the container
+        String,       // Inside a string
+        Escape,       // After a backslash inside a string
+        Unicode,      // Inside a \uXXXX escape
+        Literal,      // Inside a number, true, false or null
+        Done,         // The root value is complete
+        Failed,
+    };
+
+    struct Level {
+        std::array<char, MAX_KEY> key{};
+        uint8_t keyLength{0};
+        uint32_t index{0};
+    };
+
+    void step(char c) noexcept;
+    bool startValue(char c) noexcept;
+    void push(bool isArray) noexcept;
+    void pop(char close) noexcept;
+    void append(char c) noexcept;
+    void appendCodePoint(uint32_t codePoint) noexcept;
+    void finishString() noexcept;
+    void finishLiteral() noexcept;
+    void emit(bool isString) noexcept;
+
+    Handler m_handler;
+    void* m_context;
+    std::array<Level, MAX_DEPTH> m_levels{};
+    std::array<char, MAX_VALUE> m_value{};
+    size_t m_valueLength{0};
+    size_t m_depth{0};
+    uint64_t m_arrays{0};  // Bit per level, set for arrays
+    uint32_t m_codePoint{0};
+    uint8_t m_unicodeDigits{0};
+    bool m_stringIsKey{false};
+    State m_state{State::Value};
+};
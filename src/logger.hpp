@@ -5,6 +5,8 @@
 #include <string_view>
 #include <utility>
 
+#include <switch.h>
+
 #include "project.h"
 
 #ifdef DEBUG
@@ -27,17 +29,22 @@ inline constexpr std::string_view LOGFILE_PATH =
     "sdmc:/config/" APP_TITLE "/logs.txt";
 
 // Lightweight string builder for log messages
+// Holds the logger lock, if given, until destroyed so lines written by
+// different threads never interleave
 class LogMessage {
    public:
-    LogMessage(FILE* file, const char* prefix) : m_file(file) {
+    LogMessage(FILE* file, const char* prefix, RMutex* lock = nullptr)
+        : m_file(file), m_lock(lock) {
         if (m_file && prefix) {
             std::fputs(prefix, m_file);
         }
     }
 
     // Move constructor
-    LogMessage(LogMessage&& other) noexcept : m_file(other.m_file) {
+    LogMessage(LogMessage&& other) noexcept
+        : m_file(other.m_file), m_lock(other.m_lock) {
         other.m_file = nullptr;
+        other.m_lock = nullptr;
     }
 
     // Delete copy operations
@@ -50,6 +57,9 @@ class LogMessage {
         if (m_file) {
             std::fflush(m_file);
         }
+        if (m_lock) {
+            rmutexUnlock(m_lock);
+        }
     }
 
     LogMessage& operator<<(const char* str) {
@@ -102,6 +112,7 @@ class LogMessage {
 
    private:
     FILE* m_file;
+    RMutex* m_lock;
 };
 
 class Logger {
@@ -114,69 +125,51 @@ class Logger {
     ~Logger() { close(); }
 
     void truncate() {
+        rmutexLock(&m_mutex);
         close();
         FILE* f = std::fopen(LOGFILE_PATH.data(), "w");
         if (f) std::fclose(f);
+        rmutexUnlock(&m_mutex);
     }
 
     constexpr void setLevel(LogLevel level) noexcept { m_level = level; }
 
+    // Waits for messages of other threads, never call it while holding a
+    // LogMessage of your own
     void close() {
+        rmutexLock(&m_mutex);
         if (m_file) {
             std::fclose(m_file);
             m_file = nullptr;
         }
+        rmutexUnlock(&m_mutex);
     }
 
     [[nodiscard]] constexpr bool isEnabled(LogLevel level) const noexcept {
         return std::to_underlying(level) >= std::to_underlying(m_level);
     }
 
-    LogMessage debug() {
-        if (isEnabled(LogLevel::DEBUG)) {
-            open();
-            return LogMessage(m_file, getPrefix(LogLevel::DEBUG));
-        }
-        return LogMessage(nullptr, nullptr);
-    }
-
-    LogMessage info() {
-        if (isEnabled(LogLevel::INFO)) {
-            open();
-            return LogMessage(m_file, getPrefix(LogLevel::INFO));
-        }
-        return LogMessage(nullptr, nullptr);
-    }
-
-    LogMessage warn() {
-        if (isEnabled(LogLevel::WARN)) {
-            open();
-            return LogMessage(m_file, getPrefix(LogLevel::WARN));
-        }
-        return LogMessage(nullptr, nullptr);
-    }
-
-    LogMessage error() {
-        if (isEnabled(LogLevel::ERROR)) {
-            open();
-            return LogMessage(m_file, getPrefix(LogLevel::ERROR));
-        }
-        return LogMessage(nullptr, nullptr);
-    }
-
-    LogMessage none() {
-        if (isEnabled(LogLevel::NONE)) {
-            open();
-            return LogMessage(m_file, getPrefix(LogLevel::NONE));
-        }
-        return LogMessage(nullptr, nullptr);
-    }
+    LogMessage debug() { return message(LogLevel::DEBUG); }
+    LogMessage info() { return message(LogLevel::INFO); }
+    LogMessage warn() { return message(LogLevel::WARN); }
+    LogMessage error() { return message(LogLevel::ERROR); }
+    LogMessage none() { return message(LogLevel::NONE); }
 
    private:
     Logger() = default;
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
+    // The returned message keeps the log locked while it is alive
+    LogMessage message(LogLevel level) {
+        if (!isEnabled(level)) {
+            return LogMessage(nullptr, nullptr);
+        }
+        rmutexLock(&m_mutex);
+        open();
+        return LogMessage(m_file, getPrefix(level), &m_mutex);
+    }
+
     void open() {
         if (!m_file) {
             m_file = std::fopen(LOGFILE_PATH.data(), "a");
@@ -219,4 +212,6 @@ class Logger {
 
     FILE* m_file = nullptr;
     LogLevel m_level{LogLevel::INFO};
+    // Recursive, a thread may log while building another message
+    RMutex m_mutex{};
 };
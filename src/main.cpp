@@ -1,26 +1,36 @@
-#include <curl/curl.h>
 #include <dirent.h>
 #include <switch.h>
 
+#include <expected>
+#include <string>
 #include <string_view>
 
+#include "album_scanner.hpp"
+#include "backfill.hpp"
+#include "bandwidth.hpp"
 #include "config.hpp"
+#include "fingerprint.hpp"
 #include "logger.hpp"
+#include "network.hpp"
 #include "project.h"
-#include "upload.hpp"
+#include "scheduler.hpp"
+#include "server.hpp"
+#include "sigv4.hpp"
+#include "spool.hpp"
+#include "title_index.hpp"
+#include "trace.hpp"
+#include "upload_queue.hpp"
 #include "utils.hpp"
 
 namespace {
 // Reduce heap size for memory optimization
 // 0x40000 (256KB) will oom, 0x50000 (320KB) is minimum stable
 constexpr size_t INNER_HEAP_SIZE = 0x50000;
-constexpr size_t TCP_TX_BUF_SIZE = 0x800;
-constexpr size_t TCP_RX_BUF_SIZE = 0x1000;
-constexpr size_t TCP_TX_BUF_SIZE_MAX = 0x2EE0;
-constexpr size_t TCP_RX_BUF_SIZE_MAX = 0x2EE0;
-constexpr size_t UDP_TX_BUF_SIZE = 0;
-constexpr size_t UDP_RX_BUF_SIZE = 0;
-constexpr size_t SB_EFFICIENCY = 4;
+
+constexpr std::string_view separator = "=============================";
+
+// Process start, for the startup time in the log
+u64 g_startTick = 0;
 }  // namespace
 
 extern "C" {
@@ -45,6 +55,7 @@ void __libnx_initheap(void) {
 }
 
 void __appInit(void) {
+    g_startTick = armGetSystemTick();
     Result rc;
 
     rc = smInitialize();
@@ -72,22 +83,7 @@ void __appInit(void) {
         fatalThrow(rc);
     }
 
-    constexpr SocketInitConfig socket_config = {
-        .tcp_tx_buf_size = TCP_TX_BUF_SIZE,
-        .tcp_rx_buf_size = TCP_RX_BUF_SIZE,
-        .tcp_tx_buf_max_size = TCP_TX_BUF_SIZE_MAX,
-        .tcp_rx_buf_max_size = TCP_RX_BUF_SIZE_MAX,
-
-        .udp_tx_buf_size = UDP_TX_BUF_SIZE,
-        .udp_rx_buf_size = UDP_RX_BUF_SIZE,
-
-        .sb_efficiency = SB_EFFICIENCY,
-    };
-
-    rc = socketInitialize(&socket_config);
-    if (R_FAILED(rc)) {
-        fatalThrow(rc);
-    }
+    // Sockets and curl are started on the first upload, see startNetwork()
 
     rc = capsaInitialize();
     if (R_FAILED(rc)) {
@@ -100,17 +96,18 @@ void __appInit(void) {
     }
 
     fsdevMountSdmc();
-
-    curl_global_init(CURL_GLOBAL_DEFAULT);
 }
 
 void __appExit(void) {
-    curl_global_cleanup();
+    AlbumScanner::get().stop();
+    PullServer::get().stop();
+    closeSigV4Clock();
+    stopNetwork();
+    closeNetworkProbe();
     fsdevUnmountAll();
     fsExit();
     capsaExit();
     nsExit();
-    socketExit();
     smExit();
 }
 }
@@ -122,7 +119,6 @@ void initLogger(bool truncate) {
 
     // Logger::get().setLevel(LogLevel::DEBUG);
 
-    constexpr std::string_view separator = "=============================";
     auto logger = Logger::get().none();
     logger << separator << endl;
     logger << APP_TITLE " v" << APP_VERSION << " is starting..." << endl;
@@ -135,6 +131,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
 
     mkdir(configDir.data(), 0700);
     mkdir(appConfigDir.data(), 0700);
+    mkdir(SPOOL_DIR.data(), 0700);
 
     // Initialize logger first (with truncate) before loading config
     // so that config errors are properly logged
@@ -143,7 +140,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
     if (!Config::get().refresh()) {
         Logger::get().error()
             << "Configuration validation failed: No valid upload channel "
-               "available (Telegram, Ntfy and Discord are disabled or "
+               "available (Telegram, Ntfy, Discord and S3 are disabled or "
                "misconfigured)."
             << endl;
         Logger::get().error() << "Please check your config.ini file and ensure "
@@ -213,6 +210,9 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
         if (Config::get().discordEnabled()) {
             logger << "[Discord]";
         }
+        if (Config::get().s3Enabled()) {
+            logger << "[S3]";
+        }
         logger << endl;
     }
 
@@ -230,120 +230,114 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
         static_cast<u64>(checkInterval) * 1'000'000'000ULL;
     Logger::get().info() << "Check interval: " << checkInterval << " second(s)"
                          << endl;
+
+    // Configure the shared bandwidth limiter (KB/s -> bytes/s)
+    const int rateLimit = Config::get().getUploadRateLimit();
+    const int movieRateLimit = Config::get().getMovieRateLimit();
+    BandwidthLimiter::get().configure(
+        static_cast<size_t>(rateLimit) * 1024,
+        static_cast<size_t>(movieRateLimit) * 1024);
+    if (BandwidthLimiter::get().enabled()) {
+        Logger::get().info() << "Bandwidth limit: " << rateLimit
+                             << " KB/s, movies: " << movieRateLimit << " KB/s"
+                             << endl;
+    }
     Logger::get().close();
 
-    constexpr std::string_view separator = "=============================";
-    constexpr int maxRetries = 3;
+    if (Config::get().skipDuplicates()) {
+        FingerprintStore::get().load();
+        Logger::get().info() << "Loaded " << FingerprintStore::get().count()
+                             << " upload fingerprint(s)" << endl;
+        Logger::get().close();
+    }
 
-    // Helper lambda to retry upload with max attempts
-    const auto retryUpload = [maxRetries]<typename F>(F&& uploadFunc) {
-        for (int retry = 0; retry < maxRetries; ++retry) {
-            if (uploadFunc()) return true;
-        }
-        return false;
-    };
+    if (TitleIndex::get().load()) {
+        Logger::get().info() << "Loaded title index with "
+                             << TitleIndex::get().count() << " game(s)"
+                             << endl;
+        Logger::get().close();
+    }
 
-    while (true) {
-        auto tmpItemResult = getLastAlbumItem();
+    const int spoolMaxItems = Config::get().getSpoolMaxItems();
+    RetrySpool::get().load(static_cast<size_t>(spoolMaxItems));
+    if (RetrySpool::get().enabled()) {
+        Logger::get().info() << "Retry spool: " << RetrySpool::get().total()
+                             << " pending upload(s), limit " << spoolMaxItems
+                             << " per destination" << endl;
+        Logger::get().close();
+    }
 
-        // Skip if tmpItem is an error (album not ready)
-        if (!tmpItemResult.has_value()) {
-            svcSleepThread(sleepDuration);
-            continue;
+    if (Config::get().traceEnabled()) {
+        TraceRecorder::get().open();
+        if (TraceRecorder::get().enabled()) {
+            Logger::get().info() << "Recording trace to " << TRACE_PATH << endl;
         }
+        Logger::get().close();
+    }
 
-        const std::string& tmpItem = tmpItemResult.value();
-
-        // If lastItem was an error, or tmpItem is newer, process it
-        const bool shouldProcess =
-            !lastItemResult.has_value() || lastItemResult.value() < tmpItem;
-
-        if (shouldProcess) {
-            const size_t fs = filesize(tmpItem);
-
-            if (fs > 0) {
-                auto logger = Logger::get().info();
-                logger << separator << endl
-                       << "New item found: " << tmpItem << endl
-                       << "Filesize: " << fs << endl;
-
-                bool anySuccess = false;
-
-                // Upload to enabled destinations in sequence
-                if (Config::get().telegramEnabled()) {
-                    bool sent = false;
-
-                    // Decide upload strategy based on configured mode
-                    if (telegramUploadMode == UploadMode::Compressed) {
-                        sent = retryUpload([&] {
-                            return sendFileToTelegram(tmpItem, fs, true);
-                        });
-                    } else if (telegramUploadMode == UploadMode::Original) {
-                        sent = retryUpload([&] {
-                            return sendFileToTelegram(tmpItem, fs, false);
-                        });
-                    } else if (telegramUploadMode == UploadMode::Both) {
-                        // Send compressed first, then original
-                        const bool compressedSent = retryUpload([&] {
-                            return sendFileToTelegram(tmpItem, fs, true);
-                        });
-                        const bool originalSent = retryUpload([&] {
-                            return sendFileToTelegram(tmpItem, fs, false);
-                        });
-                        sent = compressedSent || originalSent;
-                    }
-
-                    if (!sent) {
-                        Logger::get().error()
-                            << "[Telegram] Unable to send file after "
-                            << maxRetries << " retries" << endl;
-                    } else {
-                        anySuccess = true;
-                    }
-                }
-
-                // Upload to ntfy (always original, no compression)
-                if (Config::get().ntfyEnabled()) {
-                    const bool sent = retryUpload(
-                        [&] { return sendFileToNtfy(tmpItem, fs); });
-
-                    if (!sent) {
-                        Logger::get().error()
-                            << "[ntfy] Unable to send file after " << maxRetries
-                            << " retries" << endl;
-                    } else {
-                        anySuccess = true;
-                    }
-                }
-
-                // Upload to Discord (always original, no compression)
-                if (Config::get().discordEnabled()) {
-                    const bool sent = retryUpload(
-                        [&] { return sendFileToDiscord(tmpItem, fs); });
-
-                    if (!sent) {
-                        Logger::get().error()
-                            << "[Discord] Unable to send file after " << maxRetries
-                            << " retries" << endl;
-                    } else {
-                        anySuccess = true;
-                    }
-                }
-
-                if (!anySuccess) {
-                    Logger::get().error()
-                        << "All upload destinations failed, skipping..."
-                        << endl;
-                }
-
-                // Update lastItemResult regardless of success to avoid
-                // retrying the same file forever
-                lastItemResult = tmpItem;
+    if (Config::get().backfillEnabled()) {
+        Backfill::get().load(Config::get().getBackfillFrom(),
+                             Config::get().getBackfillTo());
+        {
+            auto logger = Logger::get().info();
+            logger << "[Backfill] Range " << Config::get().getBackfillFrom()
+                   << " to " << Config::get().getBackfillTo();
+            if (Backfill::get().active()) {
+                logger << ", resuming after " << Backfill::get().cursor()
+                       << endl;
+            } else {
+                logger << " already finished" << endl;
             }
+        }
+        Logger::get().close();
+    }
 
-            Logger::get().close();
+    if (Config::get().serverEnabled()) {
+        // The server needs the network from the start and keeps it up
+        const int port = Config::get().getServerPort();
+        if (startNetwork() &&
+            PullServer::get().start(static_cast<uint16_t>(port))) {
+            Logger::get().info()
+                << "[Server] Serving the album on port " << port << endl;
         }
+        Logger::get().close();
+    }
+
+    const int batchLingerMs = Config::get().getBatchLingerMs();
+    if (batchLingerMs > 0) {
+        Logger::get().info() << "Batch linger window: " << batchLingerMs
+                             << "ms" << endl;
+        Logger::get().close();
+    }
 
-        svcSleepThread(sleepDuration);
+    const int networkIdleTimeout = Config::get().getNetworkIdleTimeout();
+    if (networkIdleTimeout > 0) {
+        Logger::get().info() << "Network idle timeout: " << networkIdleTimeout
+                             << " second(s)" << endl;
+    }
+
+    UploadScheduler scheduler(
+        consoleHooks(),
+        SchedulerSettings{
+            .telegramUploadMode = telegramUploadMode,
+            .checkIntervalNs = sleepDuration,
+            .batchLingerNs = static_cast<u64>(batchLingerMs) * 1'000'000ULL,
+            .networkIdleNs =
+                static_cast<u64>(networkIdleTimeout) * 1'000'000'000ULL,
+        });
+
+    // Detection runs on its own thread from here on
+    if (!AlbumScanner::get().start(std::move(lastItemResult), sleepDuration)) {
+        Logger::get().close();
+        return 0;
+    }
+
+    Logger::get().info() << "Started in " << elapsedMs(g_startTick)
+                         << "ms, heap in use: " << heapInUse() / 1024 << " KB"
+                         << endl;
+    Logger::get().close();
+
+    while (true) {
+        scheduler.runOnce();
     }
 }
@@ -0,0 +1,203 @@
+#include "mp4.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace {
+
+constexpr size_t BOX_HEADER_SIZE = 8;
+constexpr size_t LARGE_BOX_HEADER_SIZE = 16;
+
+[[nodiscard]] constexpr uint32_t readU32(const uint8_t* p) noexcept {
+    return (static_cast<uint32_t>(p[0]) << 24) |
+           (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+[[nodiscard]] constexpr uint64_t readU64(const uint8_t* p) noexcept {
+    return (static_cast<uint64_t>(readU32(p)) << 32) | readU32(p + 4);
+}
+
+struct Box {
+    std::string_view type;
+    uint64_t offset;      // Start of the box header
+    uint64_t size;        // Including the header
+    uint64_t headerSize;  // 8 or 16
+};
+
+// Read the box header at `offset`, bounded by `end`. `header` backs the
+// returned type. Fails on truncated or malformed boxes.
+[[nodiscard]] bool readBox(FILE* f, uint64_t offset, uint64_t end,
+                           std::array<uint8_t, LARGE_BOX_HEADER_SIZE>& header,
+                           Box& box) {
+    if (offset + BOX_HEADER_SIZE > end ||
+        std::fseek(f, static_cast<long>(offset), SEEK_SET) != 0 ||
+        std::fread(header.data(), 1, BOX_HEADER_SIZE, f) != BOX_HEADER_SIZE) {
+        return false;
+    }
+
+    box.type = std::string_view(reinterpret_cast<const char*>(&header[4]), 4);
+    box.offset = offset;
+    box.size = readU32(header.data());
+    box.headerSize = BOX_HEADER_SIZE;
+
+    if (box.size == 1) {
+        // 64-bit size follows the type
+        if (std::fread(&header[BOX_HEADER_SIZE], 1, 8, f) != 8) {
+            return false;
+        }
+        box.size = readU64(&header[BOX_HEADER_SIZE]);
+        box.headerSize = LARGE_BOX_HEADER_SIZE;
+        if (box.size < LARGE_BOX_HEADER_SIZE) return false;
+    } else if (box.size == 0) {
+        // Box extends to the end of its parent
+        box.size = end - offset;
+    } else if (box.size < BOX_HEADER_SIZE) {
+        return false;
+    }
+
+    // A box running past its parent means a truncated file
+    return box.size <= end - offset;
+}
+
+// Largest box payload prefix we need: tkhd version 1 is 96 bytes
+constexpr size_t MAX_PAYLOAD_READ = 96;
+using Payload = std::array<uint8_t, MAX_PAYLOAD_READ>;
+
+// Read the start of a box payload, returns the number of bytes read
+[[nodiscard]] size_t readPayload(FILE* f, const Box& box, Payload& payload) {
+    const uint64_t available = box.size - box.headerSize;
+    const size_t wanted =
+        static_cast<size_t>(std::min<uint64_t>(available, payload.size()));
+    if (std::fseek(f, static_cast<long>(box.offset + box.headerSize),
+                   SEEK_SET) != 0) {
+        return 0;
+    }
+    return std::fread(payload.data(), 1, wanted, f);
+}
+
+// mvhd: version(1) flags(3), then times, timescale and duration whose
+// widths depend on the version
+[[nodiscard]] bool parseMvhd(FILE* f, const Box& box, Mp4Info& info) {
+    Payload p;
+    const size_t n = readPayload(f, box, p);
+    if (n < 4) return false;
+
+    uint64_t timescale = 0;
+    uint64_t duration = 0;
+    if (p[0] == 1) {
+        if (n < 32) return false;
+        timescale = readU32(&p[20]);
+        duration = readU64(&p[24]);
+    } else {
+        if (n < 20) return false;
+        timescale = readU32(&p[12]);
+        duration = readU32(&p[16]);
+    }
+    if (timescale == 0) return false;
+
+    // Round to the nearest second, Telegram takes whole seconds
+    info.durationSeconds =
+        static_cast<uint32_t>((duration + timescale / 2) / timescale);
+    return true;
+}
+
+// tkhd: width and height are the last two 16.16 fixed point fields
+[[nodiscard]] bool parseTkhd(FILE* f, const Box& box, Mp4Info& info) {
+    Payload p;
+    const size_t n = readPayload(f, box, p);
+    if (n < 4) return false;
+
+    const size_t expected = p[0] == 1 ? 96 : 84;
+    if (n < expected) return false;
+
+    const uint32_t width = readU32(&p[expected - 8]) >> 16;
+    const uint32_t height = readU32(&p[expected - 4]) >> 16;
+    // Audio tracks report zero dimensions
+    if (width == 0 || height == 0) return false;
+
+    info.width = width;
+    info.height = height;
+    return true;
+}
+
+// Walk the children of `moov` and of each `trak`, no deeper
+[[nodiscard]] bool parseMoov(FILE* f, const Box& moov, Mp4Info& info) {
+    std::array<uint8_t, LARGE_BOX_HEADER_SIZE> header;
+    const uint64_t moovEnd = moov.offset + moov.size;
+    bool hasDuration = false;
+    bool hasDimensions = false;
+
+    Box box;
+    for (uint64_t offset = moov.offset + moov.headerSize;
+         offset < moovEnd && readBox(f, offset, moovEnd, header, box);
+         offset += box.size) {
+        if (box.type == "mvhd") {
+            hasDuration = parseMvhd(f, box, info) || hasDuration;
+        } else if (box.type == "trak" && !hasDimensions) {
+            std::array<uint8_t, LARGE_BOX_HEADER_SIZE> trakHeader;
+            const uint64_t trakEnd = box.offset + box.size;
+            Box child;
+            for (uint64_t childOffset = box.offset + box.headerSize;
+                 childOffset < trakEnd &&
+                 readBox(f, childOffset, trakEnd, trakHeader, child);
+                 childOffset += child.size) {
+                if (child.type == "tkhd") {
+                    hasDimensions = parseTkhd(f, child, info);
+                    break;
+                }
+            }
+        }
+        if (hasDuration && hasDimensions) break;
+    }
+
+    return hasDuration && hasDimensions;
+}
+
+}  // namespace
+
+bool mp4IsComplete(FILE* f, size_t fileSize) {
+    std::array<uint8_t, LARGE_BOX_HEADER_SIZE> header;
+    uint64_t offset = 0;
+    bool hasMoov = false;
+
+    Box box;
+    while (offset + BOX_HEADER_SIZE <= fileSize) {
+        // A box running past the end means the file is still being written
+        if (!readBox(f, offset, fileSize, header, box)) {
+            return false;
+        }
+        if (box.type == "moov") {
+            hasMoov = true;
+        }
+        offset += box.size;
+    }
+
+    return hasMoov && offset == fileSize;
+}
+
+std::optional<Mp4Info> mp4ReadInfo(FILE* f, size_t fileSize) {
+    std::array<uint8_t, LARGE_BOX_HEADER_SIZE> header;
+    Mp4Info info;
+    bool seenMdat = false;
+
+    // Top-level boxes are visited by seeking over their payload, so a
+    // trailing `moov` costs only a handful of header reads
+    Box box;
+    for (uint64_t offset = 0;
+         offset < fileSize && readBox(f, offset, fileSize, header, box);
+         offset += box.size) {
+        if (box.type == "mdat") {
+            seenMdat = true;
+        } else if (box.type == "moov") {
+            info.fastStart = !seenMdat;
+            if (!parseMoov(f, box, info)) {
+                return std::nullopt;
+            }
+            return info;
+        }
+    }
+    return std::nullopt;
+}
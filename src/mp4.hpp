@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+
+// Walk the top-level boxes of an MP4 file. Returns true when a `moov` box
+// is present and every box lies within the file, i.e. the recording has
+// been finalized. Only box headers are read.
+[[nodiscard]] bool mp4IsComplete(FILE* f, size_t fileSize);
+
+// Presentation metadata of an MP4 file
+struct Mp4Info {
+    uint32_t durationSeconds{0};
+    uint32_t width{0};
+    uint32_t height{0};
+    // `moov` precedes the media data, so playback can start while loading
+    bool fastStart{false};
+};
+
+// Read duration and video dimensions from moov/mvhd and the first visual
+// moov/trak/tkhd. Boxes are read through a small fixed buffer, wherever the
+// `moov` box lives in the file. The file position is left undefined.
+[[nodiscard]] std::optional<Mp4Info> mp4ReadInfo(FILE* f, size_t fileSize);
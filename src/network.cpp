@@ -0,0 +1,102 @@
+#include "network.hpp"
+
+#include <curl/curl.h>
+#include <switch.h>
+
+#include "http.hpp"
+#include "logger.hpp"
+#include "utils.hpp"
+
+namespace {
+// TCP_TX_BUF_SIZE(_MAX) live in http.hpp, uploads size within them
+constexpr size_t TCP_RX_BUF_SIZE = 0x1000;
+constexpr size_t TCP_RX_BUF_SIZE_MAX = 0x2EE0;
+constexpr size_t UDP_TX_BUF_SIZE = 0;
+constexpr size_t UDP_RX_BUF_SIZE = 0;
+constexpr size_t SB_EFFICIENCY = 4;
+
+bool g_nifmInitialized = false;
+bool g_nifmFailed = false;
+bool g_networkStarted = false;
+}  // namespace
+
+bool isNetworkConnected() {
+    // nifm is only brought up once something actually needs the probe
+    if (!g_nifmInitialized && !g_nifmFailed) {
+        g_nifmInitialized = R_SUCCEEDED(nifmInitialize(NifmServiceType_User));
+        g_nifmFailed = !g_nifmInitialized;
+    }
+    if (!g_nifmInitialized) {
+        return true;  // Unknown, let the upload attempt decide
+    }
+
+    NifmInternetConnectionType type;
+    u32 wifiStrength;
+    NifmInternetConnectionStatus status;
+    const Result rc =
+        nifmGetInternetConnectionStatus(&type, &wifiStrength, &status);
+    return R_SUCCEEDED(rc) && status == NifmInternetConnectionStatus_Connected;
+}
+
+void closeNetworkProbe() {
+    if (g_nifmInitialized) {
+        nifmExit();
+        g_nifmInitialized = false;
+    }
+}
+
+bool startNetwork() {
+    if (g_networkStarted) {
+        return true;
+    }
+
+    constexpr SocketInitConfig socket_config = {
+        .tcp_tx_buf_size = TCP_TX_BUF_SIZE,
+        .tcp_rx_buf_size = TCP_RX_BUF_SIZE,
+        .tcp_tx_buf_max_size = TCP_TX_BUF_SIZE_MAX,
+        .tcp_rx_buf_max_size = TCP_RX_BUF_SIZE_MAX,
+
+        .udp_tx_buf_size = UDP_TX_BUF_SIZE,
+        .udp_rx_buf_size = UDP_RX_BUF_SIZE,
+
+        .sb_efficiency = SB_EFFICIENCY,
+
+        // Uploads and the pull server block in socket calls independently
+        .num_bsd_sessions = 3,
+        .bsd_service_type = BsdServiceType_User,
+    };
+
+    const size_t heapBefore = heapInUse();
+    const Result rc = socketInitialize(&socket_config);
+    if (R_FAILED(rc)) {
+        Logger::get().error() << "socketInitialize() failed: " << rc << endl;
+        return false;
+    }
+    if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
+        Logger::get().error() << "curl_global_init() failed" << endl;
+        socketExit();
+        return false;
+    }
+
+    g_networkStarted = true;
+    Logger::get().info() << "Network started, heap in use: "
+                         << heapBefore / 1024 << " KB -> "
+                         << heapInUse() / 1024 << " KB" << endl;
+    return true;
+}
+
+void stopNetwork() {
+    if (!g_networkStarted) {
+        return;
+    }
+
+    HttpSession::get().cleanup();
+    curl_global_cleanup();
+    socketExit();
+    closeNetworkProbe();
+    g_networkStarted = false;
+}
+
+bool networkStarted() {
+    return g_networkStarted;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+// Cheap connectivity probe through nifm, no network traffic involved.
+// Returns true when the console reports an internet connection, or when
+// the state cannot be determined.
+[[nodiscard]] bool isNetworkConnected();
+
+// Release the nifm session opened by the probe
+void closeNetworkProbe();
+
+// Bring up sockets and curl unless they are running already. They are
+// started on the first pending upload instead of at boot, so a console
+// that never takes a capture never pays for the socket buffers.
+[[nodiscard]] bool startNetwork();
+
+// Release curl, the sockets and the nifm session, they come back on the
+// next upload. Must not be called while the pull server is running.
+void stopNetwork();
+
+[[nodiscard]] bool networkStarted();
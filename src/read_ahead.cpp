@@ -0,0 +1,125 @@
+#include "read_ahead.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// Above the main thread so a free buffer is refilled right away, the
+// reader spends nearly all its time blocked on the SD card or the consumer
+constexpr int THREAD_PRIORITY = 0x2B;
+constexpr size_t THREAD_STACK_SIZE = 0x2000;  // 8KB
+
+// Static stack, keeps the reader off the small heap
+alignas(0x1000) std::array<u8, THREAD_STACK_SIZE> g_stack;
+}  // namespace
+
+bool ReadAhead::begin(FILE* f, size_t size) {
+    if (m_active) return false;
+
+    m_file = f;
+    m_left = size;
+    m_current = 0;
+    m_offset = 0;
+    m_done = false;
+    m_stop = false;
+    for (auto& buffer : m_buffers) {
+        buffer.filled = 0;
+        buffer.ready = false;
+    }
+
+    Result rc = threadCreate(&m_thread, threadMain, this, g_stack.data(),
+                             g_stack.size(), THREAD_PRIORITY, -2);
+    if (R_SUCCEEDED(rc)) {
+        rc = threadStart(&m_thread);
+        if (R_FAILED(rc)) threadClose(&m_thread);
+    }
+    if (R_FAILED(rc)) {
+        m_file = nullptr;
+        return false;
+    }
+
+    m_active = true;
+    return true;
+}
+
+size_t ReadAhead::read(void* dest, size_t maxBytes) {
+    mutexLock(&m_mutex);
+    Buffer* buffer = &m_buffers[m_current];
+    while (!buffer->ready && !m_done) {
+        condvarWait(&m_condvar, &m_mutex);
+    }
+    if (!buffer->ready) {
+        mutexUnlock(&m_mutex);
+        return 0;  // End of the range or read error
+    }
+    mutexUnlock(&m_mutex);
+
+    // The reader never touches a ready buffer, copy without the lock
+    const size_t bytes = std::min(maxBytes, buffer->filled - m_offset);
+    std::memcpy(dest, buffer->data.data() + m_offset, bytes);
+    m_offset += bytes;
+
+    if (m_offset == buffer->filled) {
+        // Hand the buffer back and move on to the other one
+        mutexLock(&m_mutex);
+        buffer->ready = false;
+        m_current ^= 1;
+        m_offset = 0;
+        condvarWakeAll(&m_condvar);
+        mutexUnlock(&m_mutex);
+    }
+    return bytes;
+}
+
+void ReadAhead::end() {
+    if (!m_active) return;
+
+    mutexLock(&m_mutex);
+    m_stop = true;
+    condvarWakeAll(&m_condvar);
+    mutexUnlock(&m_mutex);
+
+    threadWaitForExit(&m_thread);
+    threadClose(&m_thread);
+    m_file = nullptr;
+    m_active = false;
+}
+
+void ReadAhead::threadMain(void* arg) {
+    static_cast<ReadAhead*>(arg)->fill();
+}
+
+void ReadAhead::fill() {
+    size_t next = 0;
+    while (m_left > 0) {
+        Buffer& buffer = m_buffers[next];
+
+        mutexLock(&m_mutex);
+        while (buffer.ready && !m_stop) {
+            condvarWait(&m_condvar, &m_mutex);
+        }
+        const bool stop = m_stop;
+        mutexUnlock(&m_mutex);
+        if (stop) return;
+
+        // The consumer only reads ready buffers, fill without the lock
+        const size_t wanted = std::min(m_left, BUFFER_SIZE);
+        const size_t bytesRead =
+            std::fread(buffer.data.data(), 1, wanted, m_file);
+        m_left = bytesRead == wanted ? m_left - bytesRead : 0;
+
+        mutexLock(&m_mutex);
+        if (bytesRead > 0) {
+            buffer.filled = bytesRead;
+            buffer.ready = true;
+        }
+        condvarWakeAll(&m_condvar);
+        mutexUnlock(&m_mutex);
+        next ^= 1;
+    }
+
+    mutexLock(&m_mutex);
+    m_done = true;
+    condvarWakeAll(&m_condvar);
+    mutexUnlock(&m_mutex);
+}
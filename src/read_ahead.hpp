@@ -0,0 +1,62 @@
+#pragma once
+
+#include <switch.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+
+/**
+ * Double-buffered read-ahead for large uploads.
+ * A background thread fills one buffer from the SD card while curl sends
+ * the other, so SD latency and socket sends overlap instead of taking
+ * turns in the read callback. There is a single set of fixed buffers;
+ * while it is in use, further uploads read synchronously.
+ */
+class ReadAhead {
+   public:
+    static constexpr size_t BUFFER_SIZE = 0x8000;  // 32KB per buffer
+
+    static ReadAhead& get() noexcept {
+        static ReadAhead instance;
+        return instance;
+    }
+
+    // Start reading `size` bytes of `f` from its current position, false
+    // when the buffers are taken or the thread can't be started
+    [[nodiscard]] bool begin(FILE* f, size_t size);
+    // Copy up to `maxBytes` of the next data, waiting for the reader when
+    // it is behind. Returns 0 at the end of the range or on a read error.
+    [[nodiscard]] size_t read(void* dest, size_t maxBytes);
+    // Stop the reader, must be called before `f` is closed
+    void end();
+
+   private:
+    struct Buffer {
+        std::array<char, BUFFER_SIZE> data;
+        size_t filled{0};
+        bool ready{false};
+    };
+
+    ReadAhead() {
+        mutexInit(&m_mutex);
+        condvarInit(&m_condvar);
+    }
+    ReadAhead(const ReadAhead&) = delete;
+    ReadAhead& operator=(const ReadAhead&) = delete;
+
+    static void threadMain(void* arg);
+    void fill();
+
+    Mutex m_mutex;
+    CondVar m_condvar;
+    Thread m_thread{};
+    std::array<Buffer, 2> m_buffers;
+    FILE* m_file{nullptr};
+    size_t m_left{0};      // Bytes the reader still has to read
+    size_t m_current{0};   // Buffer the consumer reads from
+    size_t m_offset{0};    // Consumer position in the current buffer
+    bool m_done{false};    // Reader finished or failed
+    bool m_stop{false};
+    bool m_active{false};
+};
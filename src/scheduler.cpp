@@ -0,0 +1,565 @@
+#include "scheduler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <span>
+
+#include "album_scanner.hpp"
+#include "backfill.hpp"
+#include "clock.hpp"
+#include "config.hpp"
+#include "fingerprint.hpp"
+#include "http.hpp"
+#include "logger.hpp"
+#include "network.hpp"
+#include "server.hpp"
+#include "spool.hpp"
+#include "trace.hpp"
+#include "utils.hpp"
+
+namespace {
+constexpr std::string_view separator = "=============================";
+
+constexpr int maxRetries = 3;
+// Queue check interval while lingering for a batch
+constexpr u64 lingerPollNs = 100'000'000ULL;
+// Spooled uploads retried per idle check
+constexpr size_t spoolDrainPerCheck = 2;
+// Backfill items uploaded between two checks for new captures
+constexpr size_t backfillPerCheck = 4;
+// Unused connections are closed after this long
+constexpr u64 connectionIdleNs = 60'000'000'000ULL;
+
+// Helper to retry upload with max attempts
+template <typename F>
+bool retryUpload(F&& uploadFunc, int attempts = maxRetries) {
+    for (int retry = 0; retry < attempts; ++retry) {
+        if (uploadFunc()) return true;
+    }
+    return false;
+}
+
+// Skip captures whose content was already uploaded
+bool isDuplicate(std::string_view path, size_t size) {
+    if (!Config::get().skipDuplicates() ||
+        !FingerprintStore::get().isDuplicate(path, size)) {
+        return false;
+    }
+    Logger::get().info() << "Skipping duplicate of an uploaded capture: "
+                         << path << endl;
+    return true;
+}
+
+// Log the streamed digest and remember the fingerprint of the upload
+void recordDigest(std::string_view path, size_t size,
+                  const ContentDigest& digest) {
+    if (!digest.valid) {
+        return;
+    }
+
+    Logger::get().info() << "Digest of " << path
+                         << ": sha256=" << hex_encode(digest.sha256)
+                         << " crc32c=" << digest.crc32c << endl;
+
+    if (Config::get().skipDuplicates()) {
+        FingerprintStore::get().add(path, size, digest.crc32c);
+    }
+}
+
+[[nodiscard]] bool destinationEnabled(Destination dest) {
+    switch (dest) {
+        case Destination::Telegram:
+            return Config::get().telegramEnabled();
+        case Destination::Ntfy:
+            return Config::get().ntfyEnabled();
+        case Destination::Discord:
+            return Config::get().discordEnabled();
+        case Destination::S3:
+            return Config::get().s3Enabled();
+    }
+    return false;
+}
+
+// What is left to deliver of a capture after trying a destination
+enum class Missing : u8 {
+    Nothing,
+    Everything,
+    // Telegram "both" mode: only one of the two copies was sent
+    CompressedCopy,
+    OriginalCopy,
+};
+
+[[nodiscard]] Missing missingCopies(bool compressedSent, bool originalSent) {
+    if (compressedSent && originalSent) return Missing::Nothing;
+    if (compressedSent) return Missing::OriginalCopy;
+    if (originalSent) return Missing::CompressedCopy;
+    return Missing::Everything;
+}
+
+[[nodiscard]] Missing missingIf(bool sent) {
+    return sent ? Missing::Nothing : Missing::Everything;
+}
+
+// Add to the spool. The preview of a capture that can't be spooled, or of
+// the entry evicted for it, is deleted instead of waiting for its image.
+void spool(Destination dest, std::string_view path, std::string_view mode,
+           int64_t preview) {
+    if (!RetrySpool::get().enabled()) {
+        deleteTelegramPreview(preview);
+        return;
+    }
+    if (RetrySpool::get().full(dest)) {
+        const auto oldest = RetrySpool::get().front(dest);
+        if (oldest.has_value()) {
+            deleteTelegramPreview(oldest->previewMessageId);
+        }
+    }
+    RetrySpool::get().add(dest, path, mode, preview);
+}
+
+// Spool what is missing, a single Telegram copy as the mode to retry with
+// so the copy that arrived is not sent again. A Telegram preview waiting
+// for its image goes along, so the retry replaces it even after a restart.
+void spoolMissing(Destination dest, std::string_view path, Missing missing) {
+    const int64_t preview =
+        dest == Destination::Telegram ? takeTelegramPreview(path) : 0;
+    switch (missing) {
+        case Missing::Nothing:
+            return;
+        case Missing::Everything:
+            Logger::get().error()
+                << "[" << destinationName(dest)
+                << "] Unable to send file after " << maxRetries << " retries"
+                << endl;
+            spool(dest, path, {}, preview);
+            return;
+        case Missing::CompressedCopy:
+            spool(dest, path, UploadMode::Compressed, preview);
+            return;
+        case Missing::OriginalCopy:
+            spool(dest, path, UploadMode::Original, preview);
+            return;
+    }
+}
+
+// Upload one capture to a single destination
+Missing uploadToDestination(const SchedulerHooks& hooks, Destination dest,
+                            const std::string& path, size_t fs,
+                            std::string_view telegramUploadMode,
+                            ContentDigest* digest, int attempts = maxRetries) {
+    switch (dest) {
+        case Destination::Telegram: {
+            // Decide upload strategy based on configured mode
+            if (telegramUploadMode == UploadMode::Compressed) {
+                return missingIf(retryUpload(
+                    [&] { return hooks.telegram(path, fs, true, digest); },
+                    attempts));
+            }
+            if (telegramUploadMode == UploadMode::Original) {
+                return missingIf(retryUpload(
+                    [&] { return hooks.telegram(path, fs, false, digest); },
+                    attempts));
+            }
+            // Send both copies together, then retry the ones that failed
+            const auto sent = hooks.telegramBoth(path, fs, digest);
+            const bool compressedSent =
+                sent.compressed ||
+                retryUpload(
+                    [&] { return hooks.telegram(path, fs, true, digest); },
+                    attempts - 1);
+            const bool originalSent =
+                sent.original ||
+                retryUpload(
+                    [&] { return hooks.telegram(path, fs, false, digest); },
+                    attempts - 1);
+            return missingCopies(compressedSent, originalSent);
+        }
+        case Destination::Ntfy:
+            // Always original, no compression
+            return missingIf(retryUpload(
+                [&] { return hooks.ntfy(path, fs, digest); }, attempts));
+        case Destination::Discord:
+            // Always original, no compression
+            return missingIf(retryUpload(
+                [&] { return hooks.discord(path, fs, digest); }, attempts));
+        case Destination::S3:
+            // Multipart uploads retry their parts on their own first
+            return missingIf(retryUpload(
+                [&] { return hooks.s3(path, fs, digest); }, attempts));
+    }
+    return Missing::Everything;
+}
+
+// Upload a group of screenshots to a single destination. `missing`
+// receives what is left to deliver of each file.
+void uploadBatchToDestination(const SchedulerHooks& hooks, Destination dest,
+                              std::span<const UploadFile> batch,
+                              std::span<ContentDigest> digests,
+                              std::string_view telegramUploadMode,
+                              std::span<Missing> missing) {
+    switch (dest) {
+        case Destination::Telegram: {
+            // An album arrives or fails as a whole
+            if (telegramUploadMode == UploadMode::Compressed) {
+                const bool sent = retryUpload(
+                    [&] { return hooks.telegramBatch(batch, true, digests); });
+                std::ranges::fill(missing, missingIf(sent));
+                return;
+            }
+            if (telegramUploadMode == UploadMode::Original) {
+                const bool sent = retryUpload(
+                    [&] { return hooks.telegramBatch(batch, false, digests); });
+                std::ranges::fill(missing, missingIf(sent));
+                return;
+            }
+            const bool compressedSent = retryUpload(
+                [&] { return hooks.telegramBatch(batch, true, digests); });
+            const bool originalSent = retryUpload(
+                [&] { return hooks.telegramBatch(batch, false, digests); });
+            std::ranges::fill(missing,
+                              missingCopies(compressedSent, originalSent));
+            return;
+        }
+        case Destination::Ntfy:
+            // ntfy has no multi-attachment message, send files one by one
+            for (size_t i = 0; i < batch.size(); ++i) {
+                missing[i] = missingIf(retryUpload([&] {
+                    return hooks.ntfy(batch[i].path, batch[i].size,
+                                          &digests[i]);
+                }));
+            }
+            return;
+        case Destination::S3:
+            // Every file is its own object
+            for (size_t i = 0; i < batch.size(); ++i) {
+                missing[i] = missingIf(retryUpload([&] {
+                    return hooks.s3(batch[i].path, batch[i].size,
+                                        &digests[i]);
+                }));
+            }
+            return;
+        case Destination::Discord: {
+            const bool sent = retryUpload(
+                [&] { return hooks.discordBatch(batch, digests); });
+            std::ranges::fill(missing, missingIf(sent));
+            return;
+        }
+    }
+}
+
+}  // namespace
+
+SchedulerHooks consoleHooks() {
+    return SchedulerHooks{
+        .popCapture = [] { return AlbumScanner::get().pop(); },
+        .capturePending = [] { return AlbumScanner::get().pending(); },
+        .setFastScan = [](bool fast) { AlbumScanner::get().setFastScan(fast); },
+        .waitForCapture =
+            [](u64 timeoutNs) { AlbumScanner::get().wait(timeoutNs); },
+        .telegram = sendFileToTelegram,
+        .telegramBoth = sendFileToTelegramBoth,
+        .telegramBatch = sendFilesToTelegram,
+        .ntfy = sendFileToNtfy,
+        .discord = sendFileToDiscord,
+        .discordBatch = sendFilesToDiscord,
+        .s3 = sendFileToS3,
+        .deliver = deliverToRecipient,
+    };
+}
+
+UploadScheduler::UploadScheduler(const SchedulerHooks& hooks,
+                                 const SchedulerSettings& settings)
+    : m_hooks(hooks),
+      m_settings(settings),
+      m_lastUploadTick(Clock::get().tick()) {
+    m_batch.reserve(MAX_BATCH_SIZE);
+}
+
+// Move captures handed over by the scanner into the upload queue, as far
+// as it has room. The rest stays in the ring and holds the scanner back.
+void UploadScheduler::receiveCaptures() {
+    while (m_queue.freeSlots() > 0) {
+        auto item = m_hooks.popCapture();
+        if (!item.has_value()) break;
+        TraceRecorder::get().capture(item->detectedTick, item->size,
+                                     item->isMovie);
+        (void)m_queue.push(std::move(item.value()));
+    }
+}
+
+// Let a burst of screenshots accumulate for the linger window
+void UploadScheduler::lingerForBatch() {
+    const u64 lingerNs = m_settings.batchLingerNs;
+    m_hooks.setFastScan(true);
+    while (true) {
+        m_queue.takeScreenshots(m_batch, MAX_BATCH_SIZE - m_batch.size());
+        const u64 waitedNs =
+            armTicksToNs(Clock::get().tick() - m_batch.front().detectedTick);
+        if (m_batch.size() >= MAX_BATCH_SIZE || waitedNs >= lingerNs) {
+            break;
+        }
+        Clock::get().sleep(std::min(lingerNs - waitedNs, lingerPollNs));
+        receiveCaptures();
+    }
+    m_hooks.setFastScan(false);
+}
+
+// Upload one capture to all enabled destinations in sequence. Whatever
+// fails is spooled for a later retry.
+void UploadScheduler::uploadItem(const CaptureItem& item) {
+    const std::string& tmpItem = item.path;
+    const size_t fs = item.size;
+
+    Logger::get().info() << separator << endl
+                         << "New item found: " << tmpItem << endl
+                         << "Filesize: " << fs << endl;
+
+    if (isDuplicate(tmpItem, fs)) {
+        return;
+    }
+
+    // Destinations are spooled as failed when the network can't start
+    const bool online = startNetwork();
+    ContentDigest digest;
+    bool anySuccess = false;
+
+    for (size_t i = 0; i < DESTINATION_COUNT; ++i) {
+        const auto dest = static_cast<Destination>(i);
+        if (!destinationEnabled(dest)) continue;
+
+        const Missing missing =
+            online ? uploadToDestination(m_hooks, dest, tmpItem, fs,
+                                         m_settings.telegramUploadMode,
+                                         &digest)
+                   : Missing::Everything;
+        anySuccess = anySuccess || missing != Missing::Everything;
+        spoolMissing(dest, tmpItem, missing);
+    }
+
+    if (!anySuccess) {
+        Logger::get().error()
+            << "All upload destinations failed, skipping..." << endl;
+    }
+
+    recordDigest(tmpItem, fs, digest);
+}
+
+// Upload a burst of screenshots, grouping them per destination
+void UploadScheduler::uploadBatch() {
+    Logger::get().info() << separator << endl
+                         << "New batch of " << m_batch.size()
+                         << " items, first: " << m_batch.front().path << endl;
+
+    std::array<UploadFile, MAX_BATCH_SIZE> files;
+    std::array<ContentDigest, MAX_BATCH_SIZE> digests{};
+    size_t count = 0;
+    for (const auto& item : m_batch) {
+        if (count == MAX_BATCH_SIZE) break;
+        if (isDuplicate(item.path, item.size)) continue;
+        files[count++] = UploadFile{item.path, item.size};
+    }
+    if (count == 0) {
+        return;
+    }
+
+    const std::span<const UploadFile> batch{files.data(), count};
+    const std::span<ContentDigest> batchDigests{digests.data(), count};
+    std::array<Missing, MAX_BATCH_SIZE> missing;
+    const std::span<Missing> batchMissing{missing.data(), count};
+
+    const bool online = startNetwork();
+    bool anySuccess = false;
+
+    for (size_t i = 0; i < DESTINATION_COUNT; ++i) {
+        const auto dest = static_cast<Destination>(i);
+        if (!destinationEnabled(dest)) continue;
+
+        std::ranges::fill(batchMissing, Missing::Everything);
+        if (online) {
+            uploadBatchToDestination(m_hooks, dest, batch, batchDigests,
+                                     m_settings.telegramUploadMode,
+                                     batchMissing);
+        }
+        // Only the files that failed, the others already arrived
+        for (size_t j = 0; j < count; ++j) {
+            anySuccess = anySuccess || missing[j] != Missing::Everything;
+            spoolMissing(dest, files[j].path, missing[j]);
+        }
+    }
+
+    if (!anySuccess) {
+        Logger::get().error()
+            << "All upload destinations failed, skipping..." << endl;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        recordDigest(files[i].path, files[i].size, digests[i]);
+    }
+}
+
+// Upload the next few items of the backfill range. Returns false once
+// there is nothing left to backfill.
+bool UploadScheduler::runBackfill() {
+    if (!Backfill::get().active()) {
+        return false;
+    }
+
+    m_backfillItems.clear();
+    Backfill::get().next(backfillPerCheck, m_backfillItems);
+    for (const auto& path : m_backfillItems) {
+        const size_t fs = filesize(path);
+        if (fs > 0) {
+            Logger::get().info() << "[Backfill] Uploading " << path << endl;
+            uploadItem(CaptureItem{path, fs, isMovieFile(path),
+                                   Clock::get().tick()});
+        }
+        // Failed destinations are spooled, so move on either way
+        Backfill::get().advance(path);
+    }
+
+    Logger::get().close();
+    return !m_backfillItems.empty();
+}
+
+// Retry a bounded number of spooled uploads and deliveries, oldest first.
+// Each entry gets a single attempt so the backlog never holds up fresh
+// captures for long. Returns true when anything was retried.
+bool UploadScheduler::drainSpool() {
+    if (RetrySpool::get().total() == 0 || !isNetworkConnected() ||
+        !startNetwork()) {
+        return false;
+    }
+
+    size_t budget = spoolDrainPerCheck;
+    for (size_t i = 0; i < DESTINATION_COUNT && budget > 0; ++i) {
+        const auto dest = static_cast<Destination>(i);
+
+        // Copies and forwards first, they are small and nothing else
+        // brings their messages to those recipients
+        while (budget > 0) {
+            const auto delivery = RetrySpool::get().frontDelivery(dest);
+            if (!delivery.has_value()) break;
+            --budget;
+
+            if (destinationEnabled(dest) &&
+                !m_hooks.deliver(dest, delivery->recipient, delivery->origin,
+                                 delivery->messageIds,
+                                 delivery->attachmentUrl)) {
+                break;  // Still failing, try again on a later check
+            }
+            RetrySpool::get().popDelivery(dest);
+        }
+
+        while (budget > 0) {
+            const auto entry = RetrySpool::get().front(dest);
+            if (!entry.has_value()) break;
+            --budget;
+
+            // The capture may have been deleted or the destination disabled
+            const std::string& path = entry->path;
+            const size_t fs = filesize(path);
+            if (fs == 0 || !destinationEnabled(dest)) {
+                if (dest == Destination::Telegram) {
+                    deleteTelegramPreview(entry->previewMessageId);
+                }
+                RetrySpool::get().popFront(dest);
+                continue;
+            }
+
+            Logger::get().info() << "[" << destinationName(dest)
+                                 << "] Retrying spooled upload: " << path
+                                 << endl;
+            // A single missing Telegram copy is retried on its own
+            const std::string_view mode = entry->mode.empty()
+                                              ? m_settings.telegramUploadMode
+                                              : entry->mode;
+            if (entry->previewMessageId != 0) {
+                restoreTelegramPreview(path, entry->previewMessageId);
+            }
+            ContentDigest digest;
+            const Missing missing = uploadToDestination(
+                m_hooks, dest, path, fs, mode, &digest, 1);
+            if (missing == Missing::Everything) {
+                // Still failing, try again on a later check. Record a preview
+                // sent or lost on the way, at the back of the spool.
+                const int64_t preview = dest == Destination::Telegram
+                                            ? takeTelegramPreview(path)
+                                            : 0;
+                if (preview != entry->previewMessageId) {
+                    RetrySpool::get().popFront(dest);
+                    RetrySpool::get().add(dest, path, entry->mode, preview);
+                }
+                break;
+            }
+            RetrySpool::get().popFront(dest);
+            spoolMissing(dest, path, missing);
+            recordDigest(path, fs, digest);
+        }
+    }
+
+    Logger::get().close();
+    return budget < spoolDrainPerCheck;
+}
+
+void UploadScheduler::runOnce() {
+    receiveCaptures();
+
+    auto item = m_queue.pop();
+    if (item.has_value()) {
+        m_batch.clear();
+        m_batch.push_back(std::move(item.value()));
+
+        if (m_settings.batchLingerNs > 0 && !m_batch.front().isMovie) {
+            lingerForBatch();
+        }
+
+        if (m_batch.size() > 1) {
+            uploadBatch();
+        } else {
+            uploadItem(m_batch.front());
+        }
+
+        // Capture-to-notification latency, measured from detection
+        for (const auto& delivered : m_batch) {
+            m_latency.add(elapsedMs(delivered.detectedTick));
+        }
+        Logger::get().info()
+            << "Delivered " << m_batch.size() << " item(s) in "
+            << elapsedMs(m_batch.front().detectedTick) << "ms (median "
+            << m_latency.median() << "ms over last " << m_latency.count()
+            << "), " << m_queue.size() << " item(s) queued" << endl;
+        Logger::get().close();
+        m_lastUploadTick = Clock::get().tick();
+
+        // Take new captures right away while work is pending so a fresh
+        // screenshot can overtake queued movies
+        if (!m_queue.empty() || m_hooks.capturePending()) return;
+    }
+
+    // Only spend idle time on the backfill range and earlier failures
+    if (runBackfill()) {
+        m_lastUploadTick = Clock::get().tick();
+        return;
+    }
+    if (drainSpool()) {
+        m_lastUploadTick = Clock::get().tick();
+    }
+
+    // Keep warm connections for the next capture, but free their TLS state
+    // once servers would have dropped them anyway
+    HttpSession::get().closeIdle(connectionIdleNs);
+
+    // Hand the socket buffers back to the heap after a long idle spell
+    if (m_settings.networkIdleNs > 0 && networkStarted() &&
+        !PullServer::get().running() &&
+        armTicksToNs(Clock::get().tick() - m_lastUploadTick) >=
+            m_settings.networkIdleNs) {
+        stopNetwork();
+        Logger::get().info() << "Network stopped while idle, heap in use: "
+                             << heapInUse() / 1024 << " KB" << endl;
+        Logger::get().close();
+    }
+
+    // Sleep until the scanner hands over a capture or the next check
+    m_hooks.waitForCapture(m_settings.checkIntervalNs);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <switch.h>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "upload.hpp"
+#include "upload_queue.hpp"
+
+// What the scheduler runs against. On the console these are the album
+// scanner and the uploads of upload.hpp, a trace replay swaps in recorded
+// captures and outcomes.
+struct SchedulerHooks {
+    // Album scanner, see AlbumScanner
+    std::optional<CaptureItem> (*popCapture)();
+    bool (*capturePending)();
+    void (*setFastScan)(bool fast);
+    void (*waitForCapture)(u64 timeoutNs);
+
+    decltype(&sendFileToTelegram) telegram;
+    decltype(&sendFileToTelegramBoth) telegramBoth;
+    decltype(&sendFilesToTelegram) telegramBatch;
+    decltype(&sendFileToNtfy) ntfy;
+    decltype(&sendFileToDiscord) discord;
+    decltype(&sendFilesToDiscord) discordBatch;
+    decltype(&sendFileToS3) s3;
+    decltype(&deliverToRecipient) deliver;
+};
+
+// The album scanner and the real uploads
+[[nodiscard]] SchedulerHooks consoleHooks();
+
+struct SchedulerSettings {
+    std::string_view telegramUploadMode;
+    u64 checkIntervalNs{0};
+    // Wait for a burst of screenshots to upload them together, 0 disables
+    u64 batchLingerNs{0};
+    // Stop the network after this long without uploads, 0 keeps it up
+    u64 networkIdleNs{0};
+};
+
+/**
+ * The upload thread's loop. Takes captures from the scanner into the
+ * priority queue, lingers for bursts of screenshots, uploads them to every
+ * destination with retries and spools whatever failed. Idle checks go to
+ * the backfill range and the retry spool. All timing goes through the
+ * Clock, so a host replay runs this exact loop on virtual time.
+ */
+class UploadScheduler {
+   public:
+    UploadScheduler(const SchedulerHooks& hooks,
+                    const SchedulerSettings& settings);
+
+    // One pass: upload the next capture or batch, or do the idle work and
+    // wait for the next check
+    void runOnce();
+
+    [[nodiscard]] const UploadQueue& queue() const noexcept { return m_queue; }
+
+   private:
+    void receiveCaptures();
+    void lingerForBatch();
+    void uploadItem(const CaptureItem& item);
+    void uploadBatch();
+    [[nodiscard]] bool runBackfill();
+    [[nodiscard]] bool drainSpool();
+
+    SchedulerHooks m_hooks;
+    SchedulerSettings m_settings;
+    UploadQueue m_queue;
+    LatencyTracker m_latency;
+    std::vector<CaptureItem> m_batch;
+    std::vector<std::string> m_backfillItems;
+    // Last upload activity, the network is stopped once it gets too old
+    u64 m_lastUploadTick;
+};
@@ -0,0 +1,470 @@
+#include "server.hpp"
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "logger.hpp"
+#include "utils.hpp"
+
+namespace {
+constexpr std::string_view LOG_PREFIX = "[Server] ";
+constexpr size_t THREAD_STACK_SIZE = 0x4000;  // 16KB
+// Just below the main thread, uploads come first
+constexpr int THREAD_PRIORITY = 0x2D;
+// How often the accept loop checks for stop()
+constexpr int ACCEPT_POLL_MS = 500;
+// Drop clients that stall for this long
+constexpr long SOCKET_TIMEOUT_S = 10;
+// Items per index page, clients page on with the last returned path
+constexpr size_t INDEX_PAGE_SIZE = 64;
+
+constexpr std::string_view INDEX_ROUTE = "/index.json";
+constexpr std::string_view ALBUM_ROUTE = "/album/";
+
+// Fixed buffers, only ever used by the server thread
+std::array<char, 0x800> g_request;      // 2KB, request line and headers
+std::array<char, 0x4000> g_sendBuffer;  // 16KB, file streaming
+
+// Static stack, keeps the server off the small heap
+alignas(0x1000) std::array<u8, THREAD_STACK_SIZE> g_stack;
+
+struct Request {
+    std::string_view method;
+    std::string_view path;
+    std::string_view query;
+    std::string_view range;
+    std::string_view ifNoneMatch;
+};
+
+[[nodiscard]] bool equalsNoCase(std::string_view a,
+                                std::string_view b) noexcept {
+    return std::ranges::equal(a, b, [](char x, char y) {
+        return std::tolower(static_cast<unsigned char>(x)) ==
+               std::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+[[nodiscard]] std::string_view trim(std::string_view value) noexcept {
+    while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+    while (!value.empty() && value.back() == ' ') value.remove_suffix(1);
+    return value;
+}
+
+// Split "METHOD /path?query HTTP/1.x" and pick the headers we handle
+[[nodiscard]] bool parseRequest(std::string_view head, Request& request) {
+    size_t lineEnd = head.find("\r\n");
+    const std::string_view line = head.substr(0, lineEnd);
+
+    const size_t methodEnd = line.find(' ');
+    const size_t targetEnd = line.find(' ', methodEnd + 1);
+    if (methodEnd == std::string_view::npos ||
+        targetEnd == std::string_view::npos) {
+        return false;
+    }
+    request.method = line.substr(0, methodEnd);
+    std::string_view target =
+        line.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+    const size_t queryStart = target.find('?');
+    if (queryStart != std::string_view::npos) {
+        request.query = target.substr(queryStart + 1);
+        target = target.substr(0, queryStart);
+    }
+    request.path = target;
+
+    while (lineEnd != std::string_view::npos) {
+        const size_t start = lineEnd + 2;
+        lineEnd = head.find("\r\n", start);
+        const std::string_view header = head.substr(start, lineEnd - start);
+        const size_t colon = header.find(':');
+        if (colon == std::string_view::npos) continue;
+
+        const std::string_view name = header.substr(0, colon);
+        const std::string_view value = trim(header.substr(colon + 1));
+        if (equalsNoCase(name, "range")) {
+            request.range = value;
+        } else if (equalsNoCase(name, "if-none-match")) {
+            request.ifNoneMatch = value;
+        }
+    }
+    return true;
+}
+
+// Value of `key` in a query string, percent-decoded
+[[nodiscard]] std::string queryValue(std::string_view query,
+                                     std::string_view key) {
+    std::string result;
+    while (!query.empty()) {
+        const size_t end = std::min(query.find('&'), query.size());
+        const std::string_view pair = query.substr(0, end);
+        query.remove_prefix(std::min(end + 1, query.size()));
+
+        if (!pair.starts_with(key) || pair.size() <= key.size() ||
+            pair[key.size()] != '=') {
+            continue;
+        }
+
+        const std::string_view value = pair.substr(key.size() + 1);
+        for (size_t i = 0; i < value.size(); ++i) {
+            unsigned char c = 0;
+            if (value[i] == '%' && i + 2 < value.size() &&
+                std::from_chars(value.data() + i + 1, value.data() + i + 3, c,
+                                16)
+                        .ptr == value.data() + i + 3) {
+                result.push_back(static_cast<char>(c));
+                i += 2;
+            } else {
+                result.push_back(value[i] == '+' ? ' ' : value[i]);
+            }
+        }
+        break;
+    }
+    return result;
+}
+
+// Only "YYYY/MM/DD/<file>" paths with plain filenames can be served, which
+// also keeps requests from leaving the album
+[[nodiscard]] bool isAlbumFile(std::string_view relative) noexcept {
+    constexpr size_t fileOffset = 11;
+    if (relative.size() <= fileOffset || relative[4] != '/' ||
+        relative[7] != '/' || relative[10] != '/') {
+        return false;
+    }
+    for (size_t i = 0; i < fileOffset; ++i) {
+        if (i != 4 && i != 7 && i != 10 &&
+            (relative[i] < '0' || relative[i] > '9')) {
+            return false;
+        }
+    }
+
+    const std::string_view file = relative.substr(fileOffset);
+    return file.front() != '.' && std::ranges::all_of(file, [](char c) {
+               return std::isalnum(static_cast<unsigned char>(c)) ||
+                      c == '_' || c == '-' || c == '.';
+           });
+}
+
+bool sendAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        const ssize_t sent = send(fd, data, size, 0);
+        if (sent <= 0) return false;
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool sendAll(int fd, std::string_view data) {
+    return sendAll(fd, data.data(), data.size());
+}
+
+// Status line and headers. `extra` holds further header lines, each ending
+// with "\r\n".
+bool sendHead(int fd, std::string_view status, std::string_view contentType,
+              size_t contentLength, std::string_view extra = {}) {
+    std::string head = "HTTP/1.1 ";
+    head += status;
+    head += "\r\nConnection: close\r\nContent-Length: ";
+    head += std::to_string(contentLength);
+    head += "\r\n";
+    if (!contentType.empty()) {
+        head += "Content-Type: ";
+        head += contentType;
+        head += "\r\n";
+    }
+    head += extra;
+    head += "\r\n";
+    return sendAll(fd, head);
+}
+
+void sendError(int fd, std::string_view status, std::string_view extra = {}) {
+    sendHead(fd, status, "text/plain", status.size(), extra);
+    sendAll(fd, status);
+}
+
+// GET /index.json?after=YYYY/MM/DD/<file>
+// Without `after` the index starts at the oldest capture.
+void serveIndex(int fd, const Request& request, bool withBody) {
+    const std::string after = queryValue(request.query, "after");
+    if (!after.empty() && !isAlbumFile(after)) {
+        sendError(fd, "400 Bad Request");
+        return;
+    }
+
+    std::vector<std::string> items;
+    items.reserve(INDEX_PAGE_SIZE);
+    collectNewAlbumItems(after.empty() ? std::string{}
+                                       : std::string(ALBUM_PATH) + after,
+                         INDEX_PAGE_SIZE, items);
+
+    // Album paths only hold digits, '/' and plain filenames, nothing in
+    // them needs JSON escaping
+    std::string json = "{\"items\":[";
+    for (const auto& item : items) {
+        const std::string_view relative =
+            std::string_view(item).substr(ALBUM_PATH.size());
+        if (&item != &items.front()) json += ',';
+        json += "{\"path\":\"";
+        json += relative;
+        json += "\",\"url\":\"";
+        json += ALBUM_ROUTE;
+        json += relative;
+        json += "\",\"size\":";
+        json += std::to_string(filesize(item));
+        json += ",\"movie\":";
+        json += item.ends_with(".mp4") ? "true" : "false";
+        json += '}';
+    }
+    json += "],\"more\":";
+    json += items.size() == INDEX_PAGE_SIZE ? "true" : "false";
+    json += '}';
+
+    if (sendHead(fd, "200 OK", "application/json", json.size(),
+                 "Cache-Control: no-store\r\n") &&
+        withBody) {
+        sendAll(fd, json);
+    }
+}
+
+enum class RangeResult { Full, Partial, Unsatisfiable };
+
+// Single "bytes=first-last", "bytes=first-" or "bytes=-suffix" range.
+// Anything else is ignored and the whole file is sent, as HTTP allows.
+[[nodiscard]] RangeResult parseRange(std::string_view value, size_t size,
+                                     size_t& first, size_t& last) {
+    constexpr std::string_view unit = "bytes=";
+    if (!value.starts_with(unit) ||
+        value.find(',') != std::string_view::npos) {
+        return RangeResult::Full;
+    }
+    value.remove_prefix(unit.size());
+
+    const size_t dash = value.find('-');
+    if (dash == std::string_view::npos) return RangeResult::Full;
+    const std::string_view firstText = value.substr(0, dash);
+    const std::string_view lastText = value.substr(dash + 1);
+
+    const auto parse = [](std::string_view text, size_t& out) {
+        const auto [ptr, ec] =
+            std::from_chars(text.data(), text.data() + text.size(), out);
+        return ec == std::errc{} && ptr == text.data() + text.size();
+    };
+
+    if (firstText.empty()) {
+        size_t suffix = 0;
+        if (!parse(lastText, suffix)) return RangeResult::Full;
+        if (suffix == 0 || size == 0) return RangeResult::Unsatisfiable;
+        first = size - std::min(suffix, size);
+        last = size - 1;
+        return RangeResult::Partial;
+    }
+
+    if (!parse(firstText, first)) return RangeResult::Full;
+    last = size - 1;
+    if (!lastText.empty()) {
+        if (!parse(lastText, last) || last < first) return RangeResult::Full;
+        last = std::min(last, size - 1);
+    }
+    return first < size ? RangeResult::Partial : RangeResult::Unsatisfiable;
+}
+
+// GET /album/YYYY/MM/DD/<file>
+void serveCapture(int fd, const Request& request, bool withBody) {
+    const std::string_view relative =
+        request.path.substr(ALBUM_ROUTE.size());
+    if (!isAlbumFile(relative)) {
+        sendError(fd, "404 Not Found");
+        return;
+    }
+
+    const std::string path = std::string(ALBUM_PATH) + std::string(relative);
+    const size_t size = filesize(path);
+    if (size == 0) {
+        sendError(fd, "404 Not Found");
+        return;
+    }
+
+    // Album filenames are unique and the files are never modified
+    std::string etag = "\"";
+    etag += relative.substr(relative.rfind('/') + 1);
+    etag += '"';
+
+    std::string headers = "Accept-Ranges: bytes\r\nETag: " + etag + "\r\n";
+    if (request.ifNoneMatch == etag || request.ifNoneMatch == "*") {
+        sendHead(fd, "304 Not Modified", {}, 0, headers);
+        return;
+    }
+
+    size_t first = 0;
+    size_t last = size - 1;
+    const RangeResult range = parseRange(request.range, size, first, last);
+    if (range == RangeResult::Unsatisfiable) {
+        sendError(fd, "416 Range Not Satisfiable",
+                  "Content-Range: bytes */" + std::to_string(size) + "\r\n");
+        return;
+    }
+    if (range == RangeResult::Partial) {
+        headers += "Content-Range: bytes " + std::to_string(first) + "-" +
+                   std::to_string(last) + "/" + std::to_string(size) +
+                   "\r\n";
+    }
+
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr ||
+        std::fseek(f, static_cast<long>(first), SEEK_SET) != 0) {
+        if (f != nullptr) std::fclose(f);
+        sendError(fd, "500 Internal Server Error");
+        return;
+    }
+
+    const std::string_view contentType =
+        path.ends_with(".mp4") ? "video/mp4" : "image/jpeg";
+    size_t remaining = last - first + 1;
+    bool ok = sendHead(fd,
+                       range == RangeResult::Partial ? "206 Partial Content"
+                                                     : "200 OK",
+                       contentType, remaining, headers);
+
+    while (ok && withBody && remaining > 0) {
+        const size_t chunk = std::min(remaining, g_sendBuffer.size());
+        const size_t read = std::fread(g_sendBuffer.data(), 1, chunk, f);
+        ok = read == chunk && sendAll(fd, g_sendBuffer.data(), read);
+        remaining -= read;
+    }
+    std::fclose(f);
+
+    if (!ok) {
+        Logger::get().warn() << LOG_PREFIX << "Transfer of " << relative
+                             << " aborted" << endl;
+    }
+}
+
+void handleConnection(int fd) {
+    const timeval timeout{SOCKET_TIMEOUT_S, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // Read until the end of the headers, request bodies are never accepted
+    size_t received = 0;
+    std::string_view head;
+    while (received < g_request.size()) {
+        const ssize_t n = recv(fd, g_request.data() + received,
+                               g_request.size() - received, 0);
+        if (n <= 0) return;
+        received += static_cast<size_t>(n);
+
+        const std::string_view data(g_request.data(), received);
+        const size_t end = data.find("\r\n\r\n");
+        if (end != std::string_view::npos) {
+            head = data.substr(0, end);
+            break;
+        }
+    }
+
+    Request request;
+    if (head.empty() || !parseRequest(head, request)) {
+        sendError(fd, "400 Bad Request");
+        return;
+    }
+
+    Logger::get().debug() << LOG_PREFIX << request.method << " "
+                          << request.path << endl;
+
+    const bool isHead = request.method == "HEAD";
+    if (request.method != "GET" && !isHead) {
+        sendError(fd, "405 Method Not Allowed", "Allow: GET, HEAD\r\n");
+    } else if (request.path == INDEX_ROUTE) {
+        serveIndex(fd, request, !isHead);
+    } else if (request.path.starts_with(ALBUM_ROUTE)) {
+        serveCapture(fd, request, !isHead);
+    } else {
+        sendError(fd, "404 Not Found");
+    }
+}
+}  // namespace
+
+bool PullServer::start(uint16_t port) {
+    if (m_running) return true;
+
+    m_listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (m_listenFd < 0) {
+        Logger::get().error() << LOG_PREFIX << "socket() failed" << endl;
+        return false;
+    }
+
+    const int reuse = 1;
+    setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(m_listenFd, reinterpret_cast<const sockaddr*>(&addr),
+             sizeof(addr)) != 0 ||
+        listen(m_listenFd, 2) != 0) {
+        Logger::get().error()
+            << LOG_PREFIX << "Unable to listen on port " << port << endl;
+        close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+
+    m_stop = false;
+    Result rc = threadCreate(&m_thread, threadMain, this, g_stack.data(),
+                             g_stack.size(), THREAD_PRIORITY, -2);
+    if (R_SUCCEEDED(rc)) {
+        rc = threadStart(&m_thread);
+        if (R_FAILED(rc)) threadClose(&m_thread);
+    }
+    if (R_FAILED(rc)) {
+        Logger::get().error()
+            << LOG_PREFIX << "Unable to start thread: " << rc << endl;
+        close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+
+    m_running = true;
+    return true;
+}
+
+void PullServer::stop() {
+    if (!m_running) return;
+
+    m_stop = true;
+    threadWaitForExit(&m_thread);
+    threadClose(&m_thread);
+    close(m_listenFd);
+    m_listenFd = -1;
+    m_running = false;
+}
+
+void PullServer::threadMain(void* arg) {
+    static_cast<PullServer*>(arg)->serve();
+}
+
+void PullServer::serve() {
+    pollfd listener{m_listenFd, POLLIN, 0};
+
+    while (!m_stop) {
+        // Wake up regularly so stop() never waits for a client
+        if (poll(&listener, 1, ACCEPT_POLL_MS) <= 0) continue;
+
+        const int fd = accept(m_listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+
+        handleConnection(fd);
+        close(fd);
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <switch.h>
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Optional HTTP server that lets clients on the LAN pull captures directly
+ * instead of receiving them through a third-party API:
+ *   GET /index.json?after=YYYY/MM/DD/<file>  next album items, oldest first
+ *   GET /album/YYYY/MM/DD/<file>             the capture itself
+ * Captures support single Range requests and use their filename as ETag,
+ * album files never change once written. The server runs on its own thread,
+ * handles one connection at a time and streams files through a fixed
+ * buffer, so its memory use does not depend on the file size.
+ */
+class PullServer {
+   public:
+    static PullServer& get() noexcept {
+        static PullServer instance;
+        return instance;
+    }
+
+    // Listen on `port` and start the server thread
+    [[nodiscard]] bool start(uint16_t port);
+    // Stop serving and wait for the thread, must run before socketExit()
+    void stop();
+
+    [[nodiscard]] bool running() const noexcept { return m_running; }
+
+   private:
+    PullServer() = default;
+    PullServer(const PullServer&) = delete;
+    PullServer& operator=(const PullServer&) = delete;
+
+    static void threadMain(void* arg);
+    void serve();
+
+    Thread m_thread{};
+    int m_listenFd{-1};
+    std::atomic<bool> m_stop{false};
+    bool m_running{false};
+};
@@ -0,0 +1,125 @@
+#include "sigv4.hpp"
+
+#include <switch.h>
+
+#include <array>
+#include <ctime>
+
+#include "utils.hpp"
+
+namespace {
+constexpr std::string_view ALGORITHM = "AWS4-HMAC-SHA256";
+constexpr std::string_view SERVICE = "s3";
+constexpr std::string_view SIGNED_HEADERS =
+    "host;x-amz-content-sha256;x-amz-date";
+
+using Digest = std::array<uint8_t, SHA256_HASH_SIZE>;
+
+bool g_timeInitialized = false;
+
+[[nodiscard]] Digest hmac(std::span<const uint8_t> key,
+                          std::string_view message) {
+    Digest mac;
+    hmacSha256CalculateMac(mac.data(), key.data(), key.size(),
+                           message.data(), message.size());
+    return mac;
+}
+
+[[nodiscard]] std::string sha256Hex(std::string_view data) {
+    Digest hash;
+    sha256CalculateHash(hash.data(), data.data(), data.size());
+    return hex_encode(hash);
+}
+}  // namespace
+
+bool sigv4Timestamp(std::string& amzDate) {
+    if (!g_timeInitialized) {
+        g_timeInitialized = R_SUCCEEDED(timeInitialize());
+        if (!g_timeInitialized) return false;
+    }
+
+    u64 now = 0;
+    if (R_FAILED(timeGetCurrentTime(TimeType_Default, &now))) {
+        return false;
+    }
+
+    const std::time_t seconds = static_cast<std::time_t>(now);
+    std::tm utc{};
+    if (gmtime_r(&seconds, &utc) == nullptr) {
+        return false;
+    }
+
+    std::array<char, 17> text{};
+    std::strftime(text.data(), text.size(), "%Y%m%dT%H%M%SZ", &utc);
+    amzDate = text.data();
+    return true;
+}
+
+void closeSigV4Clock() {
+    if (g_timeInitialized) {
+        timeExit();
+        g_timeInitialized = false;
+    }
+}
+
+std::string sigv4Authorization(std::string_view method, std::string_view host,
+                               std::string_view canonicalUri,
+                               std::string_view canonicalQuery,
+                               std::string_view amzDate,
+                               const SigV4Credentials& creds) {
+    const std::string_view date = amzDate.substr(0, 8);
+
+    std::string scope{date};
+    scope += '/';
+    scope += creds.region;
+    scope += '/';
+    scope += SERVICE;
+    scope += "/aws4_request";
+
+    std::string canonical{method};
+    canonical += '\n';
+    canonical += canonicalUri;
+    canonical += '\n';
+    canonical += canonicalQuery;
+    canonical += "\nhost:";
+    canonical += host;
+    canonical += "\nx-amz-content-sha256:";
+    canonical += SIGV4_UNSIGNED_PAYLOAD;
+    canonical += "\nx-amz-date:";
+    canonical += amzDate;
+    canonical += "\n\n";
+    canonical += SIGNED_HEADERS;
+    canonical += '\n';
+    canonical += SIGV4_UNSIGNED_PAYLOAD;
+
+    std::string stringToSign{ALGORITHM};
+    stringToSign += '\n';
+    stringToSign += amzDate;
+    stringToSign += '\n';
+    stringToSign += scope;
+    stringToSign += '\n';
+    stringToSign += sha256Hex(canonical);
+
+    // kSigning = HMAC(HMAC(HMAC(HMAC("AWS4" + secret, date), region),
+    //                      service), "aws4_request")
+    std::string secret = "AWS4";
+    secret += creds.secretKey;
+    const std::span<const uint8_t> secretBytes{
+        reinterpret_cast<const uint8_t*>(secret.data()), secret.size()};
+    Digest key = hmac(secretBytes, date);
+    key = hmac(key, creds.region);
+    key = hmac(key, SERVICE);
+    key = hmac(key, "aws4_request");
+    const Digest signature = hmac(key, stringToSign);
+
+    std::string authorization{ALGORITHM};
+    authorization += " Credential=";
+    authorization += creds.accessKey;
+    authorization += '/';
+    authorization += scope;
+    authorization += ", SignedHeaders=";
+    authorization += SIGNED_HEADERS;
+    authorization += ", Signature=";
+    authorization += hex_encode(signature);
+    return authorization;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Payload hash used for streamed bodies, the body itself is not signed
+inline constexpr std::string_view SIGV4_UNSIGNED_PAYLOAD = "UNSIGNED-PAYLOAD";
+
+// Key and scope used to sign S3 requests
+struct SigV4Credentials {
+    std::string_view accessKey;
+    std::string_view secretKey;
+    std::string_view region;
+};
+
+// Current UTC time as an ISO 8601 basic timestamp (20240525T130501Z).
+// The time service is only started on first use. Returns false when the
+// clock is unavailable.
+[[nodiscard]] bool sigv4Timestamp(std::string& amzDate);
+
+// Release the time service opened by sigv4Timestamp()
+void closeSigV4Clock();
+
+// Value of the Authorization header of an AWS Signature Version 4 request
+// for the S3 service. The request must send the host, x-amz-content-sha256
+// (UNSIGNED-PAYLOAD) and x-amz-date headers; `canonicalUri` and
+// `canonicalQuery` must already be URI-encoded and the query sorted.
+[[nodiscard]] std::string sigv4Authorization(std::string_view method,
+                                             std::string_view host,
+                                             std::string_view canonicalUri,
+                                             std::string_view canonicalQuery,
+                                             std::string_view amzDate,
+                                             const SigV4Credentials& creds);
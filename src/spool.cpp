@@ -0,0 +1,268 @@
+#include "spool.hpp"
+
+#include <charconv>
+#include <cstdio>
+#include <numeric>
+#include <string>
+
+#include "logger.hpp"
+
+namespace {
+// Longest entry we expect, a delivery with a Discord attachment link,
+// plus room for the newline
+constexpr size_t MAX_LINE_LENGTH = 512;
+// Separates the path, the Telegram upload mode and the preview of an entry
+constexpr char MODE_SEPARATOR = '\t';
+
+[[nodiscard]] std::string spoolPath(Destination dest,
+                                    std::string_view suffix = {}) {
+    std::string path{SPOOL_DIR};
+    path += "/";
+    path += destinationName(dest);
+    path += suffix;
+    path += ".txt";
+    return path;
+}
+
+[[nodiscard]] std::string deliveryPath(Destination dest) {
+    return spoolPath(dest, "-deliveries");
+}
+
+// Read one line without the trailing newline, false at end of file
+[[nodiscard]] bool readLine(FILE* f, std::string& line) {
+    std::array<char, MAX_LINE_LENGTH> buffer;
+    if (std::fgets(buffer.data(), buffer.size(), f) == nullptr) {
+        return false;
+    }
+    line = buffer.data();
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+        line.pop_back();
+    }
+    return true;
+}
+
+// Non-empty lines of a spool, 0 when there is none
+[[nodiscard]] size_t countLines(const std::string& file) {
+    FILE* f = std::fopen(file.c_str(), "r");
+    if (f == nullptr) return 0;
+
+    size_t count = 0;
+    std::string line;
+    while (readLine(f, line)) {
+        if (!line.empty()) ++count;
+    }
+    std::fclose(f);
+    return count;
+}
+
+// Rewrite a spool without its first `drop` entries and update `count` to
+// the entries kept. It stays as it is when the copy can't be written.
+void dropLines(const std::string& file, size_t drop, size_t& count) {
+    const std::string tmpFile = file + ".tmp";
+
+    FILE* in = std::fopen(file.c_str(), "r");
+    if (in == nullptr) {
+        count = 0;
+        return;
+    }
+    FILE* out = std::fopen(tmpFile.c_str(), "w");
+    if (out == nullptr) {
+        std::fclose(in);
+        return;
+    }
+
+    size_t kept = 0;
+    size_t skipped = 0;
+    std::string line;
+    while (readLine(in, line)) {
+        if (line.empty()) continue;
+        if (skipped < drop) {
+            ++skipped;
+            continue;
+        }
+        std::fputs(line.c_str(), out);
+        std::fputc('\n', out);
+        ++kept;
+    }
+    std::fclose(in);
+    std::fclose(out);
+
+    std::remove(file.c_str());
+    std::rename(tmpFile.c_str(), file.c_str());
+    count = kept;
+}
+}  // namespace
+
+void RetrySpool::load(size_t maxItems) {
+    m_maxItems = maxItems;
+
+    for (size_t i = 0; i < DESTINATION_COUNT; ++i) {
+        const auto dest = static_cast<Destination>(i);
+        m_counts[i] = countLines(spoolPath(dest));
+        m_deliveryCounts[i] = countLines(deliveryPath(dest));
+
+        // The limit may have been lowered since the spool was written
+        if (m_counts[i] > m_maxItems) {
+            dropOldest(dest, m_counts[i] - m_maxItems);
+        }
+        if (m_deliveryCounts[i] > m_maxItems) {
+            dropOldestDeliveries(dest, m_deliveryCounts[i] - m_maxItems);
+        }
+    }
+}
+
+size_t RetrySpool::total() const noexcept {
+    return std::accumulate(m_counts.begin(), m_counts.end(), size_t{0}) +
+           std::accumulate(m_deliveryCounts.begin(), m_deliveryCounts.end(),
+                           size_t{0});
+}
+
+void RetrySpool::add(Destination dest, std::string_view path,
+                     std::string_view mode, int64_t previewMessageId) {
+    if (!enabled() || path.empty()) return;
+
+    const std::string file = spoolPath(dest);
+    FILE* f = std::fopen(file.c_str(), "a");
+    if (f == nullptr) {
+        Logger::get().error() << "Unable to open spool " << file << endl;
+        return;
+    }
+    std::fwrite(path.data(), 1, path.size(), f);
+    if (!mode.empty() || previewMessageId != 0) {
+        std::fputc(MODE_SEPARATOR, f);
+        std::fwrite(mode.data(), 1, mode.size(), f);
+    }
+    if (previewMessageId != 0) {
+        std::fprintf(f, "%c%lld", MODE_SEPARATOR,
+                     static_cast<long long>(previewMessageId));
+    }
+    std::fputc('\n', f);
+    std::fclose(f);
+
+    auto& count = m_counts[static_cast<size_t>(dest)];
+    ++count;
+    Logger::get().info() << "[" << destinationName(dest)
+                         << "] Spooled for retry (" << count
+                         << " pending): " << path << (mode.empty() ? "" : " ")
+                         << mode << endl;
+
+    if (count > m_maxItems) {
+        Logger::get().warn() << "[" << destinationName(dest)
+                             << "] Spool full, evicting oldest entry" << endl;
+        dropOldest(dest, count - m_maxItems);
+    }
+}
+
+std::optional<SpoolEntry> RetrySpool::front(Destination dest) const {
+    if (size(dest) == 0) return std::nullopt;
+
+    FILE* f = std::fopen(spoolPath(dest).c_str(), "r");
+    if (f == nullptr) return std::nullopt;
+
+    std::string line;
+    std::optional<SpoolEntry> result;
+    while (readLine(f, line)) {
+        if (line.empty()) continue;
+
+        const size_t separator = line.find(MODE_SEPARATOR);
+        if (separator == std::string::npos) {
+            result = SpoolEntry{std::move(line), {}};
+            break;
+        }
+        result = SpoolEntry{line.substr(0, separator), {}};
+        std::string_view rest = std::string_view(line).substr(separator + 1);
+        const size_t previewSeparator = rest.find(MODE_SEPARATOR);
+        result->mode = rest.substr(0, previewSeparator);
+        if (previewSeparator != std::string_view::npos) {
+            rest.remove_prefix(previewSeparator + 1);
+            std::from_chars(rest.data(), rest.data() + rest.size(),
+                            result->previewMessageId);
+        }
+        break;
+    }
+    std::fclose(f);
+    return result;
+}
+
+void RetrySpool::popFront(Destination dest) { dropOldest(dest, 1); }
+
+void RetrySpool::addDelivery(Destination dest, std::string_view recipient,
+                             std::string_view origin,
+                             std::string_view messageIds,
+                             std::string_view attachmentUrl) {
+    if (!enabled() || recipient.empty() || messageIds.empty()) return;
+
+    const std::string file = deliveryPath(dest);
+    FILE* f = std::fopen(file.c_str(), "a");
+    if (f == nullptr) {
+        Logger::get().error() << "Unable to open spool " << file << endl;
+        return;
+    }
+    std::fwrite(recipient.data(), 1, recipient.size(), f);
+    std::fputc(MODE_SEPARATOR, f);
+    std::fwrite(origin.data(), 1, origin.size(), f);
+    std::fputc(MODE_SEPARATOR, f);
+    std::fwrite(messageIds.data(), 1, messageIds.size(), f);
+    if (!attachmentUrl.empty()) {
+        std::fputc(MODE_SEPARATOR, f);
+        std::fwrite(attachmentUrl.data(), 1, attachmentUrl.size(), f);
+    }
+    std::fputc('\n', f);
+    std::fclose(f);
+
+    auto& count = m_deliveryCounts[static_cast<size_t>(dest)];
+    ++count;
+    Logger::get().info() << "[" << destinationName(dest)
+                         << "] Spooled delivery to " << recipient
+                         << " for retry (" << count << " pending): "
+                         << messageIds << endl;
+
+    if (count > m_maxItems) {
+        Logger::get().warn() << "[" << destinationName(dest)
+                             << "] Delivery spool full, evicting oldest entry"
+                             << endl;
+        dropOldestDeliveries(dest, count - m_maxItems);
+    }
+}
+
+std::optional<DeliveryEntry> RetrySpool::frontDelivery(
+    Destination dest) const {
+    if (deliveries(dest) == 0) return std::nullopt;
+
+    FILE* f = std::fopen(deliveryPath(dest).c_str(), "r");
+    if (f == nullptr) return std::nullopt;
+
+    std::string line;
+    std::optional<DeliveryEntry> result;
+    while (readLine(f, line)) {
+        const size_t first = line.find(MODE_SEPARATOR);
+        const size_t second = line.find(MODE_SEPARATOR, first + 1);
+        if (first == std::string::npos || second == std::string::npos) {
+            continue;
+        }
+        const size_t third = line.find(MODE_SEPARATOR, second + 1);
+        result = DeliveryEntry{line.substr(0, first),
+                               line.substr(first + 1, second - first - 1),
+                               line.substr(second + 1, third - second - 1),
+                               {}};
+        if (third != std::string::npos) {
+            result->attachmentUrl = line.substr(third + 1);
+        }
+        break;
+    }
+    std::fclose(f);
+    return result;
+}
+
+void RetrySpool::popDelivery(Destination dest) {
+    dropOldestDeliveries(dest, 1);
+}
+
+void RetrySpool::dropOldest(Destination dest, size_t drop) {
+    dropLines(spoolPath(dest), drop, m_counts[static_cast<size_t>(dest)]);
+}
+
+void RetrySpool::dropOldestDeliveries(Destination dest, size_t drop) {
+    dropLines(deliveryPath(dest), drop,
+              m_deliveryCounts[static_cast<size_t>(dest)]);
+}
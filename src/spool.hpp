@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "project.h"
+#include "upload.hpp"
+
+inline constexpr std::string_view SPOOL_DIR =
+    "sdmc:/config/" APP_TITLE "/spool";
+
+struct SpoolEntry {
+    std::string path;
+    // Telegram upload mode to retry with, empty for the configured one
+    std::string mode;
+    // Telegram preview the retry replaces, 0 for none
+    int64_t previewMessageId{0};
+};
+
+// A message in the first Telegram chat or Discord channel that didn't
+// reach one of the others
+struct DeliveryEntry {
+    std::string recipient;
+    // Chat or channel the message is in
+    std::string origin;
+    // Comma separated, a Telegram media group has several
+    std::string messageIds;
+    // Discord link posted when the forward is refused, empty for none
+    std::string attachmentUrl;
+};
+
+/**
+ * Durable per-destination retry spool.
+ * Captures that could not be delivered to a destination are recorded as one
+ * album path per line in spool/<destination>.txt, optionally followed by a
+ * tab and the Telegram upload mode to retry with when only one of the two
+ * copies is missing, and by another tab and the message id of the preview
+ * already in the chat. Copies and forwards to further chats and channels
+ * that failed after the upload are kept apart in
+ * spool/<destination>-deliveries.txt as recipient, origin, message ids and
+ * an optional Discord attachment link separated by tabs. Each spool is
+ * bounded; when full, the oldest entry is evicted.
+ */
+class RetrySpool {
+   public:
+    static RetrySpool& get() noexcept {
+        static RetrySpool instance;
+        return instance;
+    }
+
+    // Count the pending entries of every destination
+    void load(size_t maxItems);
+
+    void add(Destination dest, std::string_view path,
+             std::string_view mode = {}, int64_t previewMessageId = 0);
+    [[nodiscard]] std::optional<SpoolEntry> front(Destination dest) const;
+    void popFront(Destination dest);
+
+    void addDelivery(Destination dest, std::string_view recipient,
+                     std::string_view origin, std::string_view messageIds,
+                     std::string_view attachmentUrl = {});
+    [[nodiscard]] std::optional<DeliveryEntry> frontDelivery(
+        Destination dest) const;
+    void popDelivery(Destination dest);
+
+    [[nodiscard]] size_t size(Destination dest) const noexcept {
+        return m_counts[static_cast<size_t>(dest)];
+    }
+    [[nodiscard]] size_t deliveries(Destination dest) const noexcept {
+        return m_deliveryCounts[static_cast<size_t>(dest)];
+    }
+    [[nodiscard]] size_t total() const noexcept;
+    [[nodiscard]] bool enabled() const noexcept { return m_maxItems > 0; }
+    // Whether adding to the spool of `dest` evicts its oldest entry
+    [[nodiscard]] bool full(Destination dest) const noexcept {
+        return size(dest) >= m_maxItems;
+    }
+
+   private:
+    RetrySpool() = default;
+    RetrySpool(const RetrySpool&) = delete;
+    RetrySpool& operator=(const RetrySpool&) = delete;
+
+    // Rewrite a spool without its first `drop` entries
+    void dropOldest(Destination dest, size_t drop);
+    void dropOldestDeliveries(Destination dest, size_t drop);
+
+    std::array<size_t, DESTINATION_COUNT> m_counts{};
+    std::array<size_t, DESTINATION_COUNT> m_deliveryCounts{};
+    size_t m_maxItems{0};
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+/**
+ * Fixed-capacity lock-free ring for exactly one producer thread and one
+ * consumer thread. Each side only writes its own index, the other side
+ * reads it with acquire/release ordering, so neither ever blocks.
+ * Capacity must be a power of two.
+ */
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0,
+                  "capacity must be a power of two");
+
+   public:
+    static constexpr size_t CAPACITY = N;
+
+    // Producer only. Returns false and leaves `value` alone when full.
+    [[nodiscard]] bool push(T& value) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        m_slots[tail & (N - 1)] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only
+    [[nodiscard]] std::optional<T> pop() {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return std::nullopt;
+        }
+        std::optional<T> value{std::move(m_slots[head & (N - 1)])};
+        m_head.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+    // Never more than the actual free slots, the consumer may free more
+    // at any time
+    [[nodiscard]] size_t freeSlots() const noexcept {
+        return N - (m_tail.load(std::memory_order_relaxed) -
+                    m_head.load(std::memory_order_acquire));
+    }
+    [[nodiscard]] bool empty() const noexcept {
+        return m_head.load(std::memory_order_relaxed) ==
+               m_tail.load(std::memory_order_acquire);
+    }
+
+   private:
+    std::array<T, N> m_slots{};
+    // Written by the consumer and the producer respectively
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+};
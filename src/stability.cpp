@@ -0,0 +1,77 @@
+#include "stability.hpp"
+
+#include <switch.h>
+#include <sys/stat.h>
+
+#include <array>
+#include <cstdio>
+#include <string>
+
+#include "clock.hpp"
+#include "mp4.hpp"
+#include "upload.hpp"
+#include "upload_queue.hpp"
+
+namespace {
+// How long a movie's size and mtime must stay the same to count as stable
+constexpr u64 STABLE_FOR_MS = 300;
+
+struct FileState {
+    size_t size;
+    time_t mtime;
+};
+
+[[nodiscard]] bool statFile(const std::string& path, FileState& state) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return false;
+    state = FileState{static_cast<size_t>(st.st_size), st.st_mtime};
+    return true;
+}
+
+// JPEG files end with the EOI marker (FF D9)
+[[nodiscard]] bool jpegHasEndMarker(FILE* f) {
+    std::array<unsigned char, 2> marker{};
+    return std::fseek(f, -2, SEEK_END) == 0 &&
+           std::fread(marker.data(), 1, marker.size(), f) == marker.size() &&
+           marker[0] == 0xFF && marker[1] == 0xD9;
+}
+}  // namespace
+
+bool isCaptureComplete(std::string_view path, size_t& size,
+                       CaptureSnapshot& snapshot) {
+    const std::string filePath{path};
+    const bool isMovie = isMovieFile(path);
+
+    FileState state;
+    if (!statFile(filePath, state) || state.size == 0) {
+        return false;
+    }
+
+    if (isMovie) {
+        // Compared with an earlier scan instead of sleeping here, so the
+        // scan moves on to the captures behind a movie that is still growing
+        if (snapshot.sinceTick == 0 || snapshot.size != state.size ||
+            snapshot.mtime != state.mtime) {
+            snapshot = CaptureSnapshot{state.size, state.mtime,
+                                       Clock::get().tick()};
+            return false;
+        }
+        if (elapsedMs(snapshot.sinceTick) < STABLE_FOR_MS) {
+            return false;
+        }
+    }
+
+    FILE* f = std::fopen(filePath.c_str(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+
+    const bool complete =
+        isMovie ? mp4IsComplete(f, state.size) : jpegHasEndMarker(f);
+    std::fclose(f);
+
+    if (complete) {
+        size = state.size;
+    }
+    return complete;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <switch.h>
+
+#include <cstddef>
+#include <ctime>
+#include <string_view>
+
+// Size and mtime of a capture as last seen, kept between scans
+struct CaptureSnapshot {
+    size_t size{0};
+    time_t mtime{0};
+    u64 sinceTick{0};  // When this size and mtime were first seen
+};
+
+/**
+ * Check whether a capture has been completely written, without waiting.
+ * Screenshots are complete as soon as the JPEG end-of-image marker is
+ * present, so they are never delayed. Movies must have kept the size and
+ * mtime recorded in `snapshot` for a short while and contain a `moov` box;
+ * `snapshot` is updated whenever the file changed, so call again on a later
+ * scan. On success `size` receives the final file size.
+ */
+[[nodiscard]] bool isCaptureComplete(std::string_view path, size_t& size,
+                                     CaptureSnapshot& snapshot);
@@ -0,0 +1,143 @@
+#include "title_index.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "logger.hpp"
+
+namespace {
+constexpr uint32_t TITLE_INDEX_MAGIC = 0x4954584E;  // "NXTI"
+constexpr uint32_t TITLE_INDEX_VERSION = 1;
+
+// On-disk header, followed by `count` records sorted by key
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t recordSize;
+};
+
+constexpr size_t KEY_SIZE = 16;
+constexpr size_t RECORD_SIZE = KEY_SIZE + TitleIndex::NAME_SIZE;
+
+[[nodiscard]] constexpr int hexValue(char c) noexcept {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+[[nodiscard]] bool parseKey(std::string_view tid,
+                            std::array<uint8_t, KEY_SIZE>& key) noexcept {
+    if (tid.size() != KEY_SIZE * 2) return false;
+
+    for (size_t i = 0; i < KEY_SIZE; ++i) {
+        const int high = hexValue(tid[i * 2]);
+        const int low = hexValue(tid[i * 2 + 1]);
+        if (high < 0 || low < 0) return false;
+        key[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+    return true;
+}
+}  // namespace
+
+bool TitleIndex::load() {
+    m_count = 0;
+    m_cached = 0;
+
+    FILE* f = std::fopen(TITLE_INDEX_PATH.data(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+
+    FileHeader header{};
+    const bool valid = std::fread(&header, sizeof(header), 1, f) == 1 &&
+                       header.magic == TITLE_INDEX_MAGIC &&
+                       header.version == TITLE_INDEX_VERSION &&
+                       header.recordSize == RECORD_SIZE;
+    std::fclose(f);
+
+    if (!valid) {
+        Logger::get().warn() << "Ignoring invalid title index" << endl;
+        return false;
+    }
+
+    m_count = header.count;
+    return m_count > 0;
+}
+
+bool TitleIndex::search(const Key& key,
+                        std::array<char, NAME_SIZE>& name) const {
+    name.fill('\0');
+
+    FILE* f = std::fopen(TITLE_INDEX_PATH.data(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+
+    // Only keys are read while probing, the name once a match is found
+    Key probe;
+    uint32_t low = 0;
+    uint32_t high = m_count;
+    bool ok = true;
+    while (low < high) {
+        const uint32_t mid = low + (high - low) / 2;
+        const long offset = static_cast<long>(sizeof(FileHeader) +
+                                              size_t{mid} * RECORD_SIZE);
+        if (std::fseek(f, offset, SEEK_SET) != 0 ||
+            std::fread(probe.data(), 1, KEY_SIZE, f) != KEY_SIZE) {
+            ok = false;
+            break;
+        }
+
+        const int cmp = std::memcmp(probe.data(), key.data(), KEY_SIZE);
+        if (cmp == 0) {
+            ok = std::fread(name.data(), 1, NAME_SIZE, f) == NAME_SIZE;
+            name.back() = '\0';
+            break;
+        }
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    std::fclose(f);
+    return ok;
+}
+
+std::string TitleIndex::lookup(std::string_view tid) {
+    Key key;
+    if (!loaded() || !parseKey(tid, key)) {
+        return {};
+    }
+
+    ++m_clock;
+    for (size_t i = 0; i < m_cached; ++i) {
+        if (m_cache[i].key == key) {
+            m_cache[i].lastUse = m_clock;
+            return m_cache[i].name.data();
+        }
+    }
+
+    std::array<char, NAME_SIZE> name;
+    if (!search(key, name)) {
+        // Read errors are not cached, the SD card may recover
+        return {};
+    }
+
+    // Misses are cached too, as an empty name
+    CacheEntry* slot = nullptr;
+    if (m_cached < CACHE_SIZE) {
+        slot = &m_cache[m_cached++];
+    } else {
+        slot = &*std::ranges::min_element(m_cache, {}, &CacheEntry::lastUse);
+    }
+    slot->key = key;
+    slot->name = name;
+    slot->lastUse = m_clock;
+
+    return name.data();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "project.h"
+
+inline constexpr std::string_view TITLE_INDEX_PATH =
+    "sdmc:/config/" APP_TITLE "/titles.bin";
+
+/**
+ * Read-only title ID to game name index stored on the SD card.
+ * The file is built on a host by scripts/build_title_index.py and holds
+ * fixed-size records sorted by the 16-byte ID found in album filenames.
+ * Lookups binary search the file directly, so only the header and a small
+ * LRU cache of recent results are kept in memory.
+ */
+class TitleIndex {
+   public:
+    static constexpr size_t NAME_SIZE = 48;  // Including the terminator
+    static constexpr size_t CACHE_SIZE = 8;
+
+    static TitleIndex& get() noexcept {
+        static TitleIndex instance;
+        return instance;
+    }
+
+    // Validate the index header, returns false when no usable index exists
+    bool load();
+
+    [[nodiscard]] bool loaded() const noexcept { return m_count > 0; }
+    [[nodiscard]] size_t count() const noexcept { return m_count; }
+
+    // Game name for the 32 hex digit ID of an album file, empty if unknown
+    [[nodiscard]] std::string lookup(std::string_view tid);
+
+   private:
+    using Key = std::array<uint8_t, 16>;
+
+    struct CacheEntry {
+        Key key{};
+        std::array<char, NAME_SIZE> name{};
+        uint32_t lastUse{0};
+    };
+
+    TitleIndex() = default;
+    TitleIndex(const TitleIndex&) = delete;
+    TitleIndex& operator=(const TitleIndex&) = delete;
+
+    // Binary search the file, `name` is left empty when the key is absent
+    [[nodiscard]] bool search(const Key& key,
+                              std::array<char, NAME_SIZE>& name) const;
+
+    std::array<CacheEntry, CACHE_SIZE> m_cache{};
+    size_t m_cached{0};
+    uint32_t m_clock{0};
+    uint32_t m_count{0};
+};
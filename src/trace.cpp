@@ -0,0 +1,115 @@
+#include "trace.hpp"
+
+#include <switch.h>
+
+#include <cstdio>
+#include <optional>
+
+#include "logger.hpp"
+
+namespace {
+[[nodiscard]] uint32_t nowMs() noexcept {
+    return static_cast<uint32_t>(armTicksToNs(armGetSystemTick()) /
+                                 1'000'000ULL);
+}
+
+// Wall clock in seconds since the epoch, 0 when the time service fails
+[[nodiscard]] uint32_t epochSeconds() noexcept {
+    if (R_FAILED(timeInitialize())) {
+        return 0;
+    }
+    u64 now = 0;
+    if (R_FAILED(timeGetCurrentTime(TimeType_Default, &now))) {
+        now = 0;
+    }
+    timeExit();
+    return static_cast<uint32_t>(now);
+}
+
+// Records already in a valid trace, nullopt when there is none
+[[nodiscard]] std::optional<uint32_t> existingRecords() {
+    FILE* f = std::fopen(TRACE_PATH.data(), "rb");
+    if (f == nullptr) {
+        return std::nullopt;
+    }
+    TraceHeader header{};
+    const bool valid = std::fread(&header, sizeof(header), 1, f) == 1 &&
+                       header.magic == TRACE_MAGIC &&
+                       header.version == TRACE_VERSION &&
+                       header.recordSize == sizeof(TraceRecord);
+    std::fseek(f, 0, SEEK_END);
+    const long end = std::ftell(f);
+    std::fclose(f);
+
+    if (!valid || end < static_cast<long>(sizeof(header))) {
+        return std::nullopt;
+    }
+    return static_cast<uint32_t>((static_cast<size_t>(end) - sizeof(header)) /
+                                 sizeof(TraceRecord));
+}
+}  // namespace
+
+void TraceRecorder::open() {
+    m_enabled = false;
+    m_count = 0;
+
+    const auto records = existingRecords();
+    if (records.has_value()) {
+        m_count = records.value();
+        m_enabled = m_count < MAX_RECORDS;
+        if (!m_enabled) {
+            Logger::get().warn()
+                << "Trace is full, not recording: " << TRACE_PATH << endl;
+            return;
+        }
+    } else {
+        // Missing or from another version, start a new trace
+        FILE* f = std::fopen(TRACE_PATH.data(), "wb");
+        if (f == nullptr) {
+            Logger::get().error()
+                << "Unable to create trace file: " << TRACE_PATH << endl;
+            return;
+        }
+        const TraceHeader header{TRACE_MAGIC, TRACE_VERSION,
+                                 sizeof(TraceRecord), 0};
+        m_enabled = std::fwrite(&header, sizeof(header), 1, f) == 1;
+        std::fclose(f);
+    }
+
+    // Times restart with every boot, replays keep the boots apart
+    if (m_enabled) {
+        append(TraceRecord{nowMs(), epochSeconds(), 0, 0, TraceKind::Boot, 0});
+    }
+}
+
+void TraceRecorder::capture(uint64_t tick, size_t size, bool isMovie) {
+    if (!m_enabled) return;
+
+    append(TraceRecord{
+        static_cast<uint32_t>(armTicksToNs(tick) / 1'000'000ULL),
+        static_cast<uint32_t>(size), 0, 0, TraceKind::Capture,
+        static_cast<uint8_t>(isMovie ? 1 : 0)});
+}
+
+void TraceRecorder::transfer(Destination dest, size_t bytes,
+                             uint32_t latencyMs, uint16_t status) {
+    if (!m_enabled) return;
+
+    // Stamped with the start of the transfer, like captures are with
+    // their detection
+    append(TraceRecord{nowMs() - latencyMs, static_cast<uint32_t>(bytes),
+                       latencyMs, status, TraceKind::Transfer,
+                       static_cast<uint8_t>(dest)});
+}
+
+void TraceRecorder::append(const TraceRecord& record) {
+    FILE* f = std::fopen(TRACE_PATH.data(), "ab");
+    if (f == nullptr) return;
+    std::fwrite(&record, sizeof(record), 1, f);
+    std::fclose(f);
+
+    if (++m_count == MAX_RECORDS) {
+        m_enabled = false;
+        Logger::get().warn() << "Trace is full, recording stopped" << endl;
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "project.h"
+#include "upload.hpp"
+
+inline constexpr std::string_view TRACE_PATH =
+    "sdmc:/config/" APP_TITLE "/trace.bin";
+
+inline constexpr std::array<char, 4> TRACE_MAGIC = {'N', 'X', 'T', 'R'};
+inline constexpr uint32_t TRACE_VERSION = 2;
+
+struct TraceHeader {
+    std::array<char, 4> magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+};
+static_assert(sizeof(TraceHeader) == 16);
+
+enum class TraceKind : uint8_t {
+    Capture = 0,
+    Transfer = 1,
+    // Recording (re)started after a boot. Times of the records that follow
+    // count from this boot; `size` holds the wall clock in seconds since
+    // the epoch, 0 when it was unavailable.
+    Boot = 2,
+};
+
+struct TraceRecord {
+    uint32_t timeMs;     // Since boot
+    uint32_t size;       // Capture size or bytes sent
+    uint32_t latencyMs;  // Transfer duration, 0 for captures
+    uint16_t status;     // HTTP status of a transfer
+    TraceKind kind;
+    uint8_t detail;  // Destination of a transfer, 1 for a movie capture
+};
+static_assert(sizeof(TraceRecord) == 16);
+
+/**
+ * Compact recorder of capture arrivals and upload outcomes.
+ * Every event is one fixed 16-byte record appended to trace.bin, across
+ * boots, so a trace of real use can be replayed on a host by
+ * host/replay_trace.cpp to compare polling, retry and batching policies.
+ * Recording stops when the file reaches MAX_RECORDS.
+ */
+class TraceRecorder {
+   public:
+    static constexpr uint32_t MAX_RECORDS = 0x10000;  // 1MB
+
+    static TraceRecorder& get() noexcept {
+        static TraceRecorder instance;
+        return instance;
+    }
+
+    // Start recording, continuing an existing trace after a boot record
+    void open();
+
+    // A capture was detected, `tick` is its detection time
+    void capture(uint64_t tick, size_t size, bool isMovie);
+    // A transfer to `dest` ended with HTTP `status`, 0 when it failed
+    // before a response arrived
+    void transfer(Destination dest, size_t bytes, uint32_t latencyMs,
+                  uint16_t status);
+
+    [[nodiscard]] bool enabled() const noexcept { return m_enabled; }
+
+   private:
+    TraceRecorder() = default;
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    void append(const TraceRecord& record);
+
+    uint32_t m_count{0};
+    bool m_enabled{false};
+};
@@ -1,12 +1,35 @@
 #include "upload.hpp"
 
 #include <curl/curl.h>
+#include <sys/socket.h>
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
 #include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
+#include "bandwidth.hpp"
+#include "circuit.hpp"
+#include "clock.hpp"
 #include "config.hpp"
+#include "exif.hpp"
+#include "http.hpp"
+#include "json_stream.hpp"
 #include "logger.hpp"
+#include "mp4.hpp"
+#include "sigv4.hpp"
+#include "spool.hpp"
+#include "title_index.hpp"
+#include "trace.hpp"
+#include "upload_stream.hpp"
+#include "utils.hpp"
 
 namespace fs = std::filesystem;
 
@@ -14,26 +37,317 @@ namespace {
 
 constexpr size_t NX_CURL_BUFFERSIZE = 0x2000L;         // 8KB
 constexpr size_t NX_CURL_UPLOAD_BUFFERSIZE = 0x2000L;  // 8KB
-constexpr long NX_CURL_TIMEOUT = 300L;                 // 5 minutes timeout
+constexpr long NX_CURL_CONNECT_TIMEOUT = 15L;          // seconds
+
+// Abort a transfer that moves fewer than LOW_SPEED_LIMIT bytes/s over a
+// whole STALL_WINDOW_NS, so dead connections are dropped within seconds
+constexpr u64 STALL_WINDOW_NS = 10'000'000'000ULL;
+constexpr size_t LOW_SPEED_LIMIT = 1024;  // bytes/s
+// Once the body is sent the server may need a while to answer, e.g. to
+// process a video, but it has to respond eventually
+constexpr u64 RESPONSE_WINDOW_NS = 60'000'000'000ULL;
+
+// Overall timeout: connection setup and server processing plus a multiple
+// of the time the body should take at the expected throughput. Only a
+// last resort, the watchdog catches transfers that stop making progress.
+constexpr long TIMEOUT_BASE = 30L;  // seconds
+constexpr long TIMEOUT_FACTOR = 4;
+// Expected throughput until a destination has been measured, bytes/s
+constexpr size_t FALLBACK_THROUGHPUT = 0x10000;  // 64KB/s
+// Smaller transfers are dominated by latency and say little about the link
+constexpr curl_off_t MIN_THROUGHPUT_SAMPLE = 0x10000;  // 64KB
+
+// Longest rate limit waited out before the next attempt, longer ones
+// pause the destination instead
+constexpr u64 RATE_LIMIT_WAIT_MAX_MS = 10'000ULL;
+
+// Handshakes faster than this reach a local peer or proxy and say nothing
+// about the path behind it, so the send buffer is left alone
+constexpr size_t MIN_TUNED_RTT_US = 1000;
+
+// Recently measured upload throughput per destination in bytes/s, 0 until
+// the first sample
+std::array<size_t, DESTINATION_COUNT> g_throughput{};
+// Recently measured round-trip time per destination in microseconds
+std::array<size_t, DESTINATION_COUNT> g_rttUs{};
+// Socket send buffer for new connections to each destination, 0 leaves
+// the socket service default
+std::array<int, DESTINATION_COUNT> g_sendBuffer{};
+
+// Moving average, recent transfers weigh the most
+void addSample(size_t& estimate, size_t sample) noexcept {
+    estimate = estimate == 0 ? sample : (estimate * 3 + sample) / 4;
+}
+
+// Send buffer that keeps twice the bandwidth-delay product in flight.
+// Buffers only shrink below TCP_TX_BUF_SIZE_MAX: pinning a size stops the
+// stack from growing the buffer itself, so destinations that need the
+// maximum, are local or haven't been measured yet keep the default.
+// Smaller buffers for low-BDP links leave the socket service room for
+// parallel connections.
+[[nodiscard]] int sendBufferFor(Destination dest) noexcept {
+    const size_t throughput = g_throughput[static_cast<size_t>(dest)];
+    const size_t rttUs = g_rttUs[static_cast<size_t>(dest)];
+    if (throughput == 0 || rttUs < MIN_TUNED_RTT_US) {
+        return 0;
+    }
+    const size_t wanted = throughput * rttUs / 1'000'000 * 2;
+    if (wanted >= TCP_TX_BUF_SIZE_MAX) {
+        return 0;
+    }
+    return static_cast<int>(std::max(wanted, TCP_TX_BUF_SIZE));
+}
+
+int sockoptFunction(void* data, curl_socket_t fd,
+                    curlsocktype purpose) noexcept {
+    if (purpose == CURLSOCKTYPE_IPCXN) {
+        const int size = *static_cast<const int*>(data);
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    }
+    return CURL_SOCKOPT_OK;
+}
 
-struct UploadInfo {
-    FILE* f;
-    size_t sizeLeft;
+// Feed a performed transfer into its destination's estimates, circuit
+// and the trace. Aborted transfers count too, so a retry after a timeout
+// on a slower link gets a longer timeout.
+void recordTransfer(CURL* curl, Destination dest, CURLcode res) noexcept {
+    const auto index = static_cast<size_t>(dest);
+
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    CircuitBreaker::get().record(dest,
+                                 serviceFailed(res == CURLE_OK, status));
+
+    if (TraceRecorder::get().enabled()) {
+        curl_off_t sentBytes = 0;
+        curl_off_t totalUs = 0;
+        curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &sentBytes);
+        curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &totalUs);
+        TraceRecorder::get().transfer(dest, static_cast<size_t>(sentBytes),
+                                      static_cast<uint32_t>(totalUs / 1000),
+                                      static_cast<uint16_t>(status));
+    }
+
+    // The TCP handshake takes one round trip, reused connections report 0
+    curl_off_t lookupUs = 0;
+    curl_off_t connectUs = 0;
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &lookupUs);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connectUs);
+    if (connectUs > lookupUs) {
+        addSample(g_rttUs[index], static_cast<size_t>(connectUs - lookupUs));
+    }
+
+    curl_off_t bytes = 0;
+    curl_off_t speed = 0;
+    curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &bytes);
+    curl_easy_getinfo(curl, CURLINFO_SPEED_UPLOAD_T, &speed);
+    if (bytes < MIN_THROUGHPUT_SAMPLE || speed <= 0) {
+        return;
+    }
+    addSample(g_throughput[index], static_cast<size_t>(speed));
+
+#ifdef ENABLE_TIME_FUNCTIONS
+    // Pairs the buffer a transfer ran with and what it achieved, so the
+    // bounds can be checked against device data, e.g.
+    // [bench] tune=Telegram sndbuf=6144 rtt_us=42000 kbps=70
+    Logger::get().info() << "[bench] tune=" << destinationName(dest)
+                         << " sndbuf=" << g_sendBuffer[index]
+                         << " rtt_us=" << g_rttUs[index]
+                         << " kbps=" << speed / 1024 << endl;
+#endif
+}
+
+// Seconds allowed for sending `size` bytes to `dest`
+long transferTimeout(size_t size, TrafficClass cls, Destination dest) noexcept {
+    size_t rate = g_throughput[static_cast<size_t>(dest)];
+    if (rate == 0) {
+        rate = FALLBACK_THROUGHPUT;
+    }
+    // Throttled transfers can't go faster than the configured rate
+    const size_t limit = BandwidthLimiter::get().rateFor(cls);
+    if (limit != 0) {
+        rate = std::min(rate, limit);
+    }
+    return TIMEOUT_BASE + TIMEOUT_FACTOR * static_cast<long>(size / rate + 1);
+}
+
+// Progress watchdog of one transfer
+struct TransferWatchdog {
+    Destination dest{Destination::Telegram};
+    // Body size, for chunked uploads whose total curl doesn't know
+    curl_off_t size{0};
+    // Bytes that must move per window while the body is being sent
+    curl_off_t minBytes{0};
+    curl_off_t windowBytes{0};
+    u64 windowTick{0};
 };
 
-size_t uploadReadFunction(void* ptr, size_t size, size_t nmemb,
-                          void* data) noexcept {
-    auto* ui = static_cast<UploadInfo*>(data);
-    const size_t maxBytes = size * nmemb;
+int watchdogFunction(void* data, curl_off_t, curl_off_t dlnow,
+                     curl_off_t ultotal, curl_off_t ulnow) noexcept {
+    auto* watchdog = static_cast<TransferWatchdog*>(data);
+    const curl_off_t progress = ulnow + dlnow;
+    const u64 now = armGetSystemTick();
+    if (watchdog->windowTick == 0) {
+        watchdog->windowTick = now;
+        watchdog->windowBytes = progress;
+        return 0;
+    }
 
-    if (maxBytes < 1 || ui->sizeLeft == 0) {
+    const curl_off_t total = ultotal > 0 ? ultotal : watchdog->size;
+    const bool sent = ulnow >= total;
+    const u64 window = sent ? RESPONSE_WINDOW_NS : STALL_WINDOW_NS;
+    if (armTicksToNs(now - watchdog->windowTick) < window) {
         return 0;
     }
 
-    const size_t bytesToRead = std::min(ui->sizeLeft, maxBytes);
-    const size_t bytesRead = std::fread(ptr, 1, bytesToRead, ui->f);
-    ui->sizeLeft -= bytesRead;
-    return bytesRead;
+    const curl_off_t minBytes = sent ? 1 : watchdog->minBytes;
+    if (progress - watchdog->windowBytes < minBytes) {
+        Logger::get().warn()
+            << "[" << destinationName(watchdog->dest) << "] "
+            << (sent ? "No response" : "Transfer stalled") << " for "
+            << window / 1'000'000'000ULL << "s, aborting" << endl;
+        return 1;  // CURLE_ABORTED_BY_CALLBACK
+    }
+    watchdog->windowTick = now;
+    watchdog->windowBytes = progress;
+    return 0;
+}
+
+// Replace the flat timeout: derive the overall timeout from the size and
+// the destination's throughput and arm the stall watchdog, which must
+// outlive the transfer. New connections to low-BDP destinations get a
+// smaller send buffer.
+void setTransferLimits(CURL* curl, TransferWatchdog& watchdog,
+                       Destination dest, size_t size, TrafficClass cls) {
+    // A throttled transfer must not be mistaken for a stalled one
+    size_t lowSpeed = LOW_SPEED_LIMIT;
+    const size_t limit = BandwidthLimiter::get().rateFor(cls);
+    if (limit != 0) {
+        lowSpeed = std::min(lowSpeed, limit / 2 + 1);
+    }
+
+    watchdog = TransferWatchdog{};
+    watchdog.dest = dest;
+    watchdog.size = static_cast<curl_off_t>(size);
+    watchdog.minBytes = static_cast<curl_off_t>(
+        lowSpeed * (STALL_WINDOW_NS / 1'000'000'000ULL));
+
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, NX_CURL_CONNECT_TIMEOUT);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT,
+                     transferTimeout(size, cls, dest));
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, watchdogFunction);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &watchdog);
+
+    int& sendBuffer = g_sendBuffer[static_cast<size_t>(dest)];
+    sendBuffer = sendBufferFor(dest);
+    if (sendBuffer != 0) {
+        curl_easy_setopt(curl, CURLOPT_SOCKOPTFUNCTION, sockoptFunction);
+        curl_easy_setopt(curl, CURLOPT_SOCKOPTDATA, &sendBuffer);
+    }
+}
+
+#ifdef ENABLE_TIME_FUNCTIONS
+// Log one finished transfer as a single key=value line, e.g.
+// [bench] upload=Telegram bytes=1048576 us=912000 connect_us=41000
+//         tls_us=180000 kbps=1122 reads=128 buffer=8192
+// so throughput and read-callback granularity can be compared between
+// versions and buffer sizes
+void logTransferStats(CURL* curl, std::string_view logPrefix,
+                      std::span<const UploadInfo> infos) {
+    curl_off_t bytes = 0;
+    curl_off_t totalUs = 0;
+    curl_off_t connectUs = 0;
+    curl_off_t tlsUs = 0;
+    curl_off_t speed = 0;
+    curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &bytes);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &totalUs);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connectUs);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &tlsUs);
+    curl_easy_getinfo(curl, CURLINFO_SPEED_UPLOAD_T, &speed);
+
+    uint32_t reads = 0;
+    for (const auto& ui : infos) {
+        reads += ui.reads;
+    }
+
+    // "[Telegram] " -> "Telegram"
+    const std::string_view name =
+        logPrefix.substr(1, logPrefix.find(']') - 1);
+    Logger::get().info() << "[bench] upload=" << name << " bytes=" << bytes
+                         << " us=" << totalUs << " connect_us=" << connectUs
+                         << " tls_us=" << tlsUs << " kbps=" << speed / 1024
+                         << " reads=" << reads
+                         << " buffer=" << NX_CURL_UPLOAD_BUFFERSIZE << endl;
+}
+#else
+constexpr void logTransferStats(CURL*, std::string_view,
+                                std::span<const UploadInfo>) noexcept {}
+#endif
+
+// Send the SHA-256 of the streamed body as an HTTP trailer (chunked only)
+int digestTrailerFunction(struct curl_slist** list, void* data) noexcept {
+    const auto* ui = static_cast<const UploadInfo*>(data);
+    if (ui->sizeLeft != 0) {
+        return CURL_TRAILERFUNC_ABORT;
+    }
+
+    std::string trailer = "X-Content-SHA256: ";
+    trailer += std::string_view(digestText(*ui)).substr(
+        DIGEST_FIELD_PREFIX.size());
+    *list = curl_slist_append(*list, trailer.c_str());
+    return CURL_TRAILERFUNC_OK;
+}
+
+// Add the message text of an upload: the game name, followed by the digest
+// when enabled. The digest is streamed, so this must follow the file part.
+void addCaptionField(struct curl_httppost** formpost,
+                     struct curl_httppost** lastptr, const char* fieldName,
+                     UploadInfo& captionField) {
+    if (Config::get().sendDigest()) {
+        curl_formadd(formpost, lastptr, CURLFORM_COPYNAME, fieldName,
+                     CURLFORM_STREAM, &captionField, CURLFORM_CONTENTSLENGTH,
+                     captionField.sizeLeft, CURLFORM_END);
+    } else if (!captionField.caption.empty()) {
+        curl_formadd(formpost, lastptr, CURLFORM_COPYNAME, fieldName,
+                     CURLFORM_COPYCONTENTS, captionField.caption.data(),
+                     CURLFORM_CONTENTSLENGTH, captionField.caption.size(),
+                     CURLFORM_END);
+    }
+}
+
+// Append `text` to a JSON document as a quoted string. Control characters
+// must be escaped, a raw newline in a caption makes the document invalid.
+void appendJsonString(std::string& json, std::string_view text) {
+    constexpr std::string_view hex = "0123456789abcdef";
+    json += '"';
+    for (const char c : text) {
+        switch (c) {
+            case '"':
+            case '\\':
+                json += '\\';
+                json += c;
+                break;
+            case '\n':
+                json += "\\n";
+                break;
+            case '\r':
+                json += "\\r";
+                break;
+            case '\t':
+                json += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    json += "\\u00";
+                    json += hex[(c >> 4) & 0xF];
+                    json += hex[c & 0xF];
+                } else {
+                    json += c;
+                }
+        }
+    }
+    json += '"';
 }
 
 struct FileTypeInfo {
@@ -56,6 +370,33 @@ constexpr FileTypeInfo getFileTypeInfo(std::string_view extension,
     return FileTypeInfo{"", "", ""};
 }
 
+// Add sendVideo metadata fields to a multipart form
+void addVideoFields(struct curl_httppost** formpost,
+                    struct curl_httppost** lastptr, const Mp4Info& info) {
+    const auto addNumber = [&](const char* name, uint32_t value) {
+        std::array<char, 16> text{};
+        std::to_chars(text.data(), text.data() + text.size() - 1, value);
+        curl_formadd(formpost, lastptr, CURLFORM_COPYNAME, name,
+                     CURLFORM_COPYCONTENTS, text.data(), CURLFORM_END);
+    };
+
+    addNumber("duration", info.durationSeconds);
+    addNumber("width", info.width);
+    addNumber("height", info.height);
+    if (info.fastStart) {
+        curl_formadd(formpost, lastptr, CURLFORM_COPYNAME,
+                     "supports_streaming", CURLFORM_COPYCONTENTS, "true",
+                     CURLFORM_END);
+    }
+}
+
+// The 32 hex digit title ID at the end of an album path
+[[nodiscard]] constexpr std::string_view albumTitleId(
+    std::string_view path) noexcept {
+    return path.length() < 36 ? std::string_view{}
+                              : path.substr(path.length() - 36, 32);
+}
+
 // Validation result for file uploads
 enum class ValidationResult {
     Success,  // Valid and should upload
@@ -74,10 +415,10 @@ ValidationResult validateUploadFile(std::string_view path,
         return ValidationResult::Error;
     }
 
-    tid = path.substr(path.length() - 36, 32);
+    tid = albumTitleId(path);
     Logger::get().debug() << logPrefix << "Title ID: " << tid << endl;
 
-    isMovie = path.back() == '4';
+    isMovie = isMovieFile(path);
     // Check target-specific config to determine whether this type is allowed to
     // upload
     const bool shouldUpload = isMovie ? uploadMovies : uploadScreenshots;
@@ -90,25 +431,501 @@ ValidationResult validateUploadFile(std::string_view path,
     return ValidationResult::Success;
 }
 
-}  // namespace
+// Number of `files` the destination accepts, checked without touching them
+[[nodiscard]] size_t countAccepted(std::span<const UploadFile> files,
+                                   bool uploadScreenshots, bool uploadMovies) {
+    return static_cast<size_t>(
+        std::ranges::count_if(files, [&](const UploadFile& file) {
+            return isMovieFile(file.path) ? uploadMovies : uploadScreenshots;
+        }));
+}
 
-bool sendFileToTelegram(std::string_view path, size_t size, bool compression) {
-    constexpr std::string_view logPrefix = "[Telegram] ";
-    std::string_view tid;
-    bool isMovie;
+// Open files for a batched upload, keeping those the destination accepts.
+// `accepted` receives the index in `files` of every opened entry.
+// Returns the number of opened entries or -1 on error.
+int openBatchFiles(std::span<const UploadFile> files,
+                   std::string_view logPrefix, bool uploadScreenshots,
+                   bool uploadMovies,
+                   std::array<UploadInfo, MAX_BATCH_SIZE>& infos,
+                   std::array<size_t, MAX_BATCH_SIZE>& accepted) {
+    int count = 0;
+
+    for (size_t index = 0; index < files.size(); ++index) {
+        if (count == static_cast<int>(MAX_BATCH_SIZE)) break;
+
+        const UploadFile& file = files[index];
+        std::string_view tid;
+        bool isMovie;
+        const auto validationResult =
+            validateUploadFile(file.path, logPrefix, tid, isMovie,
+                               uploadScreenshots, uploadMovies);
+        if (validationResult == ValidationResult::Skip) continue;
+
+        FILE* f = nullptr;
+        if (validationResult == ValidationResult::Success) {
+            f = std::fopen(std::string(file.path).c_str(), "rb");
+            if (f == nullptr) {
+                Logger::get().error() << logPrefix << "fopen() failed" << endl;
+            }
+        }
 
-    // Validate file and check if upload is needed
-    const auto validationResult =
-        validateUploadFile(path, logPrefix, tid, isMovie,
-                           Config::get().telegramUploadScreenshots(),
-                           Config::get().telegramUploadMovies());
-    if (validationResult == ValidationResult::Error) {
+        if (f == nullptr) {
+            for (int i = 0; i < count; ++i) {
+                std::fclose(infos[i].f);
+            }
+            return -1;
+        }
+
+        infos[count] = UploadInfo{f, file.size, trafficClassOf(isMovie)};
+        accepted[count] = index;
+        ++count;
+    }
+
+    return count;
+}
+
+void closeBatchFiles(std::array<UploadInfo, MAX_BATCH_SIZE>& infos,
+                     int count) {
+    for (int i = 0; i < count; ++i) {
+        std::fclose(infos[i].f);
+    }
+}
+
+void finishBatchDigests(std::array<UploadInfo, MAX_BATCH_SIZE>& infos,
+                        const std::array<size_t, MAX_BATCH_SIZE>& accepted,
+                        int count, std::span<ContentDigest> digests) noexcept {
+    for (int i = 0; i < count; ++i) {
+        if (accepted[i] < digests.size()) {
+            finishDigest(infos[i], &digests[accepted[i]]);
+        }
+    }
+}
+
+// Text of bounded length kept without allocating
+template <size_t N>
+struct FixedText {
+    std::array<char, N> data{};
+    size_t length{0};
+
+    void assign(std::string_view text) noexcept {
+        length = std::min(text.size(), N);
+        std::copy_n(text.begin(), length, data.begin());
+    }
+    [[nodiscard]] std::string_view view() const noexcept {
+        return {data.data(), length};
+    }
+};
+
+// What the Telegram and Discord APIs said about a request, picked out of
+// the body while it arrives
+struct ApiResponse {
+    long errorCode{0};
+    u64 retryAfterMs{0};  // Set when rate limited
+    FixedText<128> description;
+    std::array<int64_t, MAX_BATCH_SIZE> messageIds{};  // Telegram
+    size_t messageIdCount{0};
+    FixedText<24> messageId;  // Discord snowflake
+    FixedText<128> fileId;    // Telegram, of the largest photo size
+    // Discord CDN link of the first attachment
+    FixedText<320> attachmentUrl;
+    size_t attachmentCount{0};
+};
+
+template <typename T>
+[[nodiscard]] bool parseNumber(std::string_view text, T& out) noexcept {
+    const auto [end, ec] =
+        std::from_chars(text.data(), text.data() + text.size(), out);
+    return ec == std::errc{} && end == text.data() + text.size();
+}
+
+// Seconds as sent by Telegram (integer) or Discord (with a fraction),
+// rounded up to milliseconds
+[[nodiscard]] u64 parseSecondsMs(std::string_view text) noexcept {
+    const size_t dot = text.find('.');
+    u64 seconds = 0;
+    if (!parseNumber(text.substr(0, dot), seconds)) {
+        return 0;
+    }
+    u64 ms = seconds * 1000;
+    if (dot == std::string_view::npos) {
+        return ms;
+    }
+    u64 scale = 100;
+    bool remainder = false;
+    for (const char c : text.substr(dot + 1)) {
+        if (c < '0' || c > '9') break;
+        if (scale == 0) {
+            remainder = remainder || c != '0';
+            continue;
+        }
+        ms += static_cast<u64>(c - '0') * scale;
+        scale /= 10;
+    }
+    return remainder ? ms + 1 : ms;
+}
+
+void onApiValue(void* context, const JsonStream& json, std::string_view value,
+                bool isString) {
+    auto& response = *static_cast<ApiResponse*>(context);
+
+    if (json.path({"error_code"}) || json.path({"code"})) {
+        (void)parseNumber(value, response.errorCode);
+    } else if (json.path({"description"}) || json.path({"message"}) ||
+               json.path({"error"})) {
+        response.description.assign(value);
+    } else if (json.path({"parameters", "retry_after"}) ||
+               json.path({"retry_after"})) {
+        response.retryAfterMs = parseSecondsMs(value);
+    } else if (json.path({"result", "message_id"}) ||
+               json.path({"result", "*", "message_id"})) {
+        int64_t id = 0;
+        if (response.messageIdCount < response.messageIds.size() &&
+            parseNumber(value, id)) {
+            response.messageIds[response.messageIdCount++] = id;
+        }
+    } else if (json.path({"id"}) && isString) {
+        response.messageId.assign(value);
+    } else if (json.path({"result", "photo", "*", "file_id"}) ||
+               json.path({"result", "video", "file_id"}) ||
+               json.path({"result", "animation", "file_id"}) ||
+               json.path({"result", "document", "file_id"})) {
+        // Photo sizes come smallest first, the last one is the original
+        response.fileId.assign(value);
+    } else if (json.path({"attachments", "*", "url"})) {
+        if (response.attachmentCount++ == 0) {
+            response.attachmentUrl.assign(value);
+        }
+    }
+}
+
+// Write callback state. The scanner keeps a pointer to the response, so
+// a reader must stay in place once set on a handle.
+struct ApiResponseReader {
+    ApiResponseReader() = default;
+    ApiResponseReader(const ApiResponseReader&) = delete;
+    ApiResponseReader& operator=(const ApiResponseReader&) = delete;
+
+    ApiResponse response;
+    JsonStream json{onApiValue, &response};
+};
+
+size_t apiResponseFunction(char* ptr, size_t size, size_t nmemb,
+                           void* data) noexcept {
+    const size_t bytes = size * nmemb;
+    static_cast<ApiResponseReader*>(data)->json.feed({ptr, bytes});
+    return bytes;
+}
+
+// Scan the response body of `curl` into `reader` instead of printing it
+void readApiResponse(CURL* curl, ApiResponseReader& reader) {
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, apiResponseFunction);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &reader);
+}
+
+// Log a request the API rejected along with the reason it gave. A rate
+// limit is honoured before the next attempt: short waits are taken right
+// here, longer ones pause the destination so the upload thread isn't
+// blocked and captures are spooled meanwhile.
+void reportApiError(Destination dest, std::string_view logPrefix,
+                    std::string_view failure, long responseCode,
+                    const ApiResponse& response) {
+    // Telegram repeats the status as error_code, Discord and ntfy send
+    // their own codes
+    std::string reason;
+    if (response.errorCode != 0 && response.errorCode != responseCode) {
+        reason += " (code ";
+        reason += std::to_string(response.errorCode);
+        reason += ")";
+    }
+    if (response.description.length > 0) {
+        reason += ": ";
+        reason += response.description.view();
+    }
+    Logger::get().error() << logPrefix << failure << ", got response code "
+                          << responseCode << reason << endl;
+
+    if (responseCode != 429 || response.retryAfterMs == 0) {
+        return;
+    }
+    if (response.retryAfterMs <= RATE_LIMIT_WAIT_MAX_MS) {
+        Logger::get().info() << logPrefix << "Rate limited, waiting "
+                             << response.retryAfterMs << "ms" << endl;
+        Clock::get().sleep(response.retryAfterMs * 1'000'000ULL);
+        return;
+    }
+    Logger::get().warn() << logPrefix << "Rate limited, pausing for "
+                         << (response.retryAfterMs + 999) / 1000 << "s"
+                         << endl;
+    CircuitBreaker::get().pause(dest, response.retryAfterMs * 1'000'000ULL);
+}
+
+// Send a small request delivering an already uploaded message to one more
+// recipient. `url` and `body` must stay valid until it returns.
+bool sendDeliveryRequest(Destination dest, const std::string& url,
+                         std::string_view body, struct curl_slist* headers,
+                         std::string_view recipient) {
+    std::string logPrefix = "[";
+    logPrefix += destinationName(dest);
+    logPrefix += "] ";
+    CURL* curl = HttpSession::get().createHandle();
+    if (!curl) {
+        Logger::get().error() << logPrefix << "curl_easy_init() failed" << endl;
         return false;
     }
-    if (validationResult == ValidationResult::Skip) {
-        return true;  // Not an error, just skipping per config
+
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.data());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE,
+                     static_cast<long>(body.size()));
+    if (headers != nullptr) {
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    }
+    ApiResponseReader reader;
+    readApiResponse(curl, reader);
+    TransferWatchdog watchdog;
+    setTransferLimits(curl, watchdog, dest, body.size(),
+                      TrafficClass::Screenshot);
+
+    const CURLcode res = HttpSession::get().perform(curl);
+    recordTransfer(curl, dest, res);
+    long responseCode = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+    curl_easy_cleanup(curl);
+
+    if (res != CURLE_OK) {
+        Logger::get().error() << logPrefix << "Delivery to " << recipient
+                              << " failed: " << curl_easy_strerror(res)
+                              << endl;
+        return false;
+    }
+    if (responseCode != 200) {
+        std::string failure = "Delivery to ";
+        failure += recipient;
+        failure += " failed";
+        reportApiError(dest, logPrefix, failure, responseCode,
+                       reader.response);
+        return false;
+    }
+    Logger::get().info() << logPrefix << "Delivered to " << recipient << endl;
+    return true;
+}
+
+// Copy messages from the chat `origin` to `chatId`. Copies reference the
+// uploaded files, so nothing is uploaded again.
+[[nodiscard]] bool copyToChat(std::string_view chatId,
+                              std::string_view origin,
+                              std::string_view messageIds) {
+    const bool single = messageIds.find(',') == std::string_view::npos;
+    std::string url{Config::get().getTelegramApiUrl()};
+    url += "/bot";
+    url += Config::get().getTelegramBotToken();
+    url += single ? "/copyMessage" : "/copyMessages";
+    url += "?chat_id=";
+    url += chatId;
+    url += "&from_chat_id=";
+    url += origin;
+    if (single) {
+        url += "&message_id=";
+        url += messageIds;
+    } else {
+        url += "&message_ids=";
+        url += url_encode("[" + std::string(messageIds) + "]");
+    }
+    return sendDeliveryRequest(Destination::Telegram, url, {}, nullptr,
+                               chatId);
+}
+
+// Forward a message from the channel `origin` to `channelId`. Forwards
+// reference the original attachments, so nothing is uploaded again. When
+// the forward is refused, e.g. because the bot can't read the origin
+// channel in that server, a message of a single attachment is posted as
+// its CDN link instead, which Discord embeds.
+[[nodiscard]] bool forwardToChannel(std::string_view channelId,
+                                    std::string_view origin,
+                                    std::string_view messageId,
+                                    std::string_view attachmentUrl) {
+    std::string body = R"({"message_reference":{"type":1,"message_id":")";
+    body += messageId;
+    body += R"(","channel_id":")";
+    body += origin;
+    body += R"("}})";
+
+    std::string authHeader = "Authorization: Bot ";
+    authHeader += Config::get().getDiscordBotToken();
+    struct curl_slist* headers = curl_slist_append(nullptr, authHeader.c_str());
+    headers = curl_slist_append(headers, "Content-Type: application/json");
+
+    std::string url{Config::get().getDiscordApiUrl()};
+    url += "/channels/";
+    url += channelId;
+    url += "/messages";
+    bool delivered = sendDeliveryRequest(Destination::Discord, url, body,
+                                         headers, channelId);
+    if (!delivered && !attachmentUrl.empty() &&
+        CircuitBreaker::get().allows(Destination::Discord)) {
+        Logger::get().info() << "[Discord] Posting the attachment link to "
+                             << channelId << " instead" << endl;
+        body = R"({"content":)";
+        appendJsonString(body, attachmentUrl);
+        body += '}';
+        delivered = sendDeliveryRequest(Destination::Discord, url, body,
+                                        headers, channelId);
+    }
+    curl_slist_free_all(headers);
+    return delivered;
+}
+
+// Copy or forward messages already in the first recipient `origin` to
+// `recipient`
+[[nodiscard]] bool deliver(Destination dest, std::string_view recipient,
+                           std::string_view origin,
+                           std::string_view messageIds,
+                           std::string_view attachmentUrl) {
+    return dest == Destination::Telegram
+               ? copyToChat(recipient, origin, messageIds)
+               : forwardToChannel(recipient, origin, messageIds,
+                                  attachmentUrl);
+}
+
+// Deliver messages from the first recipient to the others. Those that
+// fail, or whose circuit opened on the way, are spooled and retried from
+// there, the upload itself already succeeded. Returns whether every
+// recipient got the messages.
+[[nodiscard]] bool deliverToOthers(Destination dest,
+                                   std::span<const std::string> recipients,
+                                   std::string_view messageIds,
+                                   std::string_view attachmentUrl = {}) {
+    bool delivered = true;
+    for (const auto& recipient : recipients.subspan(1)) {
+        if (CircuitBreaker::get().allows(dest) &&
+            deliver(dest, recipient, recipients.front(), messageIds,
+                    attachmentUrl)) {
+            continue;
+        }
+        delivered = false;
+        RetrySpool::get().addDelivery(dest, recipient, recipients.front(),
+                                      messageIds, attachmentUrl);
+    }
+    return delivered;
+}
+
+// Copy the messages just sent to the first chat into every other chat
+[[nodiscard]] bool copyToOtherChats(const ApiResponse& response) {
+    const auto chatIds = Config::get().getTelegramChatIds();
+    if (chatIds.size() < 2) {
+        return true;
+    }
+
+    const size_t count = response.messageIdCount;
+    if (count == 0) {
+        Logger::get().error() << "[Telegram] No message_id in the response, "
+                                 "can't copy to the other chats"
+                              << endl;
+        return false;
+    }
+    std::string ids;
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) ids += ',';
+        ids += std::to_string(response.messageIds[i]);
+    }
+    return deliverToOthers(Destination::Telegram, chatIds, ids);
+}
+
+// Forward the message just sent to the first channel into every other
+// channel
+[[nodiscard]] bool forwardToOtherChannels(const ApiResponse& response) {
+    const auto channelIds = Config::get().getDiscordChannelIds();
+    if (channelIds.size() < 2) {
+        return true;
+    }
+
+    const std::string_view messageId = response.messageId.view();
+    if (messageId.empty()) {
+        Logger::get().error() << "[Discord] No message id in the response, "
+                                 "can't forward to the other channels"
+                              << endl;
+        return false;
+    }
+    // A link can only stand in for a message of a single attachment
+    const std::string_view attachmentUrl =
+        response.attachmentCount == 1 ? response.attachmentUrl.view()
+                                      : std::string_view{};
+    return deliverToOthers(Destination::Discord, channelIds, messageId,
+                           attachmentUrl);
+}
+
+// A prepared sendPhoto/sendVideo/sendDocument request. Owns the file, the
+// form and the curl handle; it must stay in place once prepared because
+// the form points into it.
+struct TelegramRequest {
+    TelegramRequest() = default;
+    TelegramRequest(const TelegramRequest&) = delete;
+    TelegramRequest& operator=(const TelegramRequest&) = delete;
+
+    ~TelegramRequest() {
+        if (curl != nullptr) curl_easy_cleanup(curl);
+        if (formpost != nullptr) curl_formfree(formpost);
+        stopReadAhead(ui);
+        if (ui.f != nullptr) std::fclose(ui.f);
+    }
+
+    UploadInfo ui;
+    UploadInfo captionField;
+    std::string gameName;
+    std::string url;
+    std::vector<char> preview;  // Embedded thumbnail, when previews are on
+    int64_t previewMessageId{0};  // Message the upload replaces, if any
+    ApiResponseReader reader;
+    TransferWatchdog watchdog;
+    struct curl_httppost* formpost{nullptr};
+    CURL* curl{nullptr};
+};
+
+constexpr std::string_view TELEGRAM_LOG_PREFIX = "[Telegram] ";
+// Largest embedded thumbnail sent as a preview, those of Switch
+// screenshots are 320x180 and take a few KB
+constexpr size_t PREVIEW_MAX_SIZE = 0x8000;  // 32KB
+
+// Screenshot whose preview is still waiting for the full image. A retry of
+// the same capture replaces that message instead of sending another one,
+// the scheduler takes it along when the capture is spooled.
+struct PendingPreview {
+    std::string path;
+    int64_t messageId{0};
+};
+
+PendingPreview g_pendingPreview;
+
+// Read the EXIF thumbnail of a screenshot into `preview`. No decoding, the
+// thumbnail is a JPEG of its own. The file position is left undefined.
+void readPreview(FILE* f, size_t size, std::vector<char>& preview) {
+    const auto thumbnail = exifFindThumbnail(f, size);
+    if (!thumbnail.has_value() || thumbnail->length > PREVIEW_MAX_SIZE) {
+        Logger::get().debug()
+            << TELEGRAM_LOG_PREFIX << "No usable EXIF thumbnail" << endl;
+        return;
+    }
+    preview.resize(thumbnail->length);
+    if (std::fseek(f, static_cast<long>(thumbnail->offset), SEEK_SET) != 0 ||
+        std::fread(preview.data(), 1, preview.size(), f) != preview.size()) {
+        preview.clear();
     }
+}
+
+// Validate the file and check whether Telegram takes it
+ValidationResult validateTelegramFile(std::string_view path,
+                                      std::string_view& tid, bool& isMovie) {
+    return validateUploadFile(path, TELEGRAM_LOG_PREFIX, tid, isMovie,
+                              Config::get().telegramUploadScreenshots(),
+                              Config::get().telegramUploadMovies());
+}
 
+// Build the request of a validated file, ready to be performed
+bool prepareTelegramRequest(std::string_view path, size_t size,
+                            bool compression, std::string_view tid,
+                            bool isMovie, TelegramRequest& request) {
+    constexpr std::string_view logPrefix = TELEGRAM_LOG_PREFIX;
     const fs::path filePath{path};
     const auto fileTypeInfo =
         getFileTypeInfo(filePath.extension().string(), compression);
@@ -125,30 +942,63 @@ bool sendFileToTelegram(std::string_view path, size_t size, bool compression) {
         return false;
     }
 
-    UploadInfo ui{f, size};
-    struct curl_httppost* formpost = nullptr;
+    // Native videos carry their metadata so Telegram can show the player
+    // right away instead of probing the file
+    std::optional<Mp4Info> videoInfo;
+    if (fileTypeInfo.telegramMethod == "sendVideo") {
+        videoInfo = mp4ReadInfo(f, size);
+        if (std::fseek(f, 0, SEEK_SET) != 0) {
+            std::fclose(f);
+            Logger::get().error() << logPrefix << "fseek() failed" << endl;
+            return false;
+        }
+        if (!videoInfo.has_value()) {
+            Logger::get().debug()
+                << logPrefix << "No MP4 metadata found" << endl;
+        }
+    } else if (fileTypeInfo.telegramMethod == "sendPhoto" &&
+               Config::get().telegramPreview()) {
+        // Sent ahead of the full image, see sendPreviewFirst()
+        readPreview(f, size, request.preview);
+        if (std::fseek(f, 0, SEEK_SET) != 0) {
+            std::fclose(f);
+            Logger::get().error() << logPrefix << "fseek() failed" << endl;
+            return false;
+        }
+    }
+
+    request.gameName = TitleIndex::get().lookup(tid);
+    request.ui = UploadInfo{f, size, trafficClassOf(isMovie)};
+    request.captionField = makeDigestField(request.ui, request.gameName);
     struct curl_httppost* lastptr = nullptr;
 
-    curl_formadd(&formpost, &lastptr, CURLFORM_COPYNAME,
+    curl_formadd(&request.formpost, &lastptr, CURLFORM_COPYNAME,
                  fileTypeInfo.copyName.data(), CURLFORM_FILENAME,
-                 filePath.c_str(), CURLFORM_STREAM, &ui,
+                 filePath.c_str(), CURLFORM_STREAM, &request.ui,
                  CURLFORM_CONTENTSLENGTH, size, CURLFORM_CONTENTTYPE,
                  fileTypeInfo.contentType.data(), CURLFORM_END);
 
-    CURL* curl = curl_easy_init();
+    if (videoInfo.has_value()) {
+        addVideoFields(&request.formpost, &lastptr, videoInfo.value());
+    }
+
+    // The caption follows the file part so its digest is known by then
+    addCaptionField(&request.formpost, &lastptr, "caption",
+                    request.captionField);
+
+    CURL* curl = HttpSession::get().createHandle();
     if (!curl) {
-        std::fclose(f);
-        curl_formfree(formpost);
         Logger::get().error() << logPrefix << "curl_easy_init() failed" << endl;
         return false;
     }
+    request.curl = curl;
 
     // Build URL
     const auto apiUrl = Config::get().getTelegramApiUrl();
     const auto botToken = Config::get().getTelegramBotToken();
     const auto chatId = Config::get().getTelegramChatId();
 
-    std::string url;
+    std::string& url = request.url;
     url.reserve(apiUrl.size() + botToken.size() + chatId.size() +
                 fileTypeInfo.telegramMethod.size() + 20);
     url = apiUrl;
@@ -164,48 +1014,671 @@ bool sendFileToTelegram(std::string_view path, size_t size, bool compression) {
     curl_easy_setopt(curl, CURLOPT_POST, 1L);
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_READFUNCTION, uploadReadFunction);
+    curl_easy_setopt(curl, CURLOPT_HTTPPOST, request.formpost);
+    curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, NX_CURL_BUFFERSIZE);
+    curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE,
+                     NX_CURL_UPLOAD_BUFFERSIZE);
+    setTransferLimits(curl, request.watchdog, Destination::Telegram, size,
+                      request.ui.trafficClass);
+    readApiResponse(curl, request.reader);
+
+    return true;
+}
+
+// Send the thumbnail of a prepared screenshot to the first chat. Returns
+// the id of the preview message.
+std::optional<int64_t> sendTelegramPreview(const TelegramRequest& request) {
+    constexpr std::string_view logPrefix = TELEGRAM_LOG_PREFIX;
+    struct curl_httppost* formpost = nullptr;
+    struct curl_httppost* lastptr = nullptr;
+    curl_formadd(&formpost, &lastptr, CURLFORM_COPYNAME, "photo",
+                 CURLFORM_BUFFER, "preview.jpg", CURLFORM_BUFFERPTR,
+                 request.preview.data(), CURLFORM_BUFFERLENGTH,
+                 static_cast<long>(request.preview.size()),
+                 CURLFORM_CONTENTTYPE, "image/jpeg", CURLFORM_END);
+    if (!request.gameName.empty()) {
+        curl_formadd(&formpost, &lastptr, CURLFORM_COPYNAME, "caption",
+                     CURLFORM_COPYCONTENTS, request.gameName.c_str(),
+                     CURLFORM_END);
+    }
+
+    CURL* curl = HttpSession::get().createHandle();
+    if (!curl) {
+        curl_formfree(formpost);
+        Logger::get().error() << logPrefix << "curl_easy_init() failed" << endl;
+        return std::nullopt;
+    }
+
+    std::string url{Config::get().getTelegramApiUrl()};
+    url += "/bot";
+    url += Config::get().getTelegramBotToken();
+    url += "/sendPhoto?chat_id=";
+    url += Config::get().getTelegramChatId();
+
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_HTTPPOST, formpost);
+    ApiResponseReader reader;
+    readApiResponse(curl, reader);
+    TransferWatchdog watchdog;
+    setTransferLimits(curl, watchdog, Destination::Telegram,
+                      request.preview.size(), TrafficClass::Screenshot);
+
+    const CURLcode res = HttpSession::get().perform(curl);
+    recordTransfer(curl, Destination::Telegram, res);
+    long responseCode = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+    curl_easy_cleanup(curl);
+    curl_formfree(formpost);
+
+    if (res != CURLE_OK) {
+        Logger::get().error() << logPrefix << "Sending preview failed: "
+                              << curl_easy_strerror(res) << endl;
+        return std::nullopt;
+    }
+    const ApiResponse& response = reader.response;
+    if (responseCode != 200 || response.messageIdCount == 0) {
+        reportApiError(Destination::Telegram, logPrefix,
+                       "Sending preview failed", responseCode, response);
+        return std::nullopt;
+    }
+    Logger::get().info() << logPrefix << "Sent preview ("
+                         << request.preview.size() << " bytes)" << endl;
+    return response.messageIds[0];
+}
+
+// Progressive delivery: the embedded thumbnail of a screenshot goes out
+// first, so a notification arrives after a few KB, and the prepared
+// request then replaces that message with the full image. The caption of
+// the replaced message carries the game name only, like media groups, as
+// editMessageMedia takes it inside the JSON media description. Without a
+// thumbnail or when the preview fails the request is sent unchanged.
+void sendPreviewFirst(std::string_view path, TelegramRequest& request) {
+    int64_t messageId = 0;
+    if (g_pendingPreview.path == path) {
+        messageId = g_pendingPreview.messageId;
+    } else if (!request.preview.empty()) {
+        // Nobody took the preview of the last capture, don't leave it
+        deleteTelegramPreview(std::exchange(g_pendingPreview, {}).messageId);
+        const auto sent = sendTelegramPreview(request);
+        if (!sent.has_value()) {
+            return;
+        }
+        messageId = sent.value();
+        g_pendingPreview = {std::string(path), messageId};
+    } else {
+        return;
+    }
+
+    // Rebuild the form: the file part is named in the media description
+    std::string media = R"({"type":"photo","media":"attach://photo")";
+    if (!request.gameName.empty()) {
+        media += R"(,"caption":)";
+        appendJsonString(media, request.gameName);
+    }
+    media += '}';
+
+    curl_formfree(request.formpost);
+    request.formpost = nullptr;
+    struct curl_httppost* lastptr = nullptr;
+    const fs::path filePath{path};
+    curl_formadd(&request.formpost, &lastptr, CURLFORM_COPYNAME, "photo",
+                 CURLFORM_FILENAME, filePath.c_str(), CURLFORM_STREAM,
+                 &request.ui, CURLFORM_CONTENTSLENGTH, request.ui.sizeLeft,
+                 CURLFORM_CONTENTTYPE, "image/jpeg", CURLFORM_END);
+    curl_formadd(&request.formpost, &lastptr, CURLFORM_COPYNAME, "media",
+                 CURLFORM_COPYCONTENTS, media.c_str(), CURLFORM_END);
+
+    std::string& url = request.url;
+    url = Config::get().getTelegramApiUrl();
+    url += "/bot";
+    url += Config::get().getTelegramBotToken();
+    url += "/editMessageMedia?chat_id=";
+    url += Config::get().getTelegramChatId();
+    url += "&message_id=";
+    url += std::to_string(messageId);
+
+    curl_easy_setopt(request.curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(request.curl, CURLOPT_HTTPPOST, request.formpost);
+    request.previewMessageId = messageId;
+}
+
+// Check the outcome of a performed request and report its digest
+bool finishTelegramRequest(TelegramRequest& request, CURLcode res,
+                           std::string_view path, ContentDigest* digest) {
+    constexpr std::string_view logPrefix = TELEGRAM_LOG_PREFIX;
+    CURL* curl = request.curl;
+    recordTransfer(curl, Destination::Telegram, res);
+
+    if (res != CURLE_OK) {
+        Logger::get().error() << logPrefix << "curl_easy_perform() failed: "
+                              << curl_easy_strerror(res) << endl;
+        return false;
+    }
+
+    long responseCode;
+    double requestSize;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD, &requestSize);
+
+    Logger::get().debug()
+        << logPrefix << requestSize
+        << " bytes sent, response code: " << responseCode << endl;
+    logTransferStats(curl, logPrefix, {&request.ui, 1});
+
+    if (responseCode == 200) {
+        finishDigest(request.ui, digest);
+        Logger::get().info()
+            << logPrefix << "Successfully uploaded " << path << endl;
+        const std::string_view fileId = request.reader.response.fileId.view();
+        if (!fileId.empty()) {
+            Logger::get().debug() << logPrefix << "file_id is " << fileId
+                                  << endl;
+        }
+        if (request.previewMessageId != 0) {
+            g_pendingPreview = {};
+        }
+        if (!copyToOtherChats(request.reader.response)) {
+            Logger::get().warn()
+                << logPrefix << "Not delivered to every chat" << endl;
+        }
+        return true;
+    }
+
+    reportApiError(Destination::Telegram, logPrefix, "Error uploading",
+                   responseCode, request.reader.response);
+    // The preview can't be replaced, e.g. because it was deleted, so a
+    // retry sends the capture as a new message
+    if (request.previewMessageId != 0 && responseCode == 400) {
+        g_pendingPreview = {};
+    }
+    return false;
+}
+
+constexpr std::string_view S3_LOG_PREFIX = "[S3] ";
+// Attempts per multipart part before the whole upload is aborted
+constexpr int S3_PART_ATTEMPTS = 3;
+// Response bytes kept, enough for S3 XML results and errors
+constexpr size_t S3_RESPONSE_LIMIT = 0x1000;  // 4KB
+
+// What an S3 request needs back from its response
+struct S3Response {
+    std::string body;
+    std::string etag;
+};
+
+size_t s3BodyFunction(char* ptr, size_t size, size_t nmemb,
+                      void* data) noexcept {
+    auto* response = static_cast<S3Response*>(data);
+    const size_t bytes = size * nmemb;
+    const size_t room =
+        S3_RESPONSE_LIMIT - std::min(S3_RESPONSE_LIMIT, response->body.size());
+    response->body.append(ptr, std::min(bytes, room));
+    return bytes;
+}
+
+size_t s3HeaderFunction(char* buffer, size_t size, size_t nitems,
+                        void* data) noexcept {
+    auto* response = static_cast<S3Response*>(data);
+    const size_t bytes = size * nitems;
+    std::string_view line(buffer, bytes);
+
+    constexpr std::string_view name = "etag:";
+    if (line.size() > name.size() &&
+        std::ranges::equal(line.substr(0, name.size()), name,
+                           [](char a, char b) {
+                               return std::tolower(
+                                          static_cast<unsigned char>(a)) == b;
+                           })) {
+        line.remove_prefix(name.size());
+        while (!line.empty() && line.front() == ' ') line.remove_prefix(1);
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n' ||
+                                 line.back() == ' ')) {
+            line.remove_suffix(1);
+        }
+        response->etag = line;
+    }
+    return bytes;
+}
+
+// Text between <tag> and </tag> of an XML document, empty if missing
+[[nodiscard]] std::string_view xmlValue(std::string_view xml,
+                                        std::string_view tag) {
+    std::string open = "<";
+    open += tag;
+    open += '>';
+    std::string close = "</";
+    close += tag;
+    close += '>';
+
+    const size_t start = xml.find(open);
+    if (start == std::string_view::npos) return {};
+    const size_t valueStart = start + open.size();
+    const size_t end = xml.find(close, valueStart);
+    if (end == std::string_view::npos) return {};
+    return xml.substr(valueStart, end - valueStart);
+}
+
+// Where an album file is stored: Host header, canonical URI and full URL
+struct S3Target {
+    std::string host;
+    std::string uri;
+    std::string url;
+};
+
+[[nodiscard]] S3Target makeS3Target(std::string_view path) {
+    const std::string_view endpoint = Config::get().getS3Endpoint();
+
+    // http(s)://host[:port][/base], the scheme was checked by the config
+    const size_t hostStart = endpoint.find("://") + 3;
+    const size_t hostEnd = endpoint.find('/', hostStart);
+    const std::string_view host =
+        endpoint.substr(hostStart, hostEnd - hostStart);
+    const std::string_view base = hostEnd == std::string_view::npos
+                                      ? std::string_view{}
+                                      : endpoint.substr(hostEnd);
+
+    // Object key: prefix + YYYY/MM/DD/<file>, keeps the album layout
+    std::string key{Config::get().getS3Prefix()};
+    key += path.starts_with(ALBUM_PATH) ? path.substr(ALBUM_PATH.size())
+                                        : fs::path(path).filename().string();
+
+    S3Target target;
+    target.host = host;
+    target.uri = base;
+    target.uri += '/';
+    target.uri += Config::get().getS3Bucket();
+
+    // Every key segment is URI-encoded, the slashes are kept
+    size_t segmentStart = 0;
+    while (segmentStart <= key.size()) {
+        const size_t segmentEnd = std::min(key.find('/', segmentStart),
+                                           key.size());
+        target.uri += '/';
+        target.uri += url_encode(
+            std::string_view(key).substr(segmentStart,
+                                         segmentEnd - segmentStart));
+        segmentStart = segmentEnd + 1;
+    }
+
+    target.url = endpoint.substr(0, hostEnd);
+    target.url += target.uri;
+    return target;
+}
+
+// One signed S3 request. Owns its handle, headers, response and the file
+// streamed as its body, if any.
+struct S3Request {
+    S3Request() = default;
+    S3Request(const S3Request&) = delete;
+    S3Request& operator=(const S3Request&) = delete;
+
+    ~S3Request() {
+        if (curl != nullptr) curl_easy_cleanup(curl);
+        if (headers != nullptr) curl_slist_free_all(headers);
+        stopReadAhead(ui);
+        if (ui.f != nullptr) std::fclose(ui.f);
+    }
+
+    UploadInfo ui;
+    S3Response response;
+    std::string url;
+    TransferWatchdog watchdog;
+    struct curl_slist* headers{nullptr};
+    CURL* curl{nullptr};
+};
+
+// Sign a request with SigV4 and set everything but its body
+bool prepareS3Request(S3Request& request, std::string_view method,
+                      const S3Target& target, std::string_view query,
+                      std::string_view contentType) {
+    constexpr std::string_view logPrefix = S3_LOG_PREFIX;
+
+    std::string amzDate;
+    if (!sigv4Timestamp(amzDate)) {
+        Logger::get().error()
+            << logPrefix << "Unable to read the system clock" << endl;
+        return false;
+    }
+
+    const SigV4Credentials creds{Config::get().getS3AccessKey(),
+                                 Config::get().getS3SecretKey(),
+                                 Config::get().getS3Region()};
+    const std::string authorization = sigv4Authorization(
+        method, target.host, target.uri, query, amzDate, creds);
+
+    // The signed headers must reach the server exactly as signed
+    std::string header = "Host: ";
+    header += target.host;
+    request.headers = curl_slist_append(request.headers, header.c_str());
+    header = "x-amz-date: ";
+    header += amzDate;
+    request.headers = curl_slist_append(request.headers, header.c_str());
+    header = "x-amz-content-sha256: ";
+    header += SIGV4_UNSIGNED_PAYLOAD;
+    request.headers = curl_slist_append(request.headers, header.c_str());
+    header = "Authorization: ";
+    header += authorization;
+    request.headers = curl_slist_append(request.headers, header.c_str());
+    if (!contentType.empty()) {
+        header = "Content-Type: ";
+        header += contentType;
+        request.headers = curl_slist_append(request.headers, header.c_str());
+    }
+
+    CURL* curl = HttpSession::get().createHandle();
+    if (!curl) {
+        Logger::get().error() << logPrefix << "curl_easy_init() failed" << endl;
+        return false;
+    }
+    request.curl = curl;
+
+    request.url = target.url;
+    if (!query.empty()) {
+        request.url += '?';
+        request.url += query;
+    }
+
+    Logger::get().debug() << logPrefix << method << " " << request.url << endl;
+
+    curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, request.headers);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, s3BodyFunction);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &request.response);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, s3HeaderFunction);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &request.response);
     curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, NX_CURL_BUFFERSIZE);
+    setTransferLimits(curl, request.watchdog, Destination::S3, 0,
+                      TrafficClass::Screenshot);
+    if (method == "DELETE") {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+    }
+    return true;
+}
+
+// Stream `length` bytes of a file, starting at `offset`, as a PUT body
+bool setS3FileBody(S3Request& request, std::string_view path, size_t offset,
+                   size_t length, TrafficClass cls) {
+    FILE* f = std::fopen(std::string(path).c_str(), "rb");
+    if (f == nullptr) {
+        Logger::get().error() << S3_LOG_PREFIX << "fopen() failed" << endl;
+        return false;
+    }
+    request.ui = UploadInfo{f, length, cls};
+    if (std::fseek(f, static_cast<long>(offset), SEEK_SET) != 0) {
+        Logger::get().error() << S3_LOG_PREFIX << "fseek() failed" << endl;
+        return false;
+    }
+
+    CURL* curl = request.curl;
+    curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, uploadReadFunction);
+    curl_easy_setopt(curl, CURLOPT_READDATA, &request.ui);
+    curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE,
+                     static_cast<curl_off_t>(length));
     curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE,
                      NX_CURL_UPLOAD_BUFFERSIZE);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, NX_CURL_TIMEOUT);
+    setTransferLimits(curl, request.watchdog, Destination::S3, length, cls);
+    return true;
+}
 
-    const CURLcode res = curl_easy_perform(curl);
-    std::fclose(f);
+// Send a small in-memory POST body, the data must outlive the request
+void setS3PostBody(S3Request& request, std::string_view body) {
+    curl_easy_setopt(request.curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(request.curl, CURLOPT_POSTFIELDS, body.data());
+    curl_easy_setopt(request.curl, CURLOPT_POSTFIELDSIZE,
+                     static_cast<long>(body.size()));
+}
 
-    if (res == CURLE_OK) {
-        long responseCode;
-        double requestSize;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
-        curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD, &requestSize);
+// S3 may report errors with a 200 response, so the body is checked too
+bool s3Succeeded(const S3Request& request, CURLcode res,
+                 std::string_view what) {
+    constexpr std::string_view logPrefix = S3_LOG_PREFIX;
+    recordTransfer(request.curl, Destination::S3, res);
 
-        Logger::get().debug()
-            << logPrefix << requestSize
-            << " bytes sent, response code: " << responseCode << endl;
+    if (res != CURLE_OK) {
+        Logger::get().error() << logPrefix << what
+                              << ": curl_easy_perform() failed: "
+                              << curl_easy_strerror(res) << endl;
+        return false;
+    }
+
+    long responseCode;
+    curl_easy_getinfo(request.curl, CURLINFO_RESPONSE_CODE, &responseCode);
+    const std::string_view body = request.response.body;
+    if ((responseCode == 200 || responseCode == 204) &&
+        body.find("<Error>") == std::string_view::npos) {
+        return true;
+    }
+
+    Logger::get().error() << logPrefix << what << ": got response code "
+                          << responseCode << " "
+                          << xmlValue(body, "Code") << " "
+                          << xmlValue(body, "Message") << endl;
+    return false;
+}
+
+// Upload a file as parts of up to `partSize` bytes, running up to
+// HttpSession::MAX_STREAMS parts at once. Failed parts are retried on their
+// own; the upload is aborted when a part runs out of attempts.
+bool uploadS3Multipart(std::string_view path, size_t size, size_t partSize,
+                       const S3Target& target, std::string_view contentType,
+                       TrafficClass cls) {
+    constexpr std::string_view logPrefix = S3_LOG_PREFIX;
+    constexpr size_t parallelParts =
+        static_cast<size_t>(HttpSession::MAX_STREAMS);
+
+    std::string uploadId;
+    {
+        S3Request initiate;
+        if (!prepareS3Request(initiate, "POST", target, "uploads=",
+                              contentType)) {
+            return false;
+        }
+        setS3PostBody(initiate, "");
+        const CURLcode res = HttpSession::get().perform(initiate.curl);
+        if (!s3Succeeded(initiate, res, "Initiate multipart upload")) {
+            return false;
+        }
+        uploadId = xmlValue(initiate.response.body, "UploadId");
+    }
+    if (uploadId.empty()) {
+        Logger::get().error() << logPrefix << "No UploadId returned" << endl;
+        return false;
+    }
+    const std::string uploadIdQuery = "uploadId=" + url_encode(uploadId);
+
+    const size_t partCount = (size + partSize - 1) / partSize;
+    std::vector<std::string> etags(partCount);
+    std::vector<int> attempts(partCount, 0);
+    size_t completed = 0;
+    bool failed = false;
+
+    while (completed < partCount && !failed) {
+        std::array<S3Request, parallelParts> requests;
+        std::array<CURL*, parallelParts> handles{};
+        std::array<size_t, parallelParts> parts{};
+        size_t active = 0;
+
+        for (size_t i = 0; i < partCount && active < parallelParts; ++i) {
+            if (!etags[i].empty()) continue;
+            if (attempts[i]++ == S3_PART_ATTEMPTS) {
+                failed = true;
+                break;
+            }
+
+            // Query parameters in canonical (sorted) order
+            const std::string query = "partNumber=" + std::to_string(i + 1) +
+                                      "&" + uploadIdQuery;
+            const size_t offset = i * partSize;
+            if (!prepareS3Request(requests[active], "PUT", target, query,
+                                  {}) ||
+                !setS3FileBody(requests[active], path, offset,
+                               std::min(partSize, size - offset), cls)) {
+                failed = true;
+                break;
+            }
+            handles[active] = requests[active].curl;
+            parts[active] = i;
+            ++active;
+        }
+        if (failed || active == 0) break;
+
+        std::array<CURLcode, parallelParts> results{};
+        HttpSession::get().performAll(std::span(handles).first(active),
+                                      std::span(results).first(active));
+
+        for (size_t j = 0; j < active; ++j) {
+            const size_t part = parts[j];
+            const std::string what = "Part " + std::to_string(part + 1) +
+                                     "/" + std::to_string(partCount);
+            if (s3Succeeded(requests[j], results[j], what) &&
+                !requests[j].response.etag.empty()) {
+                etags[part] = std::move(requests[j].response.etag);
+                ++completed;
+                Logger::get().debug() << logPrefix << what << " uploaded"
+                                      << endl;
+            } else {
+                Logger::get().warn()
+                    << logPrefix << what << " failed (attempt "
+                    << attempts[part] << "/" << S3_PART_ATTEMPTS << ")"
+                    << endl;
+            }
+        }
+    }
 
-        curl_easy_cleanup(curl);
-        curl_formfree(formpost);
+    if (!failed) {
+        std::string xml = "<CompleteMultipartUpload>";
+        for (size_t i = 0; i < partCount; ++i) {
+            xml += "<Part><PartNumber>";
+            xml += std::to_string(i + 1);
+            xml += "</PartNumber><ETag>";
+            xml += etags[i];
+            xml += "</ETag></Part>";
+        }
+        xml += "</CompleteMultipartUpload>";
+
+        S3Request complete;
+        if (prepareS3Request(complete, "POST", target, uploadIdQuery,
+                             "application/xml")) {
+            setS3PostBody(complete, xml);
+            const CURLcode res = HttpSession::get().perform(complete.curl);
+            if (s3Succeeded(complete, res, "Complete multipart upload")) {
+                return true;
+            }
+        }
+    }
 
-        if (responseCode == 200) {
-            Logger::get().info()
-                << logPrefix << "Successfully uploaded " << path << endl;
-            return true;
+    // Free the stored parts, a later retry starts from scratch
+    S3Request abort;
+    if (prepareS3Request(abort, "DELETE", target, uploadIdQuery, {})) {
+        const CURLcode res = HttpSession::get().perform(abort.curl);
+        if (!s3Succeeded(abort, res, "Abort multipart upload")) {
+            Logger::get().warn() << logPrefix << "Parts of " << path
+                                 << " may be left in the bucket" << endl;
         }
+    }
+    return false;
+}
 
-        Logger::get().error()
-            << logPrefix << "Error uploading, got response code "
-            << responseCode << endl;
+}  // namespace
+
+bool sendFileToTelegram(std::string_view path, size_t size, bool compression,
+                        ContentDigest* digest) {
+    std::string_view tid;
+    bool isMovie;
+    const auto validationResult = validateTelegramFile(path, tid, isMovie);
+    if (validationResult == ValidationResult::Error) {
         return false;
-    } else {
-        Logger::get().error() << logPrefix << "curl_easy_perform() failed: "
-                              << curl_easy_strerror(res) << endl;
-        curl_easy_cleanup(curl);
-        curl_formfree(formpost);
+    }
+    if (validationResult == ValidationResult::Skip) {
+        return true;  // Not an error, just skipping per config
+    }
+    // Before any file access, a skipped attempt costs nothing
+    if (!CircuitBreaker::get().allows(Destination::Telegram)) {
+        return false;
+    }
+    TelegramRequest request;
+    if (!prepareTelegramRequest(path, size, compression, tid, isMovie,
+                                request)) {
         return false;
     }
+    sendPreviewFirst(path, request);
+
+    const CURLcode res = HttpSession::get().perform(request.curl);
+    return finishTelegramRequest(request, res, path, digest);
+}
+
+TelegramBothResult sendFileToTelegramBoth(std::string_view path, size_t size,
+                                          ContentDigest* digest) {
+    std::string_view tid;
+    bool isMovie;
+    const auto validationResult = validateTelegramFile(path, tid, isMovie);
+    if (validationResult == ValidationResult::Skip) {
+        return {true, true};  // Not an error, just skipping per config
+    }
+    if (validationResult == ValidationResult::Error ||
+        !CircuitBreaker::get().allows(Destination::Telegram)) {
+        return {false, false};
+    }
+    std::array<TelegramRequest, 2> requests;
+    if (!prepareTelegramRequest(path, size, true, tid, isMovie,
+                                requests[0]) ||
+        !prepareTelegramRequest(path, size, false, tid, isMovie,
+                                requests[1])) {
+        return {false, false};
+    }
+    sendPreviewFirst(path, requests[0]);
+
+    // Both copies travel together, multiplexed over one connection when
+    // the server speaks HTTP/2
+    const std::array<CURL*, 2> handles{requests[0].curl, requests[1].curl};
+    std::array<CURLcode, 2> results{};
+    HttpSession::get().performAll(handles, results);
+
+    // Both copies stream the same bytes, the first delivered digest counts
+    TelegramBothResult result;
+    result.compressed =
+        finishTelegramRequest(requests[0], results[0], path, digest);
+    result.original = finishTelegramRequest(
+        requests[1], results[1], path, result.compressed ? nullptr : digest);
+    return result;
+}
+
+int64_t takeTelegramPreview(std::string_view path) {
+    if (g_pendingPreview.path != path) {
+        return 0;
+    }
+    const int64_t messageId = g_pendingPreview.messageId;
+    g_pendingPreview = {};
+    return messageId;
+}
+
+void restoreTelegramPreview(std::string_view path, int64_t messageId) {
+    g_pendingPreview = {std::string(path), messageId};
+}
+
+void deleteTelegramPreview(int64_t messageId) {
+    const auto chatIds = Config::get().getTelegramChatIds();
+    if (messageId == 0 || chatIds.empty()) {
+        return;
+    }
+    std::string url{Config::get().getTelegramApiUrl()};
+    url += "/bot";
+    url += Config::get().getTelegramBotToken();
+    url += "/deleteMessage?chat_id=";
+    url += chatIds.front();
+    url += "&message_id=";
+    url += std::to_string(messageId);
+    if (sendDeliveryRequest(Destination::Telegram, url, {}, nullptr,
+                            chatIds.front())) {
+        Logger::get().info() << TELEGRAM_LOG_PREFIX << "Deleted preview "
+                             << messageId << endl;
+    }
 }
 
-bool sendFileToNtfy(std::string_view path, size_t size) {
+bool sendFileToNtfy(std::string_view path, size_t size,
+                    ContentDigest* digest) {
     constexpr std::string_view logPrefix = "[ntfy] ";
     std::string_view tid;
     bool isMovie;
@@ -220,6 +1693,9 @@ bool sendFileToNtfy(std::string_view path, size_t size) {
     if (validationResult == ValidationResult::Skip) {
         return true;  // Not an error, just skipping per config
     }
+    if (!CircuitBreaker::get().allows(Destination::Ntfy)) {
+        return false;
+    }
 
     const fs::path filePath{path};
     const std::string filename = filePath.filename().string();
@@ -230,9 +1706,9 @@ bool sendFileToNtfy(std::string_view path, size_t size) {
         return false;
     }
 
-    UploadInfo ui{f, size};
+    UploadInfo ui{f, size, trafficClassOf(isMovie)};
 
-    CURL* curl = curl_easy_init();
+    CURL* curl = HttpSession::get().createHandle();
     if (!curl) {
         std::fclose(f);
         Logger::get().error() << logPrefix << "curl_easy_init() failed" << endl;
@@ -279,24 +1755,49 @@ bool sendFileToNtfy(std::string_view path, size_t size) {
         headers = curl_slist_append(headers, priorityHeader.c_str());
     }
 
+    const std::string gameName = TitleIndex::get().lookup(tid);
     std::string titleHeader = "Title: Screenshot from ";
-    titleHeader += tid;
+    if (gameName.empty()) {
+        titleHeader += tid;
+    } else {
+        titleHeader += gameName;
+    }
     headers = curl_slist_append(headers, titleHeader.c_str());
 
+    if (Config::get().sendDigest()) {
+        headers = curl_slist_append(headers, "Transfer-Encoding: chunked");
+        headers = curl_slist_append(headers, "Trailer: X-Content-SHA256");
+    }
+
     // Configure CURL for PUT upload
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
     curl_easy_setopt(curl, CURLOPT_READFUNCTION, uploadReadFunction);
     curl_easy_setopt(curl, CURLOPT_READDATA, &ui);
-    curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE,
-                     static_cast<curl_off_t>(size));
+    if (Config::get().sendDigest()) {
+        // Chunked upload so the digest can follow the body as a trailer.
+        // HTTP/2 has no chunked encoding and curl sends no trailers over
+        // it, so this transfer stays on HTTP/1.1.
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+        curl_easy_setopt(curl, CURLOPT_TRAILERFUNCTION, digestTrailerFunction);
+        curl_easy_setopt(curl, CURLOPT_TRAILERDATA, &ui);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE,
+                         static_cast<curl_off_t>(size));
+    }
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
     curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, NX_CURL_BUFFERSIZE);
     curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE,
                      NX_CURL_UPLOAD_BUFFERSIZE);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, NX_CURL_TIMEOUT);
-
-    const CURLcode res = curl_easy_perform(curl);
+    TransferWatchdog watchdog;
+    setTransferLimits(curl, watchdog, Destination::Ntfy, size,
+                      ui.trafficClass);
+    ApiResponseReader reader;
+    readApiResponse(curl, reader);
+
+    const CURLcode res = HttpSession::get().perform(curl);
+    recordTransfer(curl, Destination::Ntfy, res);
+    stopReadAhead(ui);
     std::fclose(f);
 
     if (res == CURLE_OK) {
@@ -308,19 +1809,20 @@ bool sendFileToNtfy(std::string_view path, size_t size) {
         Logger::get().debug()
             << logPrefix << requestSize
             << " bytes sent, response code: " << responseCode << endl;
+        logTransferStats(curl, logPrefix, {&ui, 1});
 
         curl_slist_free_all(headers);
         curl_easy_cleanup(curl);
 
         if (responseCode == 200) {
+            finishDigest(ui, digest);
             Logger::get().info()
                 << logPrefix << "Successfully uploaded " << path << endl;
             return true;
         }
 
-        Logger::get().error()
-            << logPrefix << "Error uploading, got response code "
-            << responseCode << endl;
+        reportApiError(Destination::Ntfy, logPrefix, "Error uploading",
+                       responseCode, reader.response);
         return false;
     } else {
         Logger::get().error() << logPrefix << "curl_easy_perform() failed: "
@@ -331,7 +1833,8 @@ bool sendFileToNtfy(std::string_view path, size_t size) {
     }
 }
 
-bool sendFileToDiscord(std::string_view path, size_t size) {
+bool sendFileToDiscord(std::string_view path, size_t size,
+                       ContentDigest* digest) {
     constexpr std::string_view logPrefix = "[Discord] ";
     std::string_view tid;
     bool isMovie;
@@ -347,6 +1850,9 @@ bool sendFileToDiscord(std::string_view path, size_t size) {
     if (validationResult == ValidationResult::Skip) {
         return true;  // Not an error, just skipping per config
     }
+    if (!CircuitBreaker::get().allows(Destination::Discord)) {
+        return false;
+    }
 
     const fs::path filePath{path};
     const std::string filename = filePath.filename().string();
@@ -357,7 +1863,9 @@ bool sendFileToDiscord(std::string_view path, size_t size) {
         return false;
     }
 
-    UploadInfo ui{f, size};
+    const std::string gameName = TitleIndex::get().lookup(tid);
+    UploadInfo ui{f, size, trafficClassOf(isMovie)};
+    UploadInfo captionField = makeDigestField(ui, gameName);
     struct curl_httppost* formpost = nullptr;
     struct curl_httppost* lastptr = nullptr;
 
@@ -368,7 +1876,10 @@ bool sendFileToDiscord(std::string_view path, size_t size) {
                  CURLFORM_CONTENTSLENGTH, size,
                  CURLFORM_END);
 
-    CURL* curl = curl_easy_init();
+    // The message content follows the file part so its digest is known
+    addCaptionField(&formpost, &lastptr, "content", captionField);
+
+    CURL* curl = HttpSession::get().createHandle();
     if (!curl) {
         std::fclose(f);
         curl_formfree(formpost);
@@ -408,9 +1919,15 @@ bool sendFileToDiscord(std::string_view path, size_t size) {
     curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, NX_CURL_BUFFERSIZE);
     curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE,
                      NX_CURL_UPLOAD_BUFFERSIZE);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, NX_CURL_TIMEOUT);
-
-    const CURLcode res = curl_easy_perform(curl);
+    TransferWatchdog watchdog;
+    setTransferLimits(curl, watchdog, Destination::Discord, size,
+                      ui.trafficClass);
+    ApiResponseReader reader;
+    readApiResponse(curl, reader);
+
+    const CURLcode res = HttpSession::get().perform(curl);
+    recordTransfer(curl, Destination::Discord, res);
+    stopReadAhead(ui);
     std::fclose(f);
 
     if (res == CURLE_OK) {
@@ -422,20 +1939,375 @@ bool sendFileToDiscord(std::string_view path, size_t size) {
         Logger::get().debug()
             << logPrefix << requestSize
             << " bytes sent, response code: " << responseCode << endl;
+        logTransferStats(curl, logPrefix, {&ui, 1});
 
         curl_easy_cleanup(curl);
         curl_formfree(formpost);
         curl_slist_free_all(headers);
 
         if (responseCode == 200 || responseCode == 201) {
+            finishDigest(ui, digest);
             Logger::get().info()
                 << logPrefix << "Successfully uploaded " << path << endl;
+            if (!forwardToOtherChannels(reader.response)) {
+                Logger::get().warn()
+                    << logPrefix << "Not delivered to every channel" << endl;
+            }
             return true;
         }
 
-        Logger::get().error()
-            << logPrefix << "Error uploading, got response code "
-            << responseCode << endl;
+        reportApiError(Destination::Discord, logPrefix, "Error uploading",
+                       responseCode, reader.response);
+        return false;
+    } else {
+        Logger::get().error() << logPrefix << "curl_easy_perform() failed: "
+                              << curl_easy_strerror(res) << endl;
+        curl_easy_cleanup(curl);
+        curl_formfree(formpost);
+        curl_slist_free_all(headers);
+        return false;
+    }
+}
+
+bool sendFileToS3(std::string_view path, size_t size, ContentDigest* digest) {
+    constexpr std::string_view logPrefix = S3_LOG_PREFIX;
+    std::string_view tid;
+    bool isMovie;
+
+    // Validate file and check if upload is needed
+    const auto validationResult = validateUploadFile(
+        path, logPrefix, tid, isMovie, Config::get().s3UploadScreenshots(),
+        Config::get().s3UploadMovies());
+    if (validationResult == ValidationResult::Error) {
+        return false;
+    }
+    if (validationResult == ValidationResult::Skip) {
+        return true;  // Not an error, just skipping per config
+    }
+    if (!CircuitBreaker::get().allows(Destination::S3)) {
+        return false;
+    }
+
+    const S3Target target = makeS3Target(path);
+    const auto fileTypeInfo =
+        getFileTypeInfo(fs::path(path).extension().string(), false);
+    const TrafficClass cls = trafficClassOf(isMovie);
+    const size_t partSize =
+        static_cast<size_t>(Config::get().getS3PartSizeMb()) << 20;
+
+    if (size > partSize) {
+        // Parts finish out of order, so no streamed digest is available
+        const bool uploaded = uploadS3Multipart(
+            path, size, partSize, target, fileTypeInfo.contentType, cls);
+        if (uploaded) {
+            Logger::get().info()
+                << logPrefix << "Successfully uploaded " << path << " in "
+                << (size + partSize - 1) / partSize << " parts" << endl;
+        }
+        return uploaded;
+    }
+
+    S3Request request;
+    if (!prepareS3Request(request, "PUT", target, {},
+                          fileTypeInfo.contentType) ||
+        !setS3FileBody(request, path, 0, size, cls)) {
+        return false;
+    }
+
+    const CURLcode res = HttpSession::get().perform(request.curl);
+    if (!s3Succeeded(request, res, "Upload")) {
+        return false;
+    }
+    logTransferStats(request.curl, logPrefix, {&request.ui, 1});
+
+    finishDigest(request.ui, digest);
+    Logger::get().info() << logPrefix << "Successfully uploaded " << path
+                         << " (ETag " << request.response.etag << ")" << endl;
+    return true;
+}
+
+bool sendFilesToTelegram(std::span<const UploadFile> files, bool compression,
+                         std::span<ContentDigest> digests) {
+    constexpr std::string_view logPrefix = "[Telegram] ";
+
+    if (files.size() == 1) {
+        return sendFileToTelegram(files[0].path, files[0].size, compression,
+                                  digests.empty() ? nullptr : &digests[0]);
+    }
+
+    // Before any file access, a skipped attempt costs nothing. A single
+    // file is sent on its own, which asks the circuit itself.
+    if (countAccepted(files, Config::get().telegramUploadScreenshots(),
+                      Config::get().telegramUploadMovies()) > 1 &&
+        !CircuitBreaker::get().allows(Destination::Telegram)) {
+        return false;
+    }
+
+    std::array<UploadInfo, MAX_BATCH_SIZE> infos;
+    std::array<size_t, MAX_BATCH_SIZE> accepted;
+    const int count = openBatchFiles(
+        files, logPrefix, Config::get().telegramUploadScreenshots(),
+        Config::get().telegramUploadMovies(), infos, accepted);
+    if (count < 0) {
+        return false;
+    }
+    if (count == 0) {
+        return true;  // Not an error, just skipping per config
+    }
+    if (count == 1) {
+        closeBatchFiles(infos, count);
+        const size_t index = accepted[0];
+        return sendFileToTelegram(
+            files[index].path, files[index].size, compression,
+            index < digests.size() ? &digests[index] : nullptr);
+    }
+
+    // Media group entries reference the multipart parts by name
+    std::string media = "[";
+    struct curl_httppost* formpost = nullptr;
+    struct curl_httppost* lastptr = nullptr;
+    size_t totalSize = 0;
+
+    for (int i = 0; i < count; ++i) {
+        const UploadFile& file = files[accepted[i]];
+        const fs::path filePath{file.path};
+        const auto fileTypeInfo =
+            getFileTypeInfo(filePath.extension().string(), compression);
+        const std::string partName = "file" + std::to_string(i);
+
+        if (i > 0) media += ",";
+        media += "{\"type\":\"";
+        media += fileTypeInfo.copyName;
+        media += "\",\"media\":\"attach://";
+        media += partName;
+        media += "\"";
+        const std::string gameName =
+            TitleIndex::get().lookup(albumTitleId(file.path));
+        if (!gameName.empty()) {
+            media += ",\"caption\":";
+            appendJsonString(media, gameName);
+        }
+        media += "}";
+
+        curl_formadd(&formpost, &lastptr, CURLFORM_COPYNAME, partName.c_str(),
+                     CURLFORM_FILENAME, filePath.filename().string().c_str(),
+                     CURLFORM_STREAM, &infos[i], CURLFORM_CONTENTSLENGTH,
+                     file.size, CURLFORM_CONTENTTYPE,
+                     fileTypeInfo.contentType.data(), CURLFORM_END);
+        totalSize += file.size;
+    }
+    media += "]";
+
+    curl_formadd(&formpost, &lastptr, CURLFORM_COPYNAME, "media",
+                 CURLFORM_COPYCONTENTS, media.c_str(), CURLFORM_END);
+
+    CURL* curl = HttpSession::get().createHandle();
+    if (!curl) {
+        closeBatchFiles(infos, count);
+        curl_formfree(formpost);
+        Logger::get().error() << logPrefix << "curl_easy_init() failed" << endl;
+        return false;
+    }
+
+    // Build URL
+    const auto apiUrl = Config::get().getTelegramApiUrl();
+    const auto botToken = Config::get().getTelegramBotToken();
+    const auto chatId = Config::get().getTelegramChatId();
+
+    std::string url;
+    url.reserve(apiUrl.size() + botToken.size() + chatId.size() + 35);
+    url = apiUrl;
+    url += "/bot";
+    url += botToken;
+    url += "/sendMediaGroup?chat_id=";
+    url += chatId;
+
+    Logger::get().debug() << logPrefix << "URL is " << url << endl;
+
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, uploadReadFunction);
+    curl_easy_setopt(curl, CURLOPT_HTTPPOST, formpost);
+    curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, NX_CURL_BUFFERSIZE);
+    curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE,
+                     NX_CURL_UPLOAD_BUFFERSIZE);
+    TransferWatchdog watchdog;
+    setTransferLimits(curl, watchdog, Destination::Telegram, totalSize,
+                      TrafficClass::Screenshot);
+    ApiResponseReader reader;
+    readApiResponse(curl, reader);
+
+    const CURLcode res = HttpSession::get().perform(curl);
+    recordTransfer(curl, Destination::Telegram, res);
+    closeBatchFiles(infos, count);
+
+    if (res == CURLE_OK) {
+        long responseCode;
+        double requestSize;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+        curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD, &requestSize);
+
+        Logger::get().debug()
+            << logPrefix << requestSize
+            << " bytes sent, response code: " << responseCode << endl;
+        logTransferStats(curl, logPrefix, std::span(infos).first(count));
+
+        curl_easy_cleanup(curl);
+        curl_formfree(formpost);
+
+        if (responseCode == 200) {
+            finishBatchDigests(infos, accepted, count, digests);
+            Logger::get().info() << logPrefix << "Successfully uploaded "
+                                 << count << " files as a media group" << endl;
+            if (!copyToOtherChats(reader.response)) {
+                Logger::get().warn()
+                    << logPrefix << "Not delivered to every chat" << endl;
+            }
+            return true;
+        }
+
+        reportApiError(Destination::Telegram, logPrefix, "Error uploading",
+                       responseCode, reader.response);
+        return false;
+    } else {
+        Logger::get().error() << logPrefix << "curl_easy_perform() failed: "
+                              << curl_easy_strerror(res) << endl;
+        curl_easy_cleanup(curl);
+        curl_formfree(formpost);
+        return false;
+    }
+}
+
+bool sendFilesToDiscord(std::span<const UploadFile> files,
+                        std::span<ContentDigest> digests) {
+    constexpr std::string_view logPrefix = "[Discord] ";
+
+    if (files.size() == 1) {
+        return sendFileToDiscord(files[0].path, files[0].size,
+                                 digests.empty() ? nullptr : &digests[0]);
+    }
+
+    // Before any file access, a skipped attempt costs nothing. A single
+    // file is sent on its own, which asks the circuit itself.
+    if (countAccepted(files, Config::get().discordUploadScreenshots(),
+                      Config::get().discordUploadMovies()) > 1 &&
+        !CircuitBreaker::get().allows(Destination::Discord)) {
+        return false;
+    }
+
+    std::array<UploadInfo, MAX_BATCH_SIZE> infos;
+    std::array<size_t, MAX_BATCH_SIZE> accepted;
+    const int count = openBatchFiles(
+        files, logPrefix, Config::get().discordUploadScreenshots(),
+        Config::get().discordUploadMovies(), infos, accepted);
+    if (count < 0) {
+        return false;
+    }
+    if (count == 0) {
+        return true;  // Not an error, just skipping per config
+    }
+
+    struct curl_httppost* formpost = nullptr;
+    struct curl_httppost* lastptr = nullptr;
+    size_t totalSize = 0;
+
+    for (int i = 0; i < count; ++i) {
+        const UploadFile& file = files[accepted[i]];
+        const fs::path filePath{file.path};
+        const std::string partName = "files[" + std::to_string(i) + "]";
+
+        curl_formadd(&formpost, &lastptr,
+                     CURLFORM_COPYNAME, partName.c_str(),
+                     CURLFORM_FILENAME, filePath.filename().string().c_str(),
+                     CURLFORM_STREAM, &infos[i],
+                     CURLFORM_CONTENTSLENGTH, file.size,
+                     CURLFORM_END);
+        totalSize += file.size;
+    }
+
+    // One message, so it carries the game of the first capture
+    const std::string gameName =
+        TitleIndex::get().lookup(albumTitleId(files[accepted[0]].path));
+    if (!gameName.empty()) {
+        curl_formadd(&formpost, &lastptr, CURLFORM_COPYNAME, "content",
+                     CURLFORM_COPYCONTENTS, gameName.c_str(), CURLFORM_END);
+    }
+
+    CURL* curl = HttpSession::get().createHandle();
+    if (!curl) {
+        closeBatchFiles(infos, count);
+        curl_formfree(formpost);
+        Logger::get().error() << logPrefix << "curl_easy_init() failed" << endl;
+        return false;
+    }
+
+    // Build URL
+    const auto apiUrl = Config::get().getDiscordApiUrl();
+    const auto botToken = Config::get().getDiscordBotToken();
+    const auto channelId = Config::get().getDiscordChannelId();
+
+    std::string url;
+    url.reserve(apiUrl.size() + channelId.size() + 20);
+    url = apiUrl;
+    url += "/channels/";
+    url += channelId;
+    url += "/messages";
+
+    Logger::get().debug() << logPrefix << "URL is " << url << endl;
+
+    // Build headers
+    struct curl_slist* headers = nullptr;
+
+    std::string authHeader = "Authorization: Bot ";
+    authHeader += botToken;
+    headers = curl_slist_append(headers, authHeader.c_str());
+
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, uploadReadFunction);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_HTTPPOST, formpost);
+    curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, NX_CURL_BUFFERSIZE);
+    curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE,
+                     NX_CURL_UPLOAD_BUFFERSIZE);
+    TransferWatchdog watchdog;
+    setTransferLimits(curl, watchdog, Destination::Discord, totalSize,
+                      TrafficClass::Screenshot);
+    ApiResponseReader reader;
+    readApiResponse(curl, reader);
+
+    const CURLcode res = HttpSession::get().perform(curl);
+    recordTransfer(curl, Destination::Discord, res);
+    closeBatchFiles(infos, count);
+
+    if (res == CURLE_OK) {
+        long responseCode;
+        double requestSize;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+        curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD, &requestSize);
+
+        Logger::get().debug()
+            << logPrefix << requestSize
+            << " bytes sent, response code: " << responseCode << endl;
+        logTransferStats(curl, logPrefix, std::span(infos).first(count));
+
+        curl_easy_cleanup(curl);
+        curl_formfree(formpost);
+        curl_slist_free_all(headers);
+
+        if (responseCode == 200 || responseCode == 201) {
+            finishBatchDigests(infos, accepted, count, digests);
+            Logger::get().info() << logPrefix << "Successfully uploaded "
+                                 << count << " files in one message" << endl;
+            if (!forwardToOtherChannels(reader.response)) {
+                Logger::get().warn()
+                    << logPrefix << "Not delivered to every channel" << endl;
+            }
+            return true;
+        }
+
+        reportApiError(Destination::Discord, logPrefix, "Error uploading",
+                       responseCode, reader.response);
         return false;
     } else {
         Logger::get().error() << logPrefix << "curl_easy_perform() failed: "
@@ -447,6 +2319,15 @@ bool sendFileToDiscord(std::string_view path, size_t size) {
     }
 }
 
+bool deliverToRecipient(Destination dest, std::string_view recipient,
+                        std::string_view origin, std::string_view messageIds,
+                        std::string_view attachmentUrl) {
+    if (!CircuitBreaker::get().allows(dest)) {
+        return false;
+    }
+    return deliver(dest, recipient, origin, messageIds, attachmentUrl);
+}
+
 // Legacy wrapper for backward compatibility
 bool sendFileToServer(std::string_view path, size_t size, bool compression) {
     return sendFileToTelegram(path, size, compression);
@@ -1,16 +1,116 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <span>
 #include <string_view>
 
+// Maximum number of files grouped into one request (Telegram media groups
+// and Discord attachments are both capped at 10)
+constexpr size_t MAX_BATCH_SIZE = 10;
+
+// Content digest computed while a file is streamed. Only valid when the
+// whole file was read and the upload succeeded.
+struct ContentDigest {
+    uint32_t crc32c{0};
+    std::array<uint8_t, 32> sha256{};
+    bool valid{false};
+};
+
+// A file taking part in a batched upload
+struct UploadFile {
+    std::string_view path;
+    size_t size;
+};
+
+// Upload destinations, in the order they are tried
+enum class Destination : uint8_t {
+    Telegram = 0,
+    Ntfy = 1,
+    Discord = 2,
+    S3 = 3,
+};
+constexpr size_t DESTINATION_COUNT = 4;
+
+[[nodiscard]] constexpr std::string_view destinationName(
+    Destination dest) noexcept {
+    switch (dest) {
+        case Destination::Telegram:
+            return "Telegram";
+        case Destination::Ntfy:
+            return "ntfy";
+        case Destination::Discord:
+            return "Discord";
+        case Destination::S3:
+            return "S3";
+    }
+    return "";
+}
+
+// Whether an album path refers to a movie (.mp4) rather than a screenshot
+[[nodiscard]] constexpr bool isMovieFile(std::string_view path) noexcept {
+    return !path.empty() && path.back() == '4';
+}
+
 // Send file to Telegram with optional compression
 [[nodiscard]] bool sendFileToTelegram(std::string_view path, size_t size,
-                                      bool compression);
+                                      bool compression,
+                                      ContentDigest* digest = nullptr);
+
+// Delivery of the two copies sent in Telegram "both" mode
+struct TelegramBothResult {
+    bool compressed{false};
+    bool original{false};
+};
+
+// Send file to Telegram compressed and as the original at the same time,
+// multiplexed over one connection when possible
+[[nodiscard]] TelegramBothResult sendFileToTelegramBoth(
+    std::string_view path, size_t size, ContentDigest* digest = nullptr);
+
+// The preview a screenshot's upload left behind in the first chat, 0 for
+// none. Taking it forgets it, so a spooled capture carries its own.
+[[nodiscard]] int64_t takeTelegramPreview(std::string_view path);
+
+// Let the next upload of `path` replace the preview `messageId` instead of
+// sending another one
+void restoreTelegramPreview(std::string_view path, int64_t messageId);
+
+// Delete the preview of a capture that won't be uploaded anymore
+void deleteTelegramPreview(int64_t messageId);
 
 // Send file to ntfy.sh (always original, no compression)
-[[nodiscard]] bool sendFileToNtfy(std::string_view path, size_t size);
+[[nodiscard]] bool sendFileToNtfy(std::string_view path, size_t size,
+                                  ContentDigest* digest = nullptr);
 
 // Send file to Discord (always original, no compression)
-[[nodiscard]] bool sendFileToDiscord(std::string_view path, size_t size);
+[[nodiscard]] bool sendFileToDiscord(std::string_view path, size_t size,
+                                     ContentDigest* digest = nullptr);
+
+// Store file in an S3-compatible bucket, large files as a multipart upload
+// Digests are only filled for files sent in a single request
+[[nodiscard]] bool sendFileToS3(std::string_view path, size_t size,
+                                ContentDigest* digest = nullptr);
+
+// Send several screenshots to Telegram as one media group
+// Digests, when given, are filled per entry of `files`
+[[nodiscard]] bool sendFilesToTelegram(std::span<const UploadFile> files,
+                                       bool compression,
+                                       std::span<ContentDigest> digests = {});
+
+// Send several screenshots to Discord as one message with multiple files
+[[nodiscard]] bool sendFilesToDiscord(std::span<const UploadFile> files,
+                                      std::span<ContentDigest> digests = {});
+
+// Copy or forward messages already in the first Telegram chat or Discord
+// channel `origin` to `recipient`, for a delivery spooled after it failed.
+// `messageIds` is comma separated. A refused Discord forward posts
+// `attachmentUrl` instead, when given.
+[[nodiscard]] bool deliverToRecipient(Destination dest,
+                                      std::string_view recipient,
+                                      std::string_view origin,
+                                      std::string_view messageIds,
+                                      std::string_view attachmentUrl = {});
 
 // Legacy alias for backward compatibility
 [[nodiscard]] bool sendFileToServer(std::string_view path, size_t size,
@@ -0,0 +1,87 @@
+#include "upload_queue.hpp"
+
+#include <algorithm>
+
+#include "clock.hpp"
+
+namespace {
+// Priority costs in milliseconds of waiting time, lower score is served first.
+// A movie waits as if it had been queued 30s later than a screenshot, plus
+// 2s per MB; each millisecond spent in the queue earns one point back.
+constexpr s64 MOVIE_PENALTY_MS = 30'000;
+constexpr s64 SIZE_PENALTY_MS_PER_MB = 2'000;
+
+[[nodiscard]] s64 priorityScore(const CaptureItem& item, u64 now) noexcept {
+    const s64 sizePenalty = static_cast<s64>(item.size >> 20) *
+                            SIZE_PENALTY_MS_PER_MB;
+    const s64 classPenalty = item.isMovie ? MOVIE_PENALTY_MS : 0;
+    const s64 age =
+        static_cast<s64>(armTicksToNs(now - item.detectedTick) / 1'000'000ULL);
+    return classPenalty + sizePenalty - age;
+}
+}  // namespace
+
+u64 elapsedMs(u64 sinceTick) noexcept {
+    return armTicksToNs(Clock::get().tick() - sinceTick) / 1'000'000ULL;
+}
+
+bool UploadQueue::push(CaptureItem item) {
+    if (m_items.size() >= CAPACITY) {
+        return false;
+    }
+    m_items.push_back(std::move(item));
+    return true;
+}
+
+std::optional<CaptureItem> UploadQueue::pop() {
+    if (m_items.empty()) {
+        return std::nullopt;
+    }
+
+    const u64 now = Clock::get().tick();
+    // Ties go to the oldest capture so arrival order is kept within a class
+    const auto best = std::ranges::min_element(
+        m_items, [now](const CaptureItem& a, const CaptureItem& b) {
+            const s64 scoreA = priorityScore(a, now);
+            const s64 scoreB = priorityScore(b, now);
+            return scoreA != scoreB ? scoreA < scoreB : a.path < b.path;
+        });
+
+    CaptureItem item = std::move(*best);
+    m_items.erase(best);
+    return item;
+}
+
+size_t UploadQueue::takeScreenshots(std::vector<CaptureItem>& out,
+                                    size_t max) {
+    // Paths sort chronologically, so keep the queue ordered by path and
+    // take from the front
+    std::ranges::sort(m_items, {}, &CaptureItem::path);
+
+    size_t taken = 0;
+    std::erase_if(m_items, [&](CaptureItem& item) {
+        if (taken >= max || item.isMovie) return false;
+        out.push_back(std::move(item));
+        ++taken;
+        return true;
+    });
+    return taken;
+}
+
+void LatencyTracker::add(u64 latencyMs) noexcept {
+    m_samples[m_next] = latencyMs;
+    m_next = (m_next + 1) % WINDOW;
+    m_count = std::min(m_count + 1, WINDOW);
+}
+
+u64 LatencyTracker::median() const noexcept {
+    if (m_count == 0) {
+        return 0;
+    }
+
+    std::array<u64, WINDOW> sorted = m_samples;
+    const auto end = sorted.begin() + static_cast<std::ptrdiff_t>(m_count);
+    const auto mid = sorted.begin() + static_cast<std::ptrdiff_t>(m_count / 2);
+    std::nth_element(sorted.begin(), mid, end);
+    return *mid;
+}
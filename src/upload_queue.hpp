@@ -0,0 +1,63 @@
+#pragma once
+
+#include <switch.h>
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+// A detected capture waiting to be uploaded
+struct CaptureItem {
+    std::string path;
+    size_t size{0};
+    bool isMovie{false};
+    u64 detectedTick{0};
+};
+
+/**
+ * Bounded priority queue in front of the upload functions.
+ * Screenshots and small files are served first; every item ages while it
+ * waits so that large movies cannot be starved by a stream of screenshots.
+ */
+class UploadQueue {
+   public:
+    static constexpr size_t CAPACITY = 32;
+
+    UploadQueue() { m_items.reserve(CAPACITY); }
+
+    // Returns false when the queue is full
+    [[nodiscard]] bool push(CaptureItem item);
+    // Removes and returns the item with the highest priority
+    [[nodiscard]] std::optional<CaptureItem> pop();
+    // Moves up to `max` queued screenshots, oldest first, into `out`
+    size_t takeScreenshots(std::vector<CaptureItem>& out, size_t max);
+
+    [[nodiscard]] size_t size() const noexcept { return m_items.size(); }
+    [[nodiscard]] bool empty() const noexcept { return m_items.empty(); }
+    [[nodiscard]] size_t freeSlots() const noexcept {
+        return CAPACITY - m_items.size();
+    }
+
+   private:
+    std::vector<CaptureItem> m_items;
+};
+
+// Tracks recent capture-to-delivery latencies and reports their median
+class LatencyTracker {
+   public:
+    void add(u64 latencyMs) noexcept;
+    [[nodiscard]] u64 median() const noexcept;
+    [[nodiscard]] size_t count() const noexcept { return m_count; }
+
+   private:
+    static constexpr size_t WINDOW = 32;
+
+    std::array<u64, WINDOW> m_samples{};
+    size_t m_next{0};
+    size_t m_count{0};
+};
+
+// Milliseconds elapsed on the Clock since a CaptureItem was detected
+[[nodiscard]] u64 elapsedMs(u64 sinceTick) noexcept;
@@ -0,0 +1,103 @@
+#include "upload_stream.hpp"
+
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "crc32.hpp"
+#include "read_ahead.hpp"
+#include "utils.hpp"
+
+UploadInfo makeDigestField(const UploadInfo& source,
+                           std::string_view caption) {
+    UploadInfo field;
+    field.sizeLeft = DIGEST_FIELD_LENGTH;
+    if (!caption.empty()) {
+        field.sizeLeft += caption.size() + 1;
+    }
+    field.digestSource = &source;
+    field.caption = caption;
+    return field;
+}
+
+std::string digestText(const UploadInfo& ui) {
+    // Finalize a copy, the context keeps running until the upload ends
+    Sha256Context context = ui.sha256;
+    std::array<uint8_t, SHA256_HASH_SIZE> hash;
+    sha256ContextGetHash(&context, hash.data());
+
+    std::string text{DIGEST_FIELD_PREFIX};
+    text += hex_encode(hash);
+    return text;
+}
+
+size_t uploadReadFunction(void* ptr, size_t size, size_t nmemb,
+                          void* data) noexcept {
+    auto* ui = static_cast<UploadInfo*>(data);
+    const size_t maxBytes = size * nmemb;
+
+    if (maxBytes < 1 || ui->sizeLeft == 0) {
+        return 0;
+    }
+
+    if (ui->digestSource != nullptr) {
+        std::string text;
+        if (!ui->caption.empty()) {
+            text = ui->caption;
+            text += '\n';
+        }
+        text += digestText(*ui->digestSource);
+        const size_t offset = text.size() - ui->sizeLeft;
+        const size_t bytes = std::min(ui->sizeLeft, maxBytes);
+        std::memcpy(ptr, text.data() + offset, bytes);
+        ui->sizeLeft -= bytes;
+        return bytes;
+    }
+
+    size_t bytesToRead = std::min(ui->sizeLeft, maxBytes);
+    if (BandwidthLimiter::get().enabled()) {
+        bytesToRead =
+            BandwidthLimiter::get().tryAcquire(ui->trafficClass, bytesToRead);
+        if (bytesToRead == 0) {
+            return CURL_READFUNC_PAUSE;
+        }
+    }
+
+    // Movies are read ahead on the first read, when the file is positioned
+    if (ui->reads == 0 && ui->trafficClass == TrafficClass::Movie) {
+        ui->readAhead = ReadAhead::get().begin(ui->f, ui->sizeLeft);
+    }
+
+    const size_t bytesRead = ui->readAhead
+                                 ? ReadAhead::get().read(ptr, bytesToRead)
+                                 : std::fread(ptr, 1, bytesToRead, ui->f);
+    // Reads stop short at a read-ahead buffer seam or the end of the file,
+    // the tokens for the rest would otherwise be lost
+    if (bytesRead < bytesToRead && BandwidthLimiter::get().enabled()) {
+        BandwidthLimiter::get().refund(ui->trafficClass,
+                                       bytesToRead - bytesRead);
+    }
+    ui->sizeLeft -= bytesRead;
+    ++ui->reads;
+    // Fingerprint the content on the fly, no extra pass over the SD card
+    ui->crc = crc32c(ui->crc, ptr, bytesRead);
+    sha256ContextUpdate(&ui->sha256, ptr, bytesRead);
+    return bytesRead;
+}
+
+void stopReadAhead(UploadInfo& ui) {
+    if (ui.readAhead) {
+        ReadAhead::get().end();
+        ui.readAhead = false;
+    }
+}
+
+void finishDigest(UploadInfo& ui, ContentDigest* digest) noexcept {
+    if (digest != nullptr && ui.sizeLeft == 0) {
+        digest->crc32c = ui.crc;
+        sha256ContextGetHash(&ui.sha256, digest->sha256.data());
+        digest->valid = true;
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <switch.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "bandwidth.hpp"
+#include "upload.hpp"
+
+// Text of the trailing digest field: "sha256:" followed by 64 hex digits
+inline constexpr std::string_view DIGEST_FIELD_PREFIX = "sha256:";
+inline constexpr size_t DIGEST_FIELD_LENGTH =
+    DIGEST_FIELD_PREFIX.size() + SHA256_HASH_SIZE * 2;
+
+/**
+ * Body of an upload as curl pulls it through uploadReadFunction(): a file,
+ * read directly or through ReadAhead, or a form field carrying the digest
+ * of another upload. File content is fingerprinted while it streams.
+ */
+struct UploadInfo {
+    UploadInfo() = default;
+    UploadInfo(FILE* file, size_t size, TrafficClass cls) noexcept
+        : f(file), sizeLeft(size), trafficClass(cls) {
+        sha256ContextCreate(&sha256);
+    }
+
+    FILE* f{nullptr};
+    size_t sizeLeft{0};
+    TrafficClass trafficClass{TrafficClass::Screenshot};
+    uint32_t crc{0};
+    // Read callbacks served, each one is a copy of up to one upload buffer
+    uint32_t reads{0};
+    Sha256Context sha256{};
+    // Set for a form field that streams the digest of another upload
+    const UploadInfo* digestSource{nullptr};
+    // Text placed on its own line before the streamed digest
+    std::string_view caption;
+    // Data comes from the background reader, see ReadAhead
+    bool readAhead{false};
+};
+
+// Form field whose content is `caption` and the digest of `source`,
+// produced after the file part has been streamed
+[[nodiscard]] UploadInfo makeDigestField(const UploadInfo& source,
+                                         std::string_view caption = {});
+
+// "sha256:<hex>" of the bytes streamed so far
+[[nodiscard]] std::string digestText(const UploadInfo& ui);
+
+constexpr TrafficClass trafficClassOf(bool isMovie) noexcept {
+    return isMovie ? TrafficClass::Movie : TrafficClass::Screenshot;
+}
+
+// curl read callback for an UploadInfo. A throttled upload returns
+// CURL_READFUNC_PAUSE instead of waiting for tokens, so it never holds up
+// the other transfers on the connection; HttpSession resumes it.
+size_t uploadReadFunction(void* ptr, size_t size, size_t nmemb,
+                          void* data) noexcept;
+
+// Stop the background reader of an upload, before its file is closed
+void stopReadAhead(UploadInfo& ui);
+
+// Report the streamed digest once the whole file has been sent
+void finishDigest(UploadInfo& ui, ContentDigest* digest) noexcept;
@@ -1,5 +1,6 @@
 #include "utils.hpp"
 
+#include <malloc.h>
 #include <sys/stat.h>
 
 #include <algorithm>
@@ -15,42 +16,115 @@
 #include "logger.hpp"
 
 namespace {
-constexpr std::string_view ALBUM_PATH = "img:/";
+#ifdef ENABLE_TIME_FUNCTIONS
+// Work done by the current album scan. Per thread, the scanner, the
+// upload thread's backfill and the pull server scan at the same time.
+struct ScanStats {
+    size_t dirs{0};     // Directories listed
+    size_t entries{0};  // Directory entries visited
+    size_t items{0};    // Album items returned
+};
+thread_local ScanStats g_scanStats;
+
+void countDir() noexcept { ++g_scanStats.dirs; }
+void countEntry() noexcept { ++g_scanStats.entries; }
+void countItem() noexcept { ++g_scanStats.items; }
+
+// Times one album scan and logs it as a single key=value line, e.g.
+// [bench] scan=last_item ns=812345 dirs=4 entries=61 items=1
+// so results can be grepped from the log and compared between versions
+class ScanTimer {
+   public:
+    explicit ScanTimer(std::string_view name) noexcept
+        : m_name(name), m_start(std::chrono::steady_clock::now()) {
+        g_scanStats = {};
+    }
+
+    ~ScanTimer() {
+        const auto duration =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - m_start);
+        Logger::get().info()
+            << "[bench] scan=" << m_name << " ns=" << duration.count()
+            << " dirs=" << g_scanStats.dirs
+            << " entries=" << g_scanStats.entries
+            << " items=" << g_scanStats.items << endl;
+        Logger::get().close();
+    }
+
+   private:
+    std::string_view m_name;
+    std::chrono::steady_clock::time_point m_start;
+};
+#else
+constexpr void countDir() noexcept {}
+constexpr void countEntry() noexcept {}
+constexpr void countItem() noexcept {}
+#endif
 
 constexpr bool isDigitsOnly(std::string_view str) noexcept {
     return std::ranges::all_of(str,
                                [](char c) { return c >= '0' && c <= '9'; });
 }
 
-// Use template parameter to avoid lambda overhead, directly compare filename strings
+// Sorted names of digit-only directories with the expected length that are
+// not older than minName
 template <size_t ExpectedLen>
-[[nodiscard]] fs::path findMaxDir(const fs::path& dir) noexcept {
-    fs::path max_path;
-    std::string max_filename;
+[[nodiscard]] std::vector<std::string> listDirsFrom(const fs::path& dir,
+                                                    std::string_view minName) {
+    std::vector<std::string> names;
 
+    countDir();
     for (const auto& entry : fs::directory_iterator(dir)) {
+        countEntry();
         if (!entry.is_directory()) continue;
 
-        const auto& p = entry.path();
-        auto filename = p.filename().string();
+        auto filename = entry.path().filename().string();
 
-        if (filename.length() != ExpectedLen || !isDigitsOnly(filename))
+        if (filename.length() != ExpectedLen || !isDigitsOnly(filename) ||
+            filename < minName)
             continue;
 
-        if (filename > max_filename) {
-            max_filename = std::move(filename);
-            max_path = p;
-        }
+        names.push_back(std::move(filename));
     }
 
-    return max_path;
+    std::ranges::sort(names);
+    return names;
+}
+
+// Album position split into its year/month/day/file components.
+// All fields are empty when the path is not inside the album; the file is
+// empty for a bare day directory ("img:/YYYY/MM/DD/").
+struct AlbumPosition {
+    std::string_view year;
+    std::string_view month;
+    std::string_view day;
+    std::string_view file;
+};
+
+[[nodiscard]] AlbumPosition parseAlbumPosition(std::string_view path) noexcept {
+    // img:/YYYY/MM/DD/<file>
+    constexpr size_t fileOffset = ALBUM_PATH.size() + 11;
+    if (!path.starts_with(ALBUM_PATH) || path.size() < fileOffset ||
+        path[ALBUM_PATH.size() + 4] != '/' ||
+        path[ALBUM_PATH.size() + 7] != '/' ||
+        path[ALBUM_PATH.size() + 10] != '/') {
+        return {};
+    }
+
+    return AlbumPosition{path.substr(ALBUM_PATH.size(), 4),
+                         path.substr(ALBUM_PATH.size() + 5, 2),
+                         path.substr(ALBUM_PATH.size() + 8, 2),
+                         path.substr(fileOffset)};
 }
 
 [[nodiscard]] fs::path findMaxFileInDir(const fs::path& dir) noexcept {
     fs::path max_path;
     std::string max_filename;
 
+    countDir();
     for (const auto& entry : fs::directory_iterator(dir)) {
+        countEntry();
         if (!entry.is_regular_file()) continue;
 
         const auto& p = entry.path();
@@ -69,40 +143,96 @@ template <size_t ExpectedLen>
 
 std::expected<std::string, std::string> getLastAlbumItem() {
 #ifdef ENABLE_TIME_FUNCTIONS
-    const auto startTime = std::chrono::high_resolution_clock::now();
+    const ScanTimer timer{"last_item"};
 #endif
 
-    // 1. Find Year (Length 4, Directory)
-    const fs::path year = findMaxDir<4>(ALBUM_PATH);
-    if (year.empty())
-        return std::unexpected("No valid year directories in img:/");
-
-    // 2. Find Month (Length 2, Directory)
-    const fs::path month = findMaxDir<2>(year);
-    if (month.empty())
-        return std::unexpected("No valid month directories in " +
-                               year.string());
+    // Newest year, month and day, each taken as the largest name. Deleting
+    // captures leaves empty directories behind, so fall back to the next
+    // older one when a directory holds nothing.
+    const auto years = listDirsFrom<4>(ALBUM_PATH, "");
+    if (years.empty())
+        return std::unexpected("No valid year directories in " +
+                               std::string(ALBUM_PATH));
 
-    // 3. Find Day (Length 2, Directory)
-    const fs::path day = findMaxDir<2>(month);
-    if (day.empty())
-        return std::unexpected("No valid day directories in " + month.string());
-
-    // 4. Find File (Regular File)
-    const fs::path file = findMaxFileInDir(day);
-    if (file.empty())
-        return std::unexpected("No files found in " + day.string());
+    for (const auto& year : years | std::views::reverse) {
+        const fs::path yearPath = fs::path(ALBUM_PATH) / year;
+        for (const auto& month :
+             listDirsFrom<2>(yearPath, "") | std::views::reverse) {
+            const fs::path monthPath = yearPath / month;
+            for (const auto& day :
+                 listDirsFrom<2>(monthPath, "") | std::views::reverse) {
+                const fs::path file = findMaxFileInDir(monthPath / day);
+                if (!file.empty()) {
+                    countItem();
+                    return file.string();
+                }
+            }
+        }
+    }
+    return std::unexpected("No files found in " + std::string(ALBUM_PATH));
+}
 
+size_t collectNewAlbumItems(std::string_view after, size_t limit,
+                            std::vector<std::string>& out) {
 #ifdef ENABLE_TIME_FUNCTIONS
-    const auto endTime = std::chrono::high_resolution_clock::now();
-    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
-        endTime - startTime);
-    Logger::get().info() << "[getLastAlbumItem] Success " << " ("
-                         << duration.count() << "ns)" << endl;
-    Logger::get().close();
+    const ScanTimer timer{"new_items"};
 #endif
+    const AlbumPosition pos = parseAlbumPosition(after);
+    const size_t initialSize = out.size();
+    std::vector<std::string> files;
+
+    // Only walk directories that can hold items newer than `after`; the
+    // bounds apply while we are still on the path leading to it
+    for (const auto& year : listDirsFrom<4>(ALBUM_PATH, pos.year)) {
+        const fs::path yearPath = fs::path(ALBUM_PATH) / year;
+        const bool sameYear = year == pos.year;
+
+        for (const auto& month :
+             listDirsFrom<2>(yearPath, sameYear ? pos.month : "")) {
+            const fs::path monthPath = yearPath / month;
+            const bool sameMonth = sameYear && month == pos.month;
+
+            for (const auto& day :
+                 listDirsFrom<2>(monthPath, sameMonth ? pos.day : "")) {
+                const fs::path dayPath = monthPath / day;
+                const std::string_view minFile =
+                    sameMonth && day == pos.day ? pos.file : "";
+
+                // Keep only the oldest `remaining` names in a max-heap so
+                // memory is bounded by `limit`, not by the day's size
+                const size_t remaining = limit - (out.size() - initialSize);
+                if (remaining == 0) {
+                    return limit;
+                }
+                files.clear();
+                countDir();
+                for (const auto& entry : fs::directory_iterator(dayPath)) {
+                    countEntry();
+                    if (!entry.is_regular_file()) continue;
+
+                    auto filename = entry.path().filename().string();
+                    if (filename <= minFile) continue;
+
+                    if (files.size() < remaining) {
+                        files.push_back(std::move(filename));
+                        std::ranges::push_heap(files);
+                    } else if (filename < files.front()) {
+                        std::ranges::pop_heap(files);
+                        files.back() = std::move(filename);
+                        std::ranges::push_heap(files);
+                    }
+                }
+                std::ranges::sort_heap(files);
+
+                for (const auto& file : files) {
+                    out.push_back((dayPath / file).string());
+                    countItem();
+                }
+            }
+        }
+    }
 
-    return file.string();
+    return out.size() - initialSize;
 }
 
 size_t filesize(std::string_view path) {
@@ -136,4 +266,20 @@ std::string url_encode(std::string_view value) {
     }
 
     return result;
-}
\ No newline at end of file
+}
+
+std::string hex_encode(std::span<const uint8_t> bytes) {
+    constexpr std::string_view hexChars = "0123456789abcdef";
+
+    std::string result;
+    result.reserve(bytes.size() * 2);
+    for (const uint8_t b : bytes) {
+        result.push_back(hexChars[b >> 4]);
+        result.push_back(hexChars[b & 0x0F]);
+    }
+    return result;
+}
+
+size_t heapInUse() {
+    return mallinfo().uordblks;
+}
@@ -1,12 +1,31 @@
 #pragma once
 
+#include <cstdint>
 #include <expected>
 #include <filesystem>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace fs = std::filesystem;
 
+// Mount point of the capture album, laid out as YYYY/MM/DD/<file>. Host
+// builds may point it elsewhere.
+#ifndef ALBUM_ROOT
+#define ALBUM_ROOT "img:/"
+#endif
+inline constexpr std::string_view ALBUM_PATH = ALBUM_ROOT;
+
 [[nodiscard]] std::expected<std::string, std::string> getLastAlbumItem();
+// Append album items newer than `after` to `out` in chronological order,
+// stopping after `limit` items. `after` may also be a day directory
+// ("img:/YYYY/MM/DD/") to start with that day's first item. Returns the
+// number of items appended.
+size_t collectNewAlbumItems(std::string_view after, size_t limit,
+                            std::vector<std::string>& out);
 [[nodiscard]] size_t filesize(std::string_view path);
 [[nodiscard]] std::string url_encode(std::string_view value);
+[[nodiscard]] std::string hex_encode(std::span<const uint8_t> bytes);
+// Bytes currently allocated from the heap
+[[nodiscard]] size_t heapInUse();